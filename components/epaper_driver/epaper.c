@@ -2,7 +2,7 @@
  * @file epaper.c
  * @author liying (respire_ly@qq.com)
  * @brief 墨水屏硬件驱动
- * @version 1.0
+ * @version 1.6
  * @date 2025-04-17
  * 
  * @copyright Copyright (c) 2025  freelance
@@ -11,52 +11,49 @@
  * | Date | Version | Author | Description |
  * | --- | --- | --- | --- |
  * | 2025-04-17 | 1.0 | liying | 墨水屏硬件驱动 |
+ * | 2026-10-18 | 1.1 | liying | 总线读写改由 epaper_bus 实现，支持SPI+DMA |
+ * | 2026-10-18 | 1.2 | liying | 局部窗口上传和局部刷新 |
+ * | 2026-10-18 | 1.3 | liying | RAM有效标志放在RTC内存，深度睡眠唤醒后仍可只上传窗口 |
+ * | 2026-10-18 | 1.4 | liying | 颜色转换查表，窗口数据双缓冲发送 |
+ * | 2026-10-18 | 1.5 | liying | 复位时清除RAM有效标志，不再放在RTC内存 |
+ * | 2026-10-18 | 1.6 | liying | 去掉局部窗口上传和局部刷新：每次刷新后屏幕都深度睡眠，控制器RAM里从来没有上一帧 |
  */
 
 #include "epaper.h"   
+#include <inttypes.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+
+static const char *TAG = "EPD";
 
 /**
  * @brief 函数功能：初始化 GPIO 引脚，为后续墨水屏操作做准备
- * @details 函数实现：BUSY引脚是输入引脚，其余均为输出引脚
+ * @details 函数实现：引脚和总线（SPI+DMA 或 GPIO 模拟时序）交给 epaper_bus 初始化
  */
 void EPD_GPIOInit()
 {  
-    gpio_config_t io_conf = {};
-
-    io_conf.pin_bit_mask =  1ULL << GPIO_BUSY;
-    io_conf.mode = GPIO_MODE_INPUT;
-    gpio_config(&io_conf);
-
-    io_conf.pin_bit_mask =  (1ULL << GPIO_RST) | (1ULL << GPIO_DC) | (1ULL << GPIO_CS) | (1ULL << GPIO_SCL) | (1ULL << GPIO_SDA);
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    gpio_config(&io_conf);
-
+    EPD_BUS_PINS pins = {
+        .busy = GPIO_BUSY,
+        .rst  = GPIO_RST,
+        .dc   = GPIO_DC,
+        .cs   = GPIO_CS,
+        .scl  = GPIO_SCL,
+        .sda  = GPIO_SDA,
+    };
+
+    EPD_Bus_Init(&pins);
 }    
 
 /**
  * @brief 函数功能：向总线上写入一个字节的数据
- * @details 函数实现：首先拉低CS，从最高位开始逐个发送8位数据，墨水屏采集数据的时机是SCL上升沿，最后拉高CS
+ * @details 函数实现：不改变DC，SPI+DMA 或 GPIO 模拟时序由 menuconfig 选择
  * 
  * @param dat 需要写入的字节数据
  */
 void EPD_WR_Bus(uint8_t dat)
 {
-	uint8_t i;
-
-	EPD_CS_Clr();           // 拉低CS
-
-	for(i=0;i<8;i++){       // 1个字节的8个位，从最高位开始传输
-		EPD_SCL_Clr();        // 时钟SCL拉低
-		if(dat&0x80){         // 显示数据SDA
-			EPD_SDA_Set();      
-		}else{
-			EPD_SDA_Clr();
-		}
-		EPD_SCL_Set();        // 制造SCL上升沿
-		dat<<=1;
-	}
-
-	EPD_CS_Set();	          // 拉高CS
+	EPD_Bus_WriteData(&dat, 1);
 }
 
 /**
@@ -67,9 +64,7 @@ void EPD_WR_Bus(uint8_t dat)
  */
 void EPD_WR_REG(uint8_t reg)
 {
-	EPD_DC_Clr();
-	EPD_WR_Bus(reg);
-	EPD_DC_Set();
+	EPD_Bus_WriteCmd(reg);
 }
 
 /**
@@ -80,38 +75,36 @@ void EPD_WR_REG(uint8_t reg)
  */
 void EPD_WR_DATA8(uint8_t dat)
 {
-	EPD_DC_Set();
-	EPD_WR_Bus(dat);
-	EPD_DC_Set();       // 其实这句是可以省略的，但是对应上面写指令的代码，没有去掉
+	EPD_Bus_WriteData(&dat, 1);
 }
 
-/*
-// 在尝试使用esp_rom_delay_us和任务看门狗的时候引入的头文件
-#include "esp_rom_sys.h"
-#include "esp_task_wdt.h"
-*/
+/**
+ * @brief 函数功能：向墨水屏连续写入 len 个字节的数据-Parameter
+ * @details 函数实现：整块交给总线，SPI+DMA时只需要几次大传输
+ * 
+ * @param dat 数据
+ * @param len 字节数
+ */
+void EPD_WR_DATA(const uint8_t *dat, uint32_t len)
+{
+	EPD_Bus_WriteData(dat, len);
+}
 
 /**
  * @brief 函数功能：读取并等待墨水屏的忙碌状态
- * @details 函数实现：读取BUSY线的状态，BUSY为低电平代表忙碌，使用vTaskDelay非阻塞等待
+ * @details 函数实现：BUSY为低电平代表忙碌。等待由BUSY中断唤醒（见 EPD_Bus_WaitIdle），
+ * 控制器一空闲就返回，等待期间任务阻塞不占CPU；超时时间 CONFIG_EPD_BUSY_TIMEOUT_MS
  */
 void EPD_READBUSY(void)
 {
-  while(1)
-  {
-    if(gpio_get_level(GPIO_BUSY)==1)
-    {
-      break;
-    }
-    //esp_rom_delay_us(5);    //报错，任务看门狗超时，不过是可以正常显示，运行程序的，每隔5秒报错任务看门狗（空闲线程的）超时，但是系统不会重启。
+  uint32_t waited_ms;
 
-    //esp_rom_delay_us(5);
-    //esp_task_wdt_reset();   // 不可以，喂的是自家的狗，在这里阻塞喂狗了，其他线程的看门狗还饿着
-  
-    //vTaskDelay(1 / portTICK_PERIOD_MS);   //1ms~5ms仍然是上面的现象  
-
-    vTaskDelay(10 / portTICK_PERIOD_MS);    //10ms就正常了
+  if(EPD_Bus_WaitIdle(1, CONFIG_EPD_BUSY_TIMEOUT_MS, &waited_ms)!=ESP_OK)
+  {
+    ESP_LOGW(TAG, "BUSY timeout after %" PRIu32 " ms", waited_ms);
+    return;
   }
+  ESP_LOGD(TAG, "BUSY released after %" PRIu32 " ms", waited_ms);
 }
 
 /**
@@ -121,9 +114,9 @@ void EPD_READBUSY(void)
 void EPD_HW_RESET(void)
 {
   vTaskDelay(100 / portTICK_PERIOD_MS);
-  EPD_RES_Clr();
+  EPD_Bus_SetRST(0);
   vTaskDelay(10 / portTICK_PERIOD_MS);
-  EPD_RES_Set();
+  EPD_Bus_SetRST(1);
   vTaskDelay(10 / portTICK_PERIOD_MS);
   EPD_READBUSY();
 }
@@ -135,13 +128,46 @@ void EPD_HW_RESET(void)
  * 2、Dispaly Refresh,R12=0x00
  */
 void EPD_Update(void)
+{
+  EPD_Update_Async();
+  EPD_Update_Wait(CONFIG_EPD_BUSY_TIMEOUT_MS);
+}
+
+/**
+ * @brief 函数功能：启动刷新后立即返回，不等待刷新完成
+ * @details 函数实现：\n
+ * 1、Power ON，R04，等待BUSY（很短） \n
+ * 2、Dispaly Refresh,R12=0x00，开始监听BUSY后返回 \n
+ * 刷新完成时 EPD_Bus_IdleEventGroup() 的 EPD_BUS_IDLE_BIT 被置位，调用者可以先去做别的事，
+ * 再用 EPD_Update_Wait 或直接等待事件位
+ */
+void EPD_Update_Async(void)
 {
   EPD_WR_REG(0x04);   //Power ON，R04
   EPD_READBUSY();
 
   EPD_WR_REG(0x12);   //Dispaly Refresh，R12=0x00
   EPD_WR_DATA8(0x00);
-  EPD_READBUSY();
+  EPD_Bus_StartIdleNotify(1);
+}
+
+/**
+ * @brief 函数功能：等待 EPD_Update_Async 启动的刷新完成
+ * @param timeout_ms 超时时间
+ * @return esp_err_t ESP_OK，超时返回 ESP_ERR_TIMEOUT
+ */
+esp_err_t EPD_Update_Wait(uint32_t timeout_ms)
+{
+  uint32_t waited_ms;
+  esp_err_t ret = EPD_Bus_WaitIdleNotify(timeout_ms, &waited_ms);
+
+  if(ret!=ESP_OK)
+  {
+    ESP_LOGW(TAG, "refresh not finished after %" PRIu32 " ms", waited_ms);
+    return ret;
+  }
+  ESP_LOGI(TAG, "refresh finished in %" PRIu32 " ms", waited_ms);
+  return ESP_OK;
 }
 
 /**
@@ -251,8 +277,6 @@ void EPD_Init(void)
  */
 void EPD_Display_Fill(uint8_t dat)
 {
-  uint16_t i;
-
   EPD_WR_REG(0x10);       // 开始填充数据到SRAM
 
   switch(dat)             // 设置填充颜色
@@ -272,15 +296,13 @@ void EPD_Display_Fill(uint8_t dat)
     default:
     break;
   }  
-  for(i=0;i<(EPD_W*EPD_H/4);i++)  // 一个字节可以传输4个像素的内容
-  {
-    EPD_WR_DATA8(dat);
-  }  
+  EPD_Bus_FillData(dat, EPD_W*EPD_H/4);   // 一个字节可以传输4个像素的内容
 }
 
 /**
  * @brief 函数功能：进行颜色转换，将输入颜色转换为特定格式
- * @details 函数实现：没必要，在定义宏的时候其实已经相当于转换了
+ * @details 函数实现：没必要，在定义宏的时候其实已经相当于转换了。
+ * 发送画布时不逐像素调用，用的是按同样映射生成的整字节转换表（见 EPD_ColorConvert）
  * 
  * @param color 颜色
  * @return uint8_t 转换后的颜色
@@ -308,36 +330,62 @@ uint8_t Color_Conversion(uint8_t color)
    return datas;
 }
 
+#if !EPD_COLOR_IDENTITY
+/** 一个画布字节（4个像素）到控制器字节的转换表，编译时按 Color_Conversion 的映射生成 */
+#define EPD_COLOR_MAP(c)   ((c)==0?BLACK:(c)==1?WHITE:(c)==2?YELLOW:RED)
+#define EPD_LUT1(b)        (EPD_COLOR_MAP(((b)>>6)&3)<<6|EPD_COLOR_MAP(((b)>>4)&3)<<4|EPD_COLOR_MAP(((b)>>2)&3)<<2|EPD_COLOR_MAP((b)&3))
+#define EPD_LUT4(b)        EPD_LUT1(b),EPD_LUT1((b)+1),EPD_LUT1((b)+2),EPD_LUT1((b)+3)
+#define EPD_LUT16(b)       EPD_LUT4(b),EPD_LUT4((b)+4),EPD_LUT4((b)+8),EPD_LUT4((b)+12)
+#define EPD_LUT64(b)       EPD_LUT16(b),EPD_LUT16((b)+16),EPD_LUT16((b)+32),EPD_LUT16((b)+48)
+static const DRAM_ATTR uint8_t s_color_lut[256] = {EPD_LUT64(0),EPD_LUT64(64),EPD_LUT64(128),EPD_LUT64(192)};
+#endif
+
+/**
+ * @brief 函数功能：把画布数据转换成控制器的颜色格式
+ * @details 函数实现：颜色定义与控制器一致时直接拷贝，否则每字节查一次表，不再逐像素 switch
+ *
+ * @param dst 目标，DMA暂存缓冲区
+ * @param src 画布数据
+ * @param n 字节数
+ */
+static inline void EPD_ColorConvert(uint8_t *dst, const uint8_t *src, uint32_t n)
+{
+#if EPD_COLOR_IDENTITY
+  memcpy(dst,src,n);
+#else
+  while(n--) *dst++=s_color_lut[*src++];
+#endif
+}
+
 /**
  * @brief 函数功能：在墨水屏上显示画布内容
+ * @details 函数实现：\n
+ * 颜色定义与控制器一致时画布不需要转换，整块交给总线，画布在DMA可访问的内存里时一个事务发完；\n
+ * 否则按暂存缓冲区大小分块查表转换，两块缓冲区轮流使用，转换下一块时上一块正在DMA发送
  * 
  * @param image 画布数据
  */
 void EPD_Display(const uint8_t *image)
 {
-  uint8_t data_H1,data_H2,data_L1,data_L2,data,temp;
-  uint16_t i,j,Width,Height;
+  uint32_t total;
+  uint16_t Width;
 
   Width=(EPD_W%4==0)?(EPD_W/4):(EPD_W/4+1); // EPD_W=180，180/4=45
-  Height=EPD_H;
+  total=(uint32_t)Width*EPD_H;
 
   EPD_WR_REG(0x10);                   // 开始写入数据到SRAM的指令
-
-  for (j=0;j<Height;j++) 
+#if EPD_COLOR_IDENTITY
+  EPD_WR_DATA(image,total);
+#else
+  while(total>0)
   {
-    for (i=0;i<Width;i++) 
-    {
-      temp=image[i+j*Width];          // 取出image的某一个字节数据，8位，每2位代表一个像素的颜色，刚好4个像素
-      data_H1=Color_Conversion(temp>>6&0x03)<<6;      
-      data_H2=Color_Conversion(temp>>4&0x03)<<4;
-      data_L1=Color_Conversion(temp>>2&0x03)<<2;
-      data_L2=Color_Conversion(temp&0x03);
-      data=data_H1|data_H2|data_L1|data_L2;
-      EPD_WR_DATA8(data);             // 发送4个像素的内容
-    }
+    uint32_t n=total>EPD_BUS_CHUNK_SIZE?EPD_BUS_CHUNK_SIZE:total;
+
+    EPD_ColorConvert(EPD_Bus_StreamBuffer(),image,n);
+    EPD_Bus_StreamSend(n);            // 排队发送，立即返回
+    image+=n;
+    total-=n;
   }
+  EPD_Bus_StreamFlush();
+#endif
 }
-
-
-
-
@@ -2,7 +2,7 @@
  * @file epaper.h
  * @author liying (respire_ly@qq.com)
  * @brief 墨水屏硬件驱动
- * @version 1.0
+ * @version 1.4
  * @date 2025-04-17
  * 
  * @copyright Copyright (c) 2025  freelance
@@ -11,6 +11,10 @@
  * | Date | Version | Author | Description |
  * | --- | --- | --- | --- |
  * | 2025-04-17 | 1.0 | liying | 墨水屏硬件驱动 |
+ * | 2026-10-18 | 1.1 | liying | 总线读写改由 epaper_bus 实现，支持SPI+DMA |
+ * | 2026-10-18 | 1.2 | liying | 局部窗口上传和局部刷新 |
+ * | 2026-10-18 | 1.3 | liying | 颜色转换改为查表，颜色定义与控制器一致时不转换 |
+ * | 2026-10-18 | 1.4 | liying | 去掉局部窗口上传和局部刷新 |
  */
 
 #ifndef EPAPER_H
@@ -21,7 +25,7 @@
 #include "sdkconfig.h"   
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"    
-#include "driver/gpio.h" 
+#include "epaper_bus.h"
 
 
 
@@ -32,16 +36,7 @@
 #define GPIO_SCL    18
 #define GPIO_SDA    19     
 
-#define EPD_SCL_Clr() 	gpio_set_level(GPIO_SCL, 0);
-#define EPD_SCL_Set() 	gpio_set_level(GPIO_SCL, 1);
-#define EPD_SDA_Clr() 	gpio_set_level(GPIO_SDA, 0);
-#define EPD_SDA_Set() 	gpio_set_level(GPIO_SDA, 1);
-#define EPD_RES_Clr() 	gpio_set_level(GPIO_RST, 0);
-#define EPD_RES_Set() 	gpio_set_level(GPIO_RST, 1);
-#define EPD_DC_Clr() 	gpio_set_level(GPIO_DC, 0);
-#define EPD_DC_Set() 	gpio_set_level(GPIO_DC, 1);
-#define EPD_CS_Clr() 	gpio_set_level(GPIO_CS, 0);  
-#define EPD_CS_Set() 	gpio_set_level(GPIO_CS, 1);   
+// 引脚电平的读写都在 epaper_bus.c 里，SPI+DMA 或 GPIO 模拟时序由 menuconfig 选择
 
 
 
@@ -54,6 +49,9 @@
 #define YELLOW 0x02
 #define RED    0x03
 
+// 画布颜色值与控制器颜色值相同时 Color_Conversion 是恒等映射，发送画布不需要转换
+#define EPD_COLOR_IDENTITY  (BLACK == 0 && WHITE == 1 && YELLOW == 2 && RED == 3)
+
 
 
 //================函数声明=======================
@@ -70,6 +68,9 @@ void EPD_WR_REG(uint8_t reg);
 //向墨水屏写入 8 位数据-Parameter
 void EPD_WR_DATA8(uint8_t dat);
 
+//向墨水屏连续写入 len 个字节的数据-Parameter
+void EPD_WR_DATA(const uint8_t *dat, uint32_t len);
+
 //读取并等待墨水屏的忙碌状态
 void EPD_READBUSY(void);
 
@@ -79,6 +80,12 @@ void EPD_HW_RESET(void);
 //更新墨水屏显示内容
 void EPD_Update(void);
 
+//启动刷新后立即返回，完成时置位 EPD_BUS_IDLE_BIT
+void EPD_Update_Async(void);
+
+//等待 EPD_Update_Async 启动的刷新完成
+esp_err_t EPD_Update_Wait(uint32_t timeout_ms);
+
 //使墨水屏进入深度睡眠模式以节省功耗
 void EPD_DeepSleep(void);
 
@@ -0,0 +1,595 @@
+/**
+ * @file epaper_bus.c
+ * @author liying (respire_ly@qq.com)
+ * @brief 墨水屏数据总线：硬件SPI+DMA、GPIO模拟时序、主机Mock三种实现
+ * @version 1.4
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 墨水屏数据总线 |
+ * | 2026-10-18 | 1.1 | liying | BUSY改为事件组通知，支持异步刷新 |
+ * | 2026-10-18 | 1.2 | liying | 双暂存缓冲区，填写一块时另一块在DMA发送 |
+ * | 2026-10-18 | 1.3 | liying | BUSY中断在总线初始化时安装，失败时返回错误码并退回轮询 |
+ * | 2026-10-18 | 1.4 | liying | Mock 等待空闲时不使用超时时间，去掉未使用参数的警告 |
+ */
+
+#include "epaper_bus.h"
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#if CONFIG_EPD_BUS_SPI || CONFIG_EPD_BUS_BITBANG
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#endif
+
+#if CONFIG_EPD_BUS_SPI
+#include "driver/spi_master.h"
+#include "esp_memory_utils.h"
+#elif CONFIG_EPD_BUS_MOCK
+#include <stdlib.h>
+#endif
+
+static const char *TAG = "epd_bus";
+
+/** 当前使用的引脚 */
+static EPD_BUS_PINS s_pins;
+
+/** DMA暂存缓冲区，放在内部RAM，4字节对齐。两块轮流使用，一块在DMA发送时CPU填写另一块 */
+static DMA_ATTR uint8_t s_tx_buf[2][EPD_BUS_CHUNK_SIZE];
+/** 下一块可以填写的暂存缓冲区 */
+static uint8_t s_stream_idx = 0;
+
+#if CONFIG_EPD_BUS_SPI || CONFIG_EPD_BUS_BITBANG
+/**
+ * @brief 函数功能：GPIO初始化
+ * @details 函数实现：BUSY引脚是输入引脚，RES、DC是输出引脚；模拟时序时CS、SCL、SDA也是输出引脚
+ */
+static void EPD_Bus_GPIOInit(void)
+{
+    gpio_config_t io_conf = {};
+
+    io_conf.pin_bit_mask =  1ULL << s_pins.busy;
+    io_conf.mode = GPIO_MODE_INPUT;
+    gpio_config(&io_conf);
+
+    io_conf.pin_bit_mask =  (1ULL << s_pins.rst) | (1ULL << s_pins.dc);
+#if CONFIG_EPD_BUS_BITBANG
+    io_conf.pin_bit_mask |= (1ULL << s_pins.cs) | (1ULL << s_pins.scl) | (1ULL << s_pins.sda);
+#endif
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    gpio_config(&io_conf);
+}
+
+void EPD_Bus_SetRST(uint8_t level)
+{
+    gpio_set_level(s_pins.rst, level);
+}
+
+int EPD_Bus_ReadBusy(void)
+{
+    return gpio_get_level(s_pins.busy);
+}
+
+/** BUSY中断安装失败时轮询的间隔，毫秒 */
+#define EPD_BUS_POLL_MS  10
+
+/** BUSY空闲事件组，EPD_BUS_IDLE_BIT 由中断置位 */
+static EventGroupHandle_t s_busy_events = NULL;
+static bool s_busy_isr_added = false;
+static int64_t s_busy_start_us = 0;
+/** 正在等待的空闲电平，轮询时使用 */
+static int s_busy_idle_level = 1;
+
+/**
+ * @brief 函数功能：BUSY中断服务函数
+ * @details 函数实现：BUSY使用电平中断，进中断先关掉，避免电平保持期间反复进中断，然后置位空闲事件
+ */
+static void EPD_Bus_BusyISR(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    gpio_intr_disable(s_pins.busy);
+    xEventGroupSetBitsFromISR(s_busy_events, EPD_BUS_IDLE_BIT, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief 函数功能：安装BUSY中断，总线初始化时调用
+ * @details 函数实现：失败时不中止，之后等待BUSY改为每 EPD_BUS_POLL_MS 轮询一次，刷新照常进行
+ *
+ * @return esp_err_t ESP_OK，中断服务安装失败、内存不足返回对应错误码
+ */
+static esp_err_t EPD_Bus_IdleNotifyInit(void)
+{
+    esp_err_t err;
+
+    if (s_busy_isr_added) {
+        return ESP_OK;
+    }
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {   // 已被别的模块安装过也可以用
+        ESP_LOGW(TAG, "install gpio isr service failed: %s, poll BUSY", esp_err_to_name(err));
+        return err;
+    }
+    if (!s_busy_events) {
+        s_busy_events = xEventGroupCreate();
+        if (!s_busy_events) {
+            ESP_LOGW(TAG, "create busy event group failed, poll BUSY");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    gpio_intr_disable(s_pins.busy);
+    err = gpio_isr_handler_add(s_pins.busy, EPD_Bus_BusyISR, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "add busy isr failed: %s, poll BUSY", esp_err_to_name(err));
+        return err;
+    }
+    s_busy_isr_added = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief 函数功能：开始监听BUSY，变为空闲电平时置位 EPD_BUS_IDLE_BIT，不阻塞
+ * @details 函数实现：已经空闲直接置位；否则打开“空闲电平”触发的中断。用电平而不是边沿触发，
+ * 打开中断前BUSY刚好变化也不会错过；开启电源管理时同时作为light sleep的GPIO唤醒源。
+ * 中断没有安装时只记下空闲电平，由 EPD_Bus_WaitIdleNotify 轮询
+ *
+ * @param idle_level 空闲时BUSY的电平，4色屏为1，SSD1680为0
+ * @return esp_err_t ESP_OK
+ */
+esp_err_t EPD_Bus_StartIdleNotify(int idle_level)
+{
+    gpio_int_type_t level = idle_level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL;
+
+    s_busy_idle_level = idle_level;
+    s_busy_start_us = esp_timer_get_time();
+    if (!s_busy_isr_added) {
+        if (s_busy_events) {
+            xEventGroupClearBits(s_busy_events, EPD_BUS_IDLE_BIT);
+        }
+        return ESP_OK;
+    }
+
+    gpio_intr_disable(s_pins.busy);
+    xEventGroupClearBits(s_busy_events, EPD_BUS_IDLE_BIT);
+
+    if (gpio_get_level(s_pins.busy) == idle_level) {
+        xEventGroupSetBits(s_busy_events, EPD_BUS_IDLE_BIT);
+        return ESP_OK;
+    }
+
+    gpio_set_intr_type(s_pins.busy, level);
+#if CONFIG_PM_ENABLE
+    gpio_wakeup_enable(s_pins.busy, level);     // 刷新期间CPU可以进入light sleep
+    esp_sleep_enable_gpio_wakeup();
+#endif
+    gpio_intr_enable(s_pins.busy);
+    return ESP_OK;
+}
+
+/**
+ * @brief 函数功能：没有BUSY中断时轮询等待空闲
+ * @return esp_err_t ESP_OK，超时返回 ESP_ERR_TIMEOUT
+ */
+static esp_err_t EPD_Bus_PollIdle(uint32_t timeout_ms)
+{
+    while (gpio_get_level(s_pins.busy) != s_busy_idle_level) {
+        if ((esp_timer_get_time() - s_busy_start_us) / 1000 >= timeout_ms) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(EPD_BUS_POLL_MS));
+    }
+    if (s_busy_events) {
+        xEventGroupSetBits(s_busy_events, EPD_BUS_IDLE_BIT);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 函数功能：等待 EPD_Bus_StartIdleNotify 开始的监听完成
+ *
+ * @param timeout_ms 超时时间
+ * @param waited_ms  从开始监听到空闲（或超时）的时间，可为NULL
+ * @return esp_err_t ESP_OK，超时返回 ESP_ERR_TIMEOUT
+ */
+esp_err_t EPD_Bus_WaitIdleNotify(uint32_t timeout_ms, uint32_t *waited_ms)
+{
+    EventBits_t bits;
+
+    if (!s_busy_isr_added) {
+        esp_err_t ret = EPD_Bus_PollIdle(timeout_ms);
+        if (waited_ms) {
+            *waited_ms = (uint32_t)((esp_timer_get_time() - s_busy_start_us) / 1000);
+        }
+        return ret;
+    }
+
+    bits = xEventGroupWaitBits(s_busy_events, EPD_BUS_IDLE_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    gpio_intr_disable(s_pins.busy);
+#if CONFIG_PM_ENABLE
+    gpio_wakeup_disable(s_pins.busy);
+#endif
+
+    if (waited_ms) {
+        *waited_ms = (uint32_t)((esp_timer_get_time() - s_busy_start_us) / 1000);
+    }
+    return (bits & EPD_BUS_IDLE_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief 函数功能：等待BUSY变为空闲电平
+ * @details 函数实现：任务阻塞在事件组上，由BUSY中断唤醒，控制器一空闲就返回，不再每10ms轮询一次；
+ * 中断安装失败时退回轮询
+ *
+ * @param idle_level 空闲时BUSY的电平，4色屏为1，SSD1680为0
+ * @param timeout_ms 超时时间
+ * @param waited_ms  实际等待的时间，可为NULL
+ * @return esp_err_t ESP_OK，超时返回 ESP_ERR_TIMEOUT
+ */
+esp_err_t EPD_Bus_WaitIdle(int idle_level, uint32_t timeout_ms, uint32_t *waited_ms)
+{
+    esp_err_t ret = EPD_Bus_StartIdleNotify(idle_level);
+
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return EPD_Bus_WaitIdleNotify(timeout_ms, waited_ms);
+}
+
+EventGroupHandle_t EPD_Bus_IdleEventGroup(void)
+{
+    return s_busy_events;
+}
+#endif
+
+#if CONFIG_EPD_BUS_SPI
+//================硬件SPI+DMA=======================
+
+#define EPD_BUS_SPI_HOST  SPI2_HOST
+
+static spi_device_handle_t s_spi = NULL;
+
+/** 排队发送的暂存缓冲区事务，与 s_tx_buf 一一对应 */
+static spi_transaction_t s_stream_trans[2];
+/** 已排队、尚未取回结果的事务数 */
+static uint8_t s_stream_inflight = 0;
+
+esp_err_t EPD_Bus_Init(const EPD_BUS_PINS *pins)
+{
+    esp_err_t ret;
+
+    s_pins = *pins;
+    EPD_Bus_GPIOInit();
+    ret = EPD_Bus_IdleNotifyInit();
+
+    if (s_spi) {            // 深度睡眠唤醒前只初始化一次，重复调用只重新配置GPIO
+        return ret;
+    }
+
+    spi_bus_config_t buscfg = {
+        .mosi_io_num = s_pins.sda,
+        .miso_io_num = -1,              // 只写不读
+        .sclk_io_num = s_pins.scl,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = EPD_BUS_MAX_TRANSFER,
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(EPD_BUS_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO));
+
+    spi_device_interface_config_t devcfg = {
+        .mode = 0,                      // SCL空闲低电平，上升沿采样，与原来的模拟时序一致
+        .clock_speed_hz = CONFIG_EPD_SPI_CLOCK_HZ,
+        .spics_io_num = s_pins.cs,
+        .queue_size = 2,
+    };
+    ESP_ERROR_CHECK(spi_bus_add_device(EPD_BUS_SPI_HOST, &devcfg, &s_spi));
+
+    ESP_LOGI(TAG, "SPI bus ready, %d Hz", CONFIG_EPD_SPI_CLOCK_HZ);
+    return ret;
+}
+
+/**
+ * @brief 函数功能：发送一段数据，DC电平由调用者设置
+ * @details 函数实现：不超过4字节的用事务自带的tx_data轮询发送，省去DMA设置；更长的交给DMA
+ */
+static void EPD_Bus_SPI_Send(const uint8_t *data, size_t len)
+{
+    spi_transaction_t t = {};
+
+    EPD_Bus_StreamFlush();      // 排队的事务没发完时不能轮询发送，DC也不能变
+    t.length = len * 8;
+    if (len <= 4) {
+        t.flags = SPI_TRANS_USE_TXDATA;
+        memcpy(t.tx_data, data, len);
+        ESP_ERROR_CHECK(spi_device_polling_transmit(s_spi, &t));
+    } else {
+        t.tx_buffer = data;
+        ESP_ERROR_CHECK(spi_device_transmit(s_spi, &t));
+    }
+}
+
+void EPD_Bus_WriteCmd(uint8_t cmd)
+{
+    EPD_Bus_StreamFlush();          // 排队的数据发完才能拉低DC
+    gpio_set_level(s_pins.dc, 0);
+    EPD_Bus_SPI_Send(&cmd, 1);
+    gpio_set_level(s_pins.dc, 1);
+}
+
+/**
+ * @brief 函数功能：连续写数据-Parameter
+ * @details 函数实现：数据本身在DMA可访问的内存且4字节对齐时直接发送，一个事务最多 EPD_BUS_MAX_TRANSFER 字节；
+ * 否则（比如放在flash里的常量图片）按 EPD_BUS_CHUNK_SIZE 分块拷贝到两块暂存缓冲区轮流排队发送，
+ * 拷贝下一块时上一块正在DMA发送
+ */
+void EPD_Bus_WriteData(const uint8_t *data, size_t len)
+{
+    gpio_set_level(s_pins.dc, 1);   // 排队中的也是数据，DC本来就是高
+    while (len > 0) {
+        size_t n;
+
+        if (len <= 4 || data == s_tx_buf[0] || data == s_tx_buf[1] ||
+            (esp_ptr_dma_capable(data) && (((uintptr_t)data | len) & 3) == 0)) {
+            n = len > EPD_BUS_MAX_TRANSFER ? EPD_BUS_MAX_TRANSFER : len;
+            EPD_Bus_SPI_Send(data, n);
+        } else {
+            n = len > EPD_BUS_CHUNK_SIZE ? EPD_BUS_CHUNK_SIZE : len;
+            memcpy(EPD_Bus_StreamBuffer(), data, n);
+            EPD_Bus_StreamSend(n);
+        }
+        data += n;
+        len -= n;
+    }
+    EPD_Bus_StreamFlush();
+}
+
+uint8_t *EPD_Bus_StreamBuffer(void)
+{
+    spi_transaction_t *r;
+
+    if (s_stream_inflight == 2) {   // 两块都在排队，最早排队的就是要填写的这一块，等它发完
+        ESP_ERROR_CHECK(spi_device_get_trans_result(s_spi, &r, portMAX_DELAY));
+        s_stream_inflight--;
+    }
+    return s_tx_buf[s_stream_idx];
+}
+
+/**
+ * @brief 函数功能：发送 EPD_Bus_StreamBuffer 取得的缓冲区
+ * @details 函数实现：DC置高后用 spi_device_queue_trans 排队，立即返回，CPU接着填写另一块。
+ * 设备的 queue_size 为2，正好容纳两块暂存缓冲区
+ */
+void EPD_Bus_StreamSend(size_t len)
+{
+    spi_transaction_t *t = &s_stream_trans[s_stream_idx];
+
+    if (len == 0) {
+        return;
+    }
+    gpio_set_level(s_pins.dc, 1);
+    memset(t, 0, sizeof(*t));
+    t->length = len * 8;
+    t->tx_buffer = s_tx_buf[s_stream_idx];
+    ESP_ERROR_CHECK(spi_device_queue_trans(s_spi, t, portMAX_DELAY));
+    s_stream_inflight++;
+    s_stream_idx ^= 1;
+}
+
+void EPD_Bus_StreamFlush(void)
+{
+    spi_transaction_t *r;
+
+    while (s_stream_inflight > 0) {
+        ESP_ERROR_CHECK(spi_device_get_trans_result(s_spi, &r, portMAX_DELAY));
+        s_stream_inflight--;
+    }
+}
+
+#elif CONFIG_EPD_BUS_BITBANG
+//================GPIO模拟时序=======================
+
+esp_err_t EPD_Bus_Init(const EPD_BUS_PINS *pins)
+{
+    s_pins = *pins;
+    EPD_Bus_GPIOInit();
+    ESP_LOGI(TAG, "bit-bang bus ready");
+    return EPD_Bus_IdleNotifyInit();
+}
+
+/**
+ * @brief 函数功能：向总线上写入一个字节的数据
+ * @details 函数实现：首先拉低CS，从最高位开始逐个发送8位数据，墨水屏采集数据的时机是SCL上升沿，最后拉高CS
+ */
+static void EPD_Bus_WriteByte(uint8_t dat)
+{
+    uint8_t i;
+
+    gpio_set_level(s_pins.cs, 0);           // 拉低CS
+
+    for(i=0;i<8;i++){                       // 1个字节的8个位，从最高位开始传输
+        gpio_set_level(s_pins.scl, 0);      // 时钟SCL拉低
+        gpio_set_level(s_pins.sda, (dat&0x80) ? 1 : 0);
+        gpio_set_level(s_pins.scl, 1);      // 制造SCL上升沿
+        dat<<=1;
+    }
+
+    gpio_set_level(s_pins.cs, 1);           // 拉高CS
+}
+
+void EPD_Bus_WriteCmd(uint8_t cmd)
+{
+    gpio_set_level(s_pins.dc, 0);
+    EPD_Bus_WriteByte(cmd);
+    gpio_set_level(s_pins.dc, 1);
+}
+
+void EPD_Bus_WriteData(const uint8_t *data, size_t len)
+{
+    gpio_set_level(s_pins.dc, 1);
+    while (len--) {
+        EPD_Bus_WriteByte(*data++);
+    }
+}
+
+#endif
+
+#if !CONFIG_EPD_BUS_SPI
+//================模拟时序、Mock没有DMA，暂存缓冲区直接同步发送=======================
+
+uint8_t *EPD_Bus_StreamBuffer(void)
+{
+    return s_tx_buf[s_stream_idx];
+}
+
+void EPD_Bus_StreamSend(size_t len)
+{
+    EPD_Bus_WriteData(s_tx_buf[s_stream_idx], len);
+    s_stream_idx ^= 1;
+}
+
+void EPD_Bus_StreamFlush(void)
+{
+}
+#endif
+
+#if CONFIG_EPD_BUS_MOCK
+
+//================主机Mock=======================
+
+static uint16_t *s_log = NULL;
+static size_t s_log_len = 0;
+static size_t s_log_cap = 0;
+static int s_busy_level = 1;
+
+static void EPD_Bus_MockPush(uint16_t v)
+{
+    if (s_log_len == s_log_cap) {
+        size_t cap = s_log_cap ? s_log_cap * 2 : 1024;
+        uint16_t *p = realloc(s_log, cap * sizeof(uint16_t));
+        if (!p) {
+            ESP_LOGE(TAG, "mock log out of memory");
+            return;
+        }
+        s_log = p;
+        s_log_cap = cap;
+    }
+    s_log[s_log_len++] = v;
+}
+
+esp_err_t EPD_Bus_Init(const EPD_BUS_PINS *pins)
+{
+    s_pins = *pins;
+    ESP_LOGI(TAG, "mock bus ready");
+    return ESP_OK;
+}
+
+void EPD_Bus_SetRST(uint8_t level)
+{
+    (void)level;
+}
+
+int EPD_Bus_ReadBusy(void)
+{
+    return s_busy_level;
+}
+
+static int s_idle_level = 1;
+
+esp_err_t EPD_Bus_StartIdleNotify(int idle_level)
+{
+    s_idle_level = idle_level;
+    return ESP_OK;
+}
+
+esp_err_t EPD_Bus_WaitIdleNotify(uint32_t timeout_ms, uint32_t *waited_ms)
+{
+    (void)timeout_ms;       // BUSY 电平只由测试设置，等待期间不会变化，不用真的等
+    if (waited_ms) {
+        *waited_ms = 0;
+    }
+    return s_busy_level == s_idle_level ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t EPD_Bus_WaitIdle(int idle_level, uint32_t timeout_ms, uint32_t *waited_ms)
+{
+    EPD_Bus_StartIdleNotify(idle_level);
+    return EPD_Bus_WaitIdleNotify(timeout_ms, waited_ms);
+}
+
+void EPD_Bus_WriteCmd(uint8_t cmd)
+{
+    EPD_Bus_MockPush(cmd);
+}
+
+void EPD_Bus_WriteData(const uint8_t *data, size_t len)
+{
+    while (len--) {
+        EPD_Bus_MockPush(EPD_BUS_MOCK_DATA | *data++);
+    }
+}
+
+const uint16_t *EPD_Bus_MockLog(size_t *count)
+{
+    *count = s_log_len;
+    return s_log;
+}
+
+void EPD_Bus_MockReset(void)
+{
+    s_log_len = 0;
+}
+
+void EPD_Bus_MockSetBusy(int level)
+{
+    s_busy_level = level;
+}
+
+#endif
+
+/**
+ * @brief 函数功能：写指令后紧跟 len 个数据
+ * @details 函数实现：整块写RAM时只需要一次指令+一次（或几次）大块数据传输
+ */
+void EPD_Bus_WriteCmdData(uint8_t cmd, const uint8_t *data, size_t len)
+{
+    EPD_Bus_WriteCmd(cmd);
+    EPD_Bus_WriteData(data, len);
+}
+
+/**
+ * @brief 函数功能：用同一个字节连续写 len 个数据
+ * @details 函数实现：暂存缓冲区填满同一个字节，然后按块发送，清屏时不必逐字节调用
+ */
+void EPD_Bus_FillData(uint8_t dat, size_t len)
+{
+    uint8_t *buf = EPD_Bus_TxBuffer();
+    size_t n = len > EPD_BUS_CHUNK_SIZE ? EPD_BUS_CHUNK_SIZE : len;
+
+    memset(buf, dat, n);
+    while (len > 0) {
+        n = len > EPD_BUS_CHUNK_SIZE ? EPD_BUS_CHUNK_SIZE : len;
+        EPD_Bus_WriteData(buf, n);
+        len -= n;
+    }
+}
+
+/**
+ * @brief 函数功能：获取DMA暂存缓冲区
+ * @details 函数实现：先等排队的传输发完，返回的缓冲区可以随意改写，用法与双缓冲之前相同
+ */
+uint8_t *EPD_Bus_TxBuffer(void)
+{
+    EPD_Bus_StreamFlush();
+    return s_tx_buf[0];
+}
@@ -0,0 +1,128 @@
+/**
+ * @file epaper_bus.h
+ * @author liying (respire_ly@qq.com)
+ * @brief 墨水屏数据总线：硬件SPI+DMA、GPIO模拟时序、主机Mock三种实现
+ * @version 1.2
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 墨水屏数据总线 |
+ * | 2026-10-18 | 1.1 | liying | BUSY改为事件组通知，支持异步刷新 |
+ * | 2026-10-18 | 1.2 | liying | 双暂存缓冲区，填写一块时另一块在DMA发送 |
+ *
+ * @par 实现选择
+ * 通过 menuconfig → E-Paper Driver Configuration → E-paper bus transport 选择：<br>
+ * CONFIG_EPD_BUS_SPI：ESP-IDF SPI master 驱动，DMA 大块传输<br>
+ * CONFIG_EPD_BUS_BITBANG：原来的 gpio_set_level 逐位模拟时序，作为兜底<br>
+ * CONFIG_EPD_BUS_MOCK：Linux 主机编译时使用，只记录写入的字节，便于逐字节比对
+ */
+
+#ifndef EPAPER_BUS_H
+#define EPAPER_BUS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#if !CONFIG_EPD_BUS_MOCK
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#endif
+
+/**
+ * @def EPD_BUS_CHUNK_SIZE
+ * @brief 单次总线传输的最大字节数，也是DMA暂存缓冲区的大小
+ * @details ESP32 单个DMA描述符最多 4092 字节，且是4的倍数。暂存缓冲区有两块，见 EPD_Bus_StreamBuffer
+ */
+#define EPD_BUS_CHUNK_SIZE  4092
+
+/**
+ * @def EPD_BUS_MAX_TRANSFER
+ * @brief 单个SPI事务最多发送的字节数
+ * @details 数据本身在DMA可访问的内存里时不经过暂存缓冲区，由驱动串起多个DMA描述符一次发完，
+ * 整帧画布（4色屏17280字节、2.9寸屏4736字节）都只需要一个事务
+ */
+#define EPD_BUS_MAX_TRANSFER  (32*1024)
+
+/** @brief BUSY空闲事件位，见 EPD_Bus_StartIdleNotify */
+#define EPD_BUS_IDLE_BIT  (1 << 0)
+
+/** @brief 结构体：墨水屏总线使用的引脚 */
+typedef struct {
+	int busy;		/**< BUSY，输入 */
+	int rst;		/**< RES，复位 */
+	int dc;			/**< D/C#，0:指令 1:数据 */
+	int cs;			/**< CS，片选 */
+	int scl;		/**< SCL，时钟 */
+	int sda;		/**< SDA，数据 */
+}EPD_BUS_PINS;
+
+/** @brief  函数功能：初始化总线和引脚，安装BUSY中断；返回中断安装的错误码，失败时总线照常可用，等待BUSY改为轮询 */
+esp_err_t EPD_Bus_Init(const EPD_BUS_PINS *pins);
+
+/** @brief  函数功能：设置RES引脚电平 */
+void EPD_Bus_SetRST(uint8_t level);
+
+/** @brief  函数功能：读取BUSY引脚电平 */
+int EPD_Bus_ReadBusy(void);
+
+/** @brief  函数功能：等待BUSY变为空闲电平，中断唤醒，返回 ESP_OK 或 ESP_ERR_TIMEOUT */
+esp_err_t EPD_Bus_WaitIdle(int idle_level, uint32_t timeout_ms, uint32_t *waited_ms);
+
+/** @brief  函数功能：开始监听BUSY，不阻塞；空闲时置位 EPD_BUS_IDLE_BIT，用于异步刷新 */
+esp_err_t EPD_Bus_StartIdleNotify(int idle_level);
+
+/** @brief  函数功能：等待 EPD_Bus_StartIdleNotify 开始的监听完成 */
+esp_err_t EPD_Bus_WaitIdleNotify(uint32_t timeout_ms, uint32_t *waited_ms);
+
+#if !CONFIG_EPD_BUS_MOCK
+/** @brief  函数功能：获取BUSY空闲事件组，可与其他事件位一起等待 EPD_BUS_IDLE_BIT；轮询时只在 EPD_Bus_WaitIdleNotify 里置位，可能为NULL */
+EventGroupHandle_t EPD_Bus_IdleEventGroup(void);
+#endif
+
+/** @brief  函数功能：写指令-Command，DC置低 */
+void EPD_Bus_WriteCmd(uint8_t cmd);
+
+/** @brief  函数功能：连续写数据-Parameter，DC置高 */
+void EPD_Bus_WriteData(const uint8_t *data, size_t len);
+
+/** @brief  函数功能：写指令后紧跟 len 个数据，用于 0x10、0x24、0x26 这类整块写RAM的指令 */
+void EPD_Bus_WriteCmdData(uint8_t cmd, const uint8_t *data, size_t len);
+
+/** @brief  函数功能：用同一个字节连续写 len 个数据 */
+void EPD_Bus_FillData(uint8_t dat, size_t len);
+
+/** @brief  函数功能：获取 EPD_BUS_CHUNK_SIZE 字节的DMA暂存缓冲区，写入后可直接交给 EPD_Bus_WriteData */
+uint8_t *EPD_Bus_TxBuffer(void);
+
+/** @brief  函数功能：获取下一块可以填写的DMA暂存缓冲区，另一块可能仍在发送 */
+uint8_t *EPD_Bus_StreamBuffer(void);
+
+/** @brief  函数功能：发送 EPD_Bus_StreamBuffer 取得的缓冲区中的 len 个数据，SPI+DMA时排队后立即返回 */
+void EPD_Bus_StreamSend(size_t len);
+
+/** @brief  函数功能：等待排队的传输全部发送完成 */
+void EPD_Bus_StreamFlush(void);
+
+#if CONFIG_EPD_BUS_MOCK
+
+/** @brief Mock记录中数据字节的标记位，没有此标记的是指令字节 */
+#define EPD_BUS_MOCK_DATA  0x100
+
+/** @brief  函数功能：获取Mock记录，每个元素是一个字节，数据字节带 EPD_BUS_MOCK_DATA 标记 */
+const uint16_t *EPD_Bus_MockLog(size_t *count);
+
+/** @brief  函数功能：清空Mock记录 */
+void EPD_Bus_MockReset(void);
+
+/** @brief  函数功能：设置Mock的BUSY电平 */
+void EPD_Bus_MockSetBusy(int level);
+
+#endif
+
+#endif
@@ -1,4 +1,5 @@
 #include "epaper_font.h"
+#include <stddef.h>
 
 /**  @brief 8*6 ASCII字符集 */
 const unsigned char asc2_0806[][6] = {
@@ -665,3 +666,34 @@ const typFNT_GB32 tfont32[2]={
 0x80,0x01,0x00,0x00,0x80,0x01,0x00,0x00,0xC0,0x00,0x00,0x00,0x60,0x00,0x00,0x00}},
 };
 
+
+/**
+ * @brief 函数功能：按码点和字号查找汉字取模数据
+ * @details 函数实现：在按码点排序的 tfont_index 中二分查找，找到的一项同时记录了各字号的下标，
+ * 查找次数只与汉字总数的对数有关，与字号无关
+ *
+ * @param codepoint Unicode码点
+ * @param sizey 字号，12/16/24/32
+ * @return const unsigned char* 取模数据，没有该字或该字号时返回NULL
+ */
+const unsigned char *EPD_Font_Find(uint32_t codepoint, uint8_t sizey)
+{
+  uint16_t lo=0,hi=tfont_index_num,mid,k;
+
+  while(lo<hi)
+  {
+    mid=(lo+hi)/2;
+    if(tfont_index[mid].codepoint<codepoint) lo=mid+1;
+    else hi=mid;
+  }
+  if(lo==tfont_index_num||tfont_index[lo].codepoint!=codepoint) return NULL;
+
+  switch(sizey)
+  {
+    case 12: k=tfont_index[lo].idx[0]; return k==EPD_FONT_NONE?NULL:tfont12[k].Msk;
+    case 16: k=tfont_index[lo].idx[1]; return k==EPD_FONT_NONE?NULL:tfont16[k].Msk;
+    case 24: k=tfont_index[lo].idx[2]; return k==EPD_FONT_NONE?NULL:tfont24[k].Msk;
+    case 32: k=tfont_index[lo].idx[3]; return k==EPD_FONT_NONE?NULL:tfont32[k].Msk;
+    default: return NULL;
+  }
+}
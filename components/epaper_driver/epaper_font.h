@@ -2,8 +2,8 @@
  * @file epaper_font.h
  * @author liying (respire_ly@qq.com)
  * @brief ASCII字符和汉字取模的字库
- * @version 1.0
- * @date 2025-04-12
+ * @version 1.1
+ * @date 2026-10-18
  * 
  * @copyright Copyright (c) 2025  freelance
  * 
@@ -11,6 +11,7 @@
  * | Date | Version | Author | Description |
  * | --- | --- | --- | --- |
  * | 2025-04-12 | 1.0 | liying | ASCII字符和汉字取模的字库 |
+ * | 2026-10-18 | 1.1 | liying | 增加按码点排序的汉字索引，构建时由 tools/gen_font_index.py 生成 |
  * 
  * @par  取模说明
  * 取模软件：PCtoLCD2002<br>
@@ -21,11 +22,18 @@
  * ASCII字符：列行式<br>
  * 汉字：逐行式
  * </div>
+ *
+ * @par  汉字索引
+ * 构建时 tools/gen_font_index.py 读取本目录 epaper_font.c 中的 tfont12/16/24/32，
+ * 生成按Unicode码点升序排列的 tfont_index（epaper_font_index.c，在构建目录中）。
+ * 增删汉字只需改 epaper_font.c，索引会自动重新生成
  */
 
 #ifndef _EPD_FONT_H_
 #define _EPD_FONT_H_
 
+#include <stdint.h>
+
 // ASCII字符集
 extern const unsigned char asc2_0806[][6];
 extern const unsigned char asc2_1206[][12];
@@ -70,5 +78,22 @@ extern const typFNT_GB16 tfont16[2];
 extern const typFNT_GB24 tfont24[21];
 extern const typFNT_GB32 tfont32[2];
 
+/** @brief 汉字索引中表示该字号没有这个字 */
+#define EPD_FONT_NONE  0xFFFF
+
+/** @brief 结构体：汉字索引，一个汉字一项，按码点升序排列 */
+typedef struct
+{
+	uint32_t codepoint;		/**< Unicode码点 */
+	uint16_t idx[4];		/**< 在 tfont12/16/24/32 中的下标，没有为 EPD_FONT_NONE */
+}EPD_FONT_INDEX;
+
+// 汉字索引，构建时生成
+extern const EPD_FONT_INDEX tfont_index[];
+extern const uint16_t tfont_index_num;
+
+/** @brief  函数功能：按码点和字号查找汉字取模数据，没有返回NULL */
+const unsigned char *EPD_Font_Find(uint32_t codepoint, uint8_t sizey);
+
 
 #endif
@@ -0,0 +1,129 @@
+/**
+ * @file epaper_framediff.c
+ * @author liying (respire_ly@qq.com)
+ * @brief 与上一次显示的画面逐块比较，决定是否需要刷新
+ * @version 1.2
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 画面逐块比较 |
+ * | 2026-10-18 | 1.1 | liying | 分块哈希改由 epaper_tilehash 实现，输出多个变化区域 |
+ * | 2026-10-18 | 1.2 | liying | 说明面板只用到跳过：屏幕每次刷新后深度睡眠，局部和整屏的处理相同 |
+ */
+
+#include "epaper_framediff.h"
+#include <string.h>
+#include "esp_attr.h"
+
+/** @brief 表头魔数，RTC内存上电后是随机值，用它判断哈希表是否有效 */
+#define EPD_DIFF_MAGIC  0x45504446
+
+/** @brief 结构体：上次显示画面的块哈希表，放在RTC内存，深度睡眠后保留 */
+typedef struct {
+	uint32_t magic;			/**< EPD_DIFF_MAGIC 表示有效 */
+	uint16_t width_bytes;	/**< 画布每行字节数 */
+	uint16_t rows;			/**< 画布行数 */
+	uint8_t bits_per_pixel;	/**< 每像素位数 */
+	uint32_t hash[EPD_DIFF_MAX_TILES];
+}EPD_DIFF_TABLE;
+
+static RTC_DATA_ATTR EPD_DIFF_TABLE s_last;
+/** 本帧的块哈希，比较完再复制到 s_last */
+static uint32_t s_hash[EPD_DIFF_MAX_TILES];
+
+/**
+ * @brief 函数功能：32位哈希
+ * @details 函数实现：FNV-1a
+ *
+ * @param data 数据
+ * @param len  字节数
+ * @param seed 初值，连续计算多段数据时传入上一段的结果
+ * @return uint32_t 哈希值
+ */
+uint32_t EPD_Hash32(const uint8_t *data, size_t len, uint32_t seed)
+{
+  uint32_t h=seed?seed:2166136261u;
+
+  while(len--)
+  {
+    h^=*data++;
+    h*=16777619u;
+  }
+  return h;
+}
+
+/**
+ * @brief 函数功能：与上次显示的画面比较，并把本帧记为“上次显示的画面”
+ * @details 函数实现：\n
+ * 1、EPD_TileHash_Compute 计算本帧的块哈希，EPD_TileHash_Diff 与RTC内存中的哈希表比较得到变化区域 \n
+ * 2、没有变化返回 EPD_DIFF_SKIP；变化区域面积合计不超过一半返回 EPD_DIFF_PARTIAL；否则 EPD_DIFF_FULL \n
+ * 3、哈希表无效（第一次上电、画布尺寸变化、调用过 EPD_FrameDiff_Invalidate）时所有块都算变化 \n
+ * 调用后哈希表即更新，如果之后没有真正刷新，需调用 EPD_FrameDiff_Invalidate \n
+ * 面板每次刷新后深度睡眠，现在只按是否为 EPD_DIFF_SKIP 决定刷新，局部和整屏都整屏上传
+ *
+ * @param image 画布数据
+ * @param width_bytes 画布每行字节数
+ * @param rows 画布行数
+ * @param bits_per_pixel 每像素位数，1或2
+ * @param res 比较结果，可为NULL
+ * @return EPD_DIFF_ACTION 刷新方式
+ */
+EPD_DIFF_ACTION EPD_FrameDiff(const uint8_t *image, uint16_t width_bytes, uint16_t rows, uint8_t bits_per_pixel, EPD_DIFF_RESULT *res)
+{
+  EPD_TILE_GEOM geom;
+  EPD_DIFF_RESULT dummy;
+  uint32_t area=0;
+  uint8_t valid,k;
+
+  if(!res) res=&dummy;
+  res->total=EPD_TileHash_Geom(&geom,width_bytes,rows,bits_per_pixel);
+  res->bbox.X0=0; res->bbox.Y0=0;
+  res->bbox.X1=width_bytes*geom.px_per_byte-1; res->bbox.Y1=rows-1;
+  if(res->total>EPD_DIFF_MAX_TILES)   // 表放不下，只能整屏刷新
+  {
+    s_last.magic=0;
+    res->changed=res->total;
+    res->rects[0]=res->bbox;
+    res->rect_count=1;
+    return EPD_DIFF_FULL;
+  }
+
+  valid=(s_last.magic==EPD_DIFF_MAGIC&&s_last.width_bytes==width_bytes
+         &&s_last.rows==rows&&s_last.bits_per_pixel==bits_per_pixel);
+
+  EPD_TileHash_Compute(&geom,image,s_hash);
+  res->changed=EPD_TileHash_Diff(&geom,valid?s_last.hash:NULL,s_hash,res->rects,EPD_DIFF_MAX_RECTS,&res->rect_count);
+
+  memcpy(s_last.hash,s_hash,res->total*sizeof(uint32_t));
+  s_last.width_bytes=width_bytes;
+  s_last.rows=rows;
+  s_last.bits_per_pixel=bits_per_pixel;
+  s_last.magic=EPD_DIFF_MAGIC;
+
+  if(res->changed==0) return EPD_DIFF_SKIP;
+
+  res->bbox=res->rects[0];
+  for(k=0;k<res->rect_count;k++)
+  {
+    if(res->rects[k].X0<res->bbox.X0) res->bbox.X0=res->rects[k].X0;
+    if(res->rects[k].Y0<res->bbox.Y0) res->bbox.Y0=res->rects[k].Y0;
+    if(res->rects[k].X1>res->bbox.X1) res->bbox.X1=res->rects[k].X1;
+    if(res->rects[k].Y1>res->bbox.Y1) res->bbox.Y1=res->rects[k].Y1;
+    area+=EPD_TileRect_Area(&res->rects[k]);
+  }
+
+  if(valid&&area*2<=(uint32_t)width_bytes*geom.px_per_byte*rows) return EPD_DIFF_PARTIAL;
+  return EPD_DIFF_FULL;
+}
+
+/**
+ * @brief 函数功能：丢弃上次显示的画面记录
+ */
+void EPD_FrameDiff_Invalidate(void)
+{
+  s_last.magic=0;
+}
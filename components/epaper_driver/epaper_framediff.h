@@ -0,0 +1,64 @@
+/**
+ * @file epaper_framediff.h
+ * @author liying (respire_ly@qq.com)
+ * @brief 与上一次显示的画面逐块比较，决定是否需要刷新
+ * @version 1.2
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 画面逐块比较 |
+ * | 2026-10-18 | 1.1 | liying | 分块哈希改由 epaper_tilehash 实现，输出多个变化区域 |
+ * | 2026-10-18 | 1.2 | liying | 说明面板只用到跳过：屏幕每次刷新后深度睡眠，局部和整屏的处理相同 |
+ *
+ * @par 原理
+ * 画布按16×16像素分块（见 epaper_tilehash.h），每块算一个32位哈希，
+ * 哈希表放在 RTC 内存里，深度睡眠后仍然保留，不需要保存整帧17KB的画布。
+ * 新的一帧画完后逐块比较哈希，得到变化区域
+ *
+ * @par 限制
+ * 现在的面板只用到 EPD_DIFF_SKIP：屏幕每次刷新后都进入深度睡眠，唤醒后控制器RAM里没有上一帧，
+ * 不能只上传变化的窗口，EPD_DIFF_PARTIAL 与 EPD_DIFF_FULL 一样整屏上传、刷新
+ */
+
+#ifndef EPAPER_FRAMEDIFF_H
+#define EPAPER_FRAMEDIFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "epaper_tilehash.h"
+
+/** @brief 最多支持的块数，3.52寸屏 45字节×384行 需要 12×24=288 块 */
+#define EPD_DIFF_MAX_TILES   320
+/** @brief 最多输出的变化区域数，更多时合并 */
+#define EPD_DIFF_MAX_RECTS   4
+
+/** @brief 枚举：比较结果对应的刷新方式 */
+typedef enum {
+	EPD_DIFF_SKIP = 0,		/**< 与上次完全相同，不需要上传和刷新 */
+	EPD_DIFF_PARTIAL,		/**< 变化区域合计不超过一半。控制器RAM里是上一帧时可以只上传变化的窗口，现在的面板按整屏处理 */
+	EPD_DIFF_FULL,			/**< 变化较多或没有上一帧的记录，整屏刷新 */
+}EPD_DIFF_ACTION;
+
+/** @brief 结构体：比较结果 */
+typedef struct {
+	EPD_TILE_RECT bbox;		/**< 所有变化区域的外框，画布内存坐标 */
+	EPD_TILE_RECT rects[EPD_DIFF_MAX_RECTS];	/**< 各个变化区域 */
+	uint8_t rect_count;		/**< 变化区域个数 */
+	uint16_t changed;		/**< 变化的块数 */
+	uint16_t total;			/**< 总块数 */
+}EPD_DIFF_RESULT;
+
+/** @brief  函数功能：32位哈希，用于块哈希和内容指纹 */
+uint32_t EPD_Hash32(const uint8_t *data, size_t len, uint32_t seed);
+
+/** @brief  函数功能：与上次显示的画面比较，并把本帧记为“上次显示的画面” */
+EPD_DIFF_ACTION EPD_FrameDiff(const uint8_t *image, uint16_t width_bytes, uint16_t rows, uint8_t bits_per_pixel, EPD_DIFF_RESULT *res);
+
+/** @brief  函数功能：丢弃上次显示的画面记录，下一帧按整屏刷新 */
+void EPD_FrameDiff_Invalidate(void);
+
+#endif
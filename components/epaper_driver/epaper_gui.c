@@ -2,7 +2,7 @@
  * @file epaper_gui.c
  * @author liying (respire_ly@qq.com)
  * @brief 墨水屏GUI驱动
- * @version 1.0
+ * @version 1.5
  * @date 2025-04-18
  * 
  * @copyright Copyright (c) 2025  freelance
@@ -11,13 +11,21 @@
  * | Date | Version | Author | Description |
  * | --- | --- | --- | --- |
  * | 2025-04-18 | 1.0 | liying | 墨水屏GUI驱动 |
+ * | 2026-10-18 | 1.1 | liying | 增加按行/列填充的span绘制，矩形、清屏、字模按字节写入 |
+ * | 2026-10-18 | 1.2 | liying | 画布创建时算好旋转后的起点和步长，画点、画字模不再逐点判断方向 |
+ * | 2026-10-18 | 1.3 | liying | 记录画过的区域（脏区域），用于局部上传 |
+ * | 2026-10-18 | 1.4 | liying | 汉字先解码成码点，再二分查找排序后的汉字索引，不再逐个比较UTF-8字节 |
+ * | 2026-10-18 | 1.5 | liying | 去掉脏区域，画点、画矩形、画字模不再记录 |
  */
 #include "epaper_gui.h"
 #include "epaper_font.h"
+#include <string.h>
 
 /** 画布  */
 PAINT Paint;
 
+static void Paint_MapPoint(int x,int y,int *X,int *Y);
+
 
 /**
  * @brief 函数功能：创建画布 
@@ -52,6 +60,34 @@ void Paint_NewImage(uint8_t *image,uint16_t Width,uint16_t Height,uint16_t Rotat
     Paint.width=Height;
     Paint.height=Width; 
   }
+
+  // 旋转公式只在这里算一次，换成像素序号的起点和步长，公式与 Paint_MapPoint 相同
+  int32_t rowPixels=Paint.widthByte*4;
+  int32_t lastX=Paint.widthMemory-1;
+  int32_t lastY=(int32_t)(Paint.heightMemory-1)*rowPixels;
+  switch(Rotate)
+  {
+    case 0:       // X=widthMemory-y-1，Y=x
+      Paint.origin=lastX;  Paint.xStride=rowPixels;   Paint.yStride=-1;
+      Paint.xLimit=Paint.heightMemory;  Paint.yLimit=Paint.widthMemory;
+      break;
+    case 90:      // X=widthMemory-x-1，Y=heightMemory-y-1
+      Paint.origin=lastX+lastY;  Paint.xStride=-1;  Paint.yStride=-rowPixels;
+      Paint.xLimit=Paint.widthMemory;  Paint.yLimit=Paint.heightMemory;
+      break;
+    case 180:     // X=y，Y=heightMemory-x-1
+      Paint.origin=lastY;  Paint.xStride=-rowPixels;  Paint.yStride=1;
+      Paint.xLimit=Paint.heightMemory;  Paint.yLimit=Paint.widthMemory;
+      break;
+    case 270:     // X=x，Y=y
+      Paint.origin=0;  Paint.xStride=1;  Paint.yStride=rowPixels;
+      Paint.xLimit=Paint.widthMemory;  Paint.yLimit=Paint.heightMemory;
+      break;
+    default:      // 不支持的方向，所有点都不画
+      Paint.origin=0;  Paint.xStride=0;  Paint.yStride=0;
+      Paint.xLimit=0;  Paint.yLimit=0;
+      break;
+  }
 }         
 
 /**
@@ -61,19 +97,9 @@ void Paint_NewImage(uint8_t *image,uint16_t Width,uint16_t Height,uint16_t Rotat
  */
 void Paint_Clear(uint8_t Color)
 {
-  uint16_t X,Y;
-  uint32_t Addr;
-  for(Y=0;Y<Paint.heightByte;Y++) 
-  {
-    for(X=0;X<Paint.widthByte;X++) 
-    {   
-      Addr=X+Y*Paint.widthByte;
-      Paint.Image[Addr]=(Color<<6)|(Color<<4)|(Color<<2)|Color; //将Paint.Image数组的所有数据清除，赋值Color
-    }
-  }
+  memset(Paint.Image, Paint_ColorPattern(Color), (uint32_t)Paint.widthByte*Paint.heightByte);
 }
 
-
 /**
  * @brief 函数功能：设置某个坐标像素点的颜色
  * 
@@ -83,38 +109,325 @@ void Paint_Clear(uint8_t Color)
  */
 void Paint_SetPixel(uint16_t Xpoint,uint16_t Ypoint,uint16_t Color)
 {
-  uint16_t X, Y;
-  uint32_t Addr;
-  uint8_t Rdata;    
+  int32_t idx;
+  uint8_t shift;
+
+  if(Xpoint>=Paint.xLimit||Ypoint>=Paint.yLimit) return;
+
+  idx=Paint.origin+Xpoint*Paint.xStride+Ypoint*Paint.yStride;   // 旋转后的像素序号
+  shift=6-2*(idx&3);
+  Paint.Image[idx>>2]=(Paint.Image[idx>>2]&~(0x03<<shift))|((Color&0x03)<<shift);
+}
+
 
-  switch(Paint.rotate)      // 计算旋转后的坐标
+/**
+ * @brief 函数功能：逻辑坐标转换为画布内存坐标，不做越界检查
+ * @details 函数实现：与 Paint_SetPixel 的旋转公式相同，坐标用int，越界的点由调用者裁剪
+ */
+static void Paint_MapPoint(int x,int y,int *X,int *Y)
+{
+  switch(Paint.rotate)
   {
-      case 0:
-          X=Paint.widthMemory-Ypoint-1;
-          Y=Xpoint;
-          break;
-      case 90:
-          X=Paint.widthMemory-Xpoint-1;
-          Y=Paint.heightMemory-Ypoint-1;
-          break;
-      case 180:
-          X=Ypoint;
-          Y=Paint.heightMemory-Xpoint-1;
-          break;
-      case 270:
-          X=Xpoint;
-          Y=Ypoint;
-          break;
-        default:
-            return;
+    case 0:
+      *X=Paint.widthMemory-y-1;
+      *Y=x;
+      break;
+    case 90:
+      *X=Paint.widthMemory-x-1;
+      *Y=Paint.heightMemory-y-1;
+      break;
+    case 180:
+      *X=y;
+      *Y=Paint.heightMemory-x-1;
+      break;
+    default:      // 270
+      *X=x;
+      *Y=y;
+      break;
+  }
+}
+
+/**
+ * @brief 函数功能：填充内存中的一行，X0~X1（含）
+ * @details 函数实现：首尾两个字节用掩码合并，中间整字节直接memset
+ */
+static void Paint_MemHSpan(int Y,int X0,int X1,uint8_t pattern)
+{
+  uint8_t *row=Paint.Image+(uint32_t)Y*Paint.widthByte;
+  int b0=X0>>2, b1=X1>>2;
+  uint8_t head=0xFF>>((X0&3)*2);
+  uint8_t tail=(uint8_t)(0xFF<<((3-(X1&3))*2));
+
+  if(b0==b1)
+  {
+    head&=tail;
+    row[b0]=(row[b0]&~head)|(pattern&head);
+    return;
+  }
+  row[b0]=(row[b0]&~head)|(pattern&head);
+  memset(row+b0+1,pattern,b1-b0-1);
+  row[b1]=(row[b1]&~tail)|(pattern&tail);
+}
+
+/**
+ * @brief 函数功能：填充内存中的一列，Y0~Y1（含）
+ * @details 函数实现：每行同一个字节的同一个2bit，地址每次加 widthByte
+ */
+static void Paint_MemVSpan(int X,int Y0,int Y1,uint8_t pattern)
+{
+  uint8_t *p=Paint.Image+(X>>2)+(uint32_t)Y0*Paint.widthByte;
+  uint8_t mask=0xC0>>((X&3)*2);
+  uint8_t value=pattern&mask;
+  int Y;
+
+  for(Y=Y0;Y<=Y1;Y++,p+=Paint.widthByte)
+  {
+    *p=(*p&~mask)|value;
+  }
+}
+
+/**
+ * @brief 函数功能：填充实心矩形，四个坐标都包含在内
+ * @details 函数实现：逻辑矩形旋转后仍是内存中的矩形，转换两个对角后裁剪到画布，
+ * 再按内存行填充（行内首尾掩码、中间memset），只有一列宽时按列填充
+ *
+ * @param x0 X坐标起始
+ * @param y0 Y坐标起始
+ * @param x1 X坐标结束
+ * @param y1 Y坐标结束
+ * @param Color 颜色
+ */
+void Paint_FillRect(int x0,int y0,int x1,int y1,uint8_t Color)
+{
+  int Xa,Ya,Xb,Yb,X0,X1,Y0,Y1,Y;
+  uint8_t pattern=Paint_ColorPattern(Color);
+
+  if(Paint.xLimit==0) return;     // 不支持的方向
+  if(x0>x1) { Xa=x0; x0=x1; x1=Xa; }
+  if(y0>y1) { Ya=y0; y0=y1; y1=Ya; }
+  if(x0<0) x0=0;
+  if(y0<0) y0=0;
+  if(x1>=Paint.xLimit) x1=Paint.xLimit-1;
+  if(y1>=Paint.yLimit) y1=Paint.yLimit-1;
+  if(x0>x1||y0>y1) return;
+
+  Paint_MapPoint(x0,y0,&Xa,&Ya);
+  Paint_MapPoint(x1,y1,&Xb,&Yb);
+  X0=Xa<Xb?Xa:Xb;  X1=Xa<Xb?Xb:Xa;
+  Y0=Ya<Yb?Ya:Yb;  Y1=Ya<Yb?Yb:Ya;
+
+  if(X0<0) X0=0;
+  if(Y0<0) Y0=0;
+  if(X1>=Paint.widthMemory) X1=Paint.widthMemory-1;
+  if(Y1>=Paint.heightMemory) Y1=Paint.heightMemory-1;
+  if(X0>X1||Y0>Y1) return;
+
+  if(X0==X1)
+  {
+    Paint_MemVSpan(X0,Y0,Y1,pattern);
+    return;
+  }
+  for(Y=Y0;Y<=Y1;Y++)
+  {
+    Paint_MemHSpan(Y,X0,X1,pattern);
+  }
+}
+
+/** @brief 函数功能：画水平线段，从(x,y)开始向右 len 个像素 */
+void Paint_DrawHSpan(int x,int y,int len,uint8_t Color)
+{
+  if(len>0) Paint_FillRect(x,y,x+len-1,y,Color);
+}
+
+/** @brief 函数功能：画竖直线段，从(x,y)开始向下 len 个像素 */
+void Paint_DrawVSpan(int x,int y,int len,uint8_t Color)
+{
+  if(len>0) Paint_FillRect(x,y,x,y+len-1,Color);
+}
+
+/** 4个像素的位（高位在前）扩展为2bpp掩码 */
+static const uint8_t s_nibble_mask[16] = {
+  0x00,0x03,0x0C,0x0F,0x30,0x33,0x3C,0x3F,0xC0,0xC3,0xCC,0xCF,0xF0,0xF3,0xFC,0xFF
+};
+
+/** 4个位倒序 */
+static const uint8_t s_nibble_rev[16] = {
+  0x0,0x8,0x4,0xC,0x2,0xA,0x6,0xE,0x1,0x9,0x5,0xD,0x3,0xB,0x7,0xF
+};
+
+/** @brief 函数功能：字节内的位倒序 */
+static inline uint8_t Paint_Rev8(uint8_t b)
+{
+  return (s_nibble_rev[b&0x0F]<<4)|s_nibble_rev[b>>4];
+}
+
+/**
+ * @brief 函数功能：把内存中连续的8个像素写入画布
+ * @details 函数实现：8个位扩展成16位的2bpp掩码，按起始像素在字节内的位置移位后最多落在3个字节里，
+ * 每个字节读改写一次；掩码为0的字节不访问
+ *
+ * @param idx   第一个像素的序号
+ * @param bits8 8个像素，高位对应 idx
+ * @param pattern 颜色扩展后的字节
+ */
+static inline void Paint_Put8(int32_t idx,uint8_t bits8,uint8_t pattern)
+{
+  uint32_t mask=(((uint32_t)s_nibble_mask[bits8>>4]<<8)|s_nibble_mask[bits8&0x0F])<<(8-2*(idx&3));
+  uint8_t *p=Paint.Image+(idx>>2);
+  uint8_t m;
+
+  m=mask>>16;  if(m) p[0]=(p[0]&~m)|(pattern&m);
+  m=mask>>8;   if(m) p[1]=(p[1]&~m)|(pattern&m);
+  m=mask;      if(m) p[2]=(p[2]&~m)|(pattern&m);
+}
+
+/**
+ * @brief 函数功能：8x8位矩阵转置
+ * @details in[r] 的最高位是第r行第0列，转置后 out[c] 的最高位是第c列第0行
+ */
+static void Paint_Transpose8(const uint8_t in[8],uint8_t out[8])
+{
+  uint32_t x=((uint32_t)in[0]<<24)|((uint32_t)in[1]<<16)|((uint32_t)in[2]<<8)|in[3];
+  uint32_t y=((uint32_t)in[4]<<24)|((uint32_t)in[5]<<16)|((uint32_t)in[6]<<8)|in[7];
+  uint32_t t;
+
+  t=(x^(x>>7))&0x00AA00AA;  x=x^t^(t<<7);
+  t=(y^(y>>7))&0x00AA00AA;  y=y^t^(t<<7);
+  t=(x^(x>>14))&0x0000CCCC; x=x^t^(t<<14);
+  t=(y^(y>>14))&0x0000CCCC; y=y^t^(t<<14);
+  t=(x&0xF0F0F0F0)|((y>>4)&0x0F0F0F0F);
+  y=((x<<4)&0xF0F0F0F0)|(y&0x0F0F0F0F);
+  x=t;
+
+  out[0]=x>>24; out[1]=x>>16; out[2]=x>>8; out[3]=x;
+  out[4]=y>>24; out[5]=y>>16; out[6]=y>>8; out[7]=y;
+}
+
+/**
+ * @brief 函数功能：逐点画单色位图，带裁剪
+ * @details 函数实现：按画布内存里连续的方向逐线处理，每条线先裁剪出有效范围，像素序号每次加减1；
+ * 同一个字节里的点先合并成掩码，换字节时才读改写一次
+ */
+static void Paint_DrawMonoClipped(int x,int y,const uint8_t *bits,int w,int h,uint32_t row_bits,uint8_t lsb_first,uint8_t pattern)
+{
+  uint8_t along_y=(Paint.yStride==1||Paint.yStride==-1);    // 沿逻辑Y在内存中连续
+  int outer=along_y?w:h, inner=along_y?h:w;
+  int32_t step=along_y?Paint.yStride:Paint.xStride;
+  uint32_t bit_outer=along_y?1:row_bits, bit_inner=along_y?row_bits:1;
+  uint8_t flip=lsb_first?0:7;     // 位在字节内的序号转换为右移位数
+  int o,i;
+
+  for(o=0;o<outer;o++)
+  {
+    int lx=along_y?x+o:x, ly=along_y?y:y+o;   // 这条线的起点
+    int start=along_y?ly:lx, limit=along_y?Paint.yLimit:Paint.xLimit;
+    int i0=0, i1=inner;
+    int32_t idx, cur;
+    uint32_t pos;
+    uint8_t mask=0;
+
+    if(along_y?(lx<0||lx>=Paint.xLimit):(ly<0||ly>=Paint.yLimit)) continue;
+    if(start<0) i0=-start;
+    if(start+i1>limit) i1=limit-start;
+
+    idx=Paint.origin+lx*Paint.xStride+ly*Paint.yStride+i0*step;
+    pos=o*bit_outer+i0*bit_inner;
+    cur=idx>>2;
+    for(i=i0;i<i1;i++,idx+=step,pos+=bit_inner)
+    {
+      uint8_t bit=(bits[pos>>3]>>((pos&7)^flip))&0x01;
+
+      if((idx>>2)!=cur)         // 换字节，写回上一个字节
+      {
+        if(mask) Paint.Image[cur]=(Paint.Image[cur]&~mask)|(pattern&mask);
+        cur=idx>>2;
+        mask=0;
+      }
+      mask|=(uint8_t)(-bit)&(0xC0>>((idx&3)*2));
     }
-  Addr=X/4+Y*Paint.widthByte;
-  Color = Color % 4;
-  Rdata = Paint.Image[Addr];
-  Rdata = Rdata & (~(0xC0 >> ((X % 4)*2)));
-  Paint.Image[Addr]=Rdata|((Color<<6)>>((X%4)*2));
+    if(mask) Paint.Image[cur]=(Paint.Image[cur]&~mask)|(pattern&mask);
+  }
 }
 
+/**
+ * @brief 函数功能：把单色位图画到画布上，为1的位画成 Color，为0的位不改变
+ * @details 函数实现：位图完全在画布内且每行字节对齐时（字模都是这种情况）一次处理8个像素：\n
+ * 90、270度时位图的一行在内存中连续，每个源字节直接扩展成2bpp掩码写入；\n
+ * 0、180度时位图的一列在内存中连续，先把8x8的块转置，转置后每个字节就是一列的8个点。\n
+ * 步长为-1时把8个位倒序，从最小的像素序号开始写。全空的字节和块直接跳过。\n
+ * 其他情况（越界、行不对齐）逐点处理
+ *
+ * @param x 左上角坐标X
+ * @param y 左上角坐标Y
+ * @param bits 位图数据，按行存放
+ * @param w 位图宽
+ * @param h 位图高
+ * @param row_bits 位图一行占的位数，行与行之间不补齐时等于 w
+ * @param lsb_first 1:字节内低位在左，0:高位在左
+ * @param Color 颜色
+ */
+void Paint_DrawMono(int x,int y,const uint8_t *bits,int w,int h,uint32_t row_bits,uint8_t lsb_first,uint8_t Color)
+{
+  uint8_t pattern=Paint_ColorPattern(Color);
+  uint32_t row_bytes=row_bits>>3;
+  int c,r,k;
+
+  if(w<=0||h<=0) return;
+  if((row_bits&7)!=0||x<0||y<0||x+w>Paint.xLimit||y+h>Paint.yLimit)
+  {
+    Paint_DrawMonoClipped(x,y,bits,w,h,row_bits,lsb_first,pattern);
+    return;
+  }
+
+  if(Paint.xStride==1||Paint.xStride==-1)   // 位图的一行在内存中连续
+  {
+    for(r=0;r<h;r++)
+    {
+      const uint8_t *src=bits+r*row_bytes;
+      int32_t idx=Paint.origin+x*Paint.xStride+(y+r)*Paint.yStride;
+
+      for(c=0;c<w;c+=8,idx+=8*Paint.xStride)
+      {
+        uint8_t b=*src++;
+
+        if(lsb_first) b=Paint_Rev8(b);
+        if(w-c<8) b&=0xFF<<(8-(w-c));       // 最后不足8个点
+        if(!b) continue;
+        if(Paint.xStride>0) Paint_Put8(idx,b,pattern);
+        else                Paint_Put8(idx-7,Paint_Rev8(b),pattern);
+      }
+    }
+    return;
+  }
+
+  for(r=0;r<h;r+=8)                         // 位图的一列在内存中连续，8x8分块转置
+  {
+    for(c=0;c<w;c+=8)
+    {
+      uint8_t in[8],col[8],any=0;
+
+      for(k=0;k<8;k++)
+      {
+        in[k]=(r+k<h)?bits[(r+k)*row_bytes+(c>>3)]:0;
+        any|=in[k];
+      }
+      if(!any) continue;
+      Paint_Transpose8(in,col);
+
+      for(k=0;k<8&&c+k<w;k++)
+      {
+        uint8_t b=col[lsb_first?7-k:k];
+        int32_t idx;
+
+        if(!b) continue;
+        if(h-r<8) b&=0xFF<<(8-(h-r));       // 最后不足8行
+        idx=Paint.origin+(x+c+k)*Paint.xStride+(y+r)*Paint.yStride;
+        if(Paint.yStride>0) Paint_Put8(idx,b,pattern);
+        else                Paint_Put8(idx-7,Paint_Rev8(b),pattern);
+      }
+    }
+  }
+}
 
 /**
  * @brief 函数功能：画直线
@@ -132,6 +445,17 @@ void EPD_DrawLine(uint16_t Xstart,uint16_t Ystart,uint16_t Xend,uint16_t Yend,ui
   int XAddway,YAddway;
   int Esp;
   char Dotted_Len;
+
+  if(Ystart==Yend)      // 水平、竖直线直接按span填充
+  {
+    Paint_FillRect(Xstart<Xend?Xstart:Xend,Ystart,Xstart<Xend?Xend:Xstart,Ystart,Color);
+    return;
+  }
+  if(Xstart==Xend)
+  {
+    Paint_FillRect(Xstart,Ystart<Yend?Ystart:Yend,Xstart,Ystart<Yend?Yend:Ystart,Color);
+    return;
+  }
   Xpoint = Xstart;
   Ypoint = Ystart;
   dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
@@ -172,14 +496,9 @@ void EPD_DrawLine(uint16_t Xstart,uint16_t Ystart,uint16_t Xend,uint16_t Yend,ui
  */
 void EPD_DrawRectangle(uint16_t Xstart,uint16_t Ystart,uint16_t Xend,uint16_t Yend,uint16_t Color,uint8_t mode)
 {
-  uint16_t i;
-
   if (mode)
   {
-    for(i = Ystart; i < Yend; i++) 
-    {
-      EPD_DrawLine(Xstart,i,Xend,i,Color);
-    }
+    if(Yend>Ystart) Paint_FillRect(Xstart,Ystart,Xend,Yend-1,Color);   // 与原来逐行画线相同，不含Yend这一行
   }
   else 
   {
@@ -210,16 +529,15 @@ void EPD_DrawCircle(uint16_t X_Center,uint16_t Y_Center,uint16_t Radius,uint16_t
   Esp = 3 - (Radius << 1 );
     if (mode) {
         while (XCurrent <= YCurrent ) { //Realistic circles
-            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY ++ ) {
-                Paint_SetPixel(X_Center + XCurrent, Y_Center + sCountY, Color);//1
-                Paint_SetPixel(X_Center - XCurrent, Y_Center + sCountY, Color);//2
-                Paint_SetPixel(X_Center - sCountY, Y_Center + XCurrent, Color);//3
-                Paint_SetPixel(X_Center - sCountY, Y_Center - XCurrent, Color);//4
-                Paint_SetPixel(X_Center - XCurrent, Y_Center - sCountY, Color);//5
-                Paint_SetPixel(X_Center + XCurrent, Y_Center - sCountY, Color);//6
-                Paint_SetPixel(X_Center + sCountY, Y_Center - XCurrent, Color);//7
-                Paint_SetPixel(X_Center + sCountY, Y_Center + XCurrent, Color);
-            }
+            sCountY = YCurrent - XCurrent + 1;     // 8个对称位置各是一条线段
+            Paint_DrawVSpan(X_Center + XCurrent, Y_Center + XCurrent, sCountY, Color);//1
+            Paint_DrawVSpan(X_Center - XCurrent, Y_Center + XCurrent, sCountY, Color);//2
+            Paint_DrawHSpan(X_Center - YCurrent, Y_Center + XCurrent, sCountY, Color);//3
+            Paint_DrawHSpan(X_Center - YCurrent, Y_Center - XCurrent, sCountY, Color);//4
+            Paint_DrawVSpan(X_Center - XCurrent, Y_Center - YCurrent, sCountY, Color);//5
+            Paint_DrawVSpan(X_Center + XCurrent, Y_Center - YCurrent, sCountY, Color);//6
+            Paint_DrawHSpan(X_Center + XCurrent, Y_Center - XCurrent, sCountY, Color);//7
+            Paint_DrawHSpan(X_Center + XCurrent, Y_Center + XCurrent, sCountY, Color);
             if ((int)Esp < 0 )
                 Esp += 4 * XCurrent + 6;
             else {
@@ -269,6 +587,62 @@ int get_utf8_char_length(uint8_t first_byte) {
   return 0;  // 无效的 UTF - 8 起始字节
 }
 
+/**
+ * @brief 函数功能：解码一个UTF-8字符
+ * @details 函数实现：首字节由 get_utf8_char_length 得到字节数，后续字节必须是 10xxxxxx，
+ * 也挡住了字符中间提前出现的'\0'。驱动和 main 里的语录解析、字模查找都用这一个解码函数
+ *
+ * @param s 字符的第一个字节
+ * @param len 返回字符的字节数，无效编码时为0
+ * @return uint32_t Unicode码点，无效编码时为0
+ */
+uint32_t EPD_UTF8_Decode(const char *s, int *len)
+{
+  const uint8_t *p=(const uint8_t *)s;
+  int n=get_utf8_char_length(p[0]);
+  uint32_t cp;
+
+  *len=0;
+  if(n==0) return 0;
+  cp=(n==1)?p[0]:(p[0]&(0x7F>>n));   // 首字节去掉长度标志位
+  for(int m=1;m<n;m++)
+  {
+    if((p[m]&0xC0)!=0x80) return 0;   // 不是后续字节
+    cp=(cp<<6)|(p[m]&0x3F);
+  }
+  *len=n;
+  return cp;
+}
+
+/**
+ * @brief 函数功能：按码点显示一个汉字
+ * @details 函数实现：EPD_Font_Find 二分查找码点索引得到该字号的取模数据，字库中没有时不显示
+ *
+ * @param x 起始坐标X
+ * @param y 起始坐标Y
+ * @param codepoint Unicode码点
+ * @param sizey 字号
+ * @param color 颜色
+ */
+static void EPD_ShowChineseCode(uint16_t x,uint16_t y,uint32_t codepoint,uint8_t sizey,uint16_t color)
+{
+  const unsigned char *msk=EPD_Font_Find(codepoint,sizey);
+
+  if(msk) Paint_DrawMono(x,y,msk,sizey,sizey,((sizey+7)/8)*8,1,color);   // 每行 (sizey+7)/8 个字节，低位在左
+}
+
+/**
+ * @brief 函数功能：显示一个UTF-8编码的汉字，编码无效或与给定的字节数不符时不显示
+ */
+static void EPD_ShowChineseUTF8(uint16_t x,uint16_t y,const uint8_t *s,uint8_t sizey,uint16_t color,uint8_t utf8_charnum)
+{
+  int len;
+  uint32_t codepoint=EPD_UTF8_Decode((const char *)s,&len);
+
+  if(len==0||len!=utf8_charnum) return;
+  EPD_ShowChineseCode(x,y,codepoint,sizey,color);
+}
+
 /**
  * @brief 函数功能：显示汉字
  * 
@@ -280,26 +654,20 @@ int get_utf8_char_length(uint8_t first_byte) {
  */
 void EPD_ShowChinese(uint16_t x, uint16_t y, uint8_t *s, uint8_t sizey, uint16_t color) {
 
+  if (sizey != 12 && sizey != 16 && sizey != 24 && sizey != 32) {
+      return;
+  }
+
   while (*s != 0) {         // 逐个显示汉字
 
-      int length = get_utf8_char_length(*s);    // 得到当前汉字的字节数
+      int length;
+      uint32_t codepoint = EPD_UTF8_Decode((const char *)s, &length);   // 得到当前汉字的码点和字节数
       if (length == 0) {
           printf("invalid UTF-8 coding.\n");
           break;
       }
 
-      // 根据字号大小调用单个汉字显示函数
-      if (sizey == 12) {
-          EPD_ShowChinese12x12(x, y, s, sizey, color, length);
-      } else if (sizey == 16) {
-          EPD_ShowChinese16x16(x, y, s, sizey, color, length);
-      } else if (sizey == 24) {
-          EPD_ShowChinese24x24(x, y, s, sizey, color, length);
-      } else if (sizey == 32) {
-          EPD_ShowChinese32x32(x, y, s, sizey, color, length);
-      } else {
-          return;
-      }
+      EPD_ShowChineseCode(x, y, codepoint, sizey, color);   // 各字号共用一次码点查找
 
       s += length;  // 移动到下一个字符
       x += sizey;   // 向右移动一个位置来显示
@@ -325,207 +693,63 @@ void EPD_ShowChinese(uint16_t x,uint16_t y,uint8_t *s,uint8_t sizey,uint16_t col
 }*/
 
 /**
- * @brief 函数功能：显示汉字，12*12字号
+ * @brief 函数功能：显示汉字，12x12字号
  * 
  * @param x 起始坐标X
  * @param y 起始坐标Y
  * @param s 汉字
  * @param sizey 字号
  * @param color 颜色
+ * @param utf8_charnum 汉字的UTF-8字节数
  */
 void EPD_ShowChinese12x12(uint16_t x,uint16_t y,uint8_t *s,uint8_t sizey,uint16_t color,uint8_t utf8_charnum)
 {
-  uint8_t i,j;
-  uint16_t k;
-  uint16_t HZnum;
-  uint16_t TypefaceNum;
-  uint16_t x0=x;
-  TypefaceNum=(sizey/8+((sizey%8)?1:0))*sizey;                    
-  HZnum=sizeof(tfont12)/sizeof(typFNT_GB12);  
-  for(k=0;k<HZnum;k++) 
-  {
-    // 根据utf8_charnum判断对应字节数是否匹配
-    uint8_t match = 1;
-    for (uint8_t m = 0; m < utf8_charnum; m++) 
-    {
-      if (tfont12[k].Index[m] != *(s + m)) 
-      {
-        match = 0;
-        break;
-      }
-    }    
-    if(match)
-    {   
-      for(i=0;i<TypefaceNum;i++)
-      {
-        for(j=0;j<8;j++)
-        {  
-            if(tfont12[k].Msk[i]&(0x01<<j))  Paint_SetPixel(x,y,color);
-            x++;
-            if((x-x0)==sizey)
-            {
-              x=x0;
-              y++;
-              break;
-            }
-        }
-      }
-    }            
-    continue;  
-  }
-} 
+  EPD_ShowChineseUTF8(x,y,s,sizey,color,utf8_charnum);
+}
 
 /**
- * @brief 函数功能：显示汉字，16*16字号
+ * @brief 函数功能：显示汉字，16x16字号
  * 
  * @param x 起始坐标X
  * @param y 起始坐标Y
  * @param s 汉字
  * @param sizey 字号
  * @param color 颜色
+ * @param utf8_charnum 汉字的UTF-8字节数
  */
 void EPD_ShowChinese16x16(uint16_t x,uint16_t y,uint8_t *s,uint8_t sizey,uint16_t color,uint8_t utf8_charnum)
 {
-  uint8_t i,j;
-  uint16_t k;
-  uint16_t HZnum;         //汉字数量
-  uint16_t TypefaceNum;   //一个字符所占字节
-  uint16_t x0=x;
-  TypefaceNum=(sizey/8+((sizey%8)?1:0))*sizey;  //显示16字号需32个字节
-  HZnum=sizeof(tfont16)/sizeof(typFNT_GB16);    //计算字库中汉字数目
-
-  for(k=0;k<HZnum;k++)    //遍历字库
-  {
-    // 根据utf8_charnum判断对应字节数是否匹配
-    uint8_t match = 1;
-    for (uint8_t m = 0; m < utf8_charnum; m++) 
-    {
-      if (tfont16[k].Index[m] != *(s + m)) 
-      {
-        match = 0;
-        break;
-      }
-    }    
-    if(match)
-    {   
-      for(i=0;i<TypefaceNum;i++)  //显示字符
-      {
-        for(j=0;j<8;j++){  
-            if(tfont16[k].Msk[i]&(0x01<<j))  
-              Paint_SetPixel(x,y,color);    //画点
-            x++;
-            if((x-x0)==sizey){    //换行
-              x=x0;
-              y++;
-              break;
-            }
-        }
-      }
-    }            
-    continue;  
-  }
-} 
+  EPD_ShowChineseUTF8(x,y,s,sizey,color,utf8_charnum);
+}
 
 /**
- * @brief 函数功能：显示汉字，24*24字号
+ * @brief 函数功能：显示汉字，24x24字号
  * 
  * @param x 起始坐标X
  * @param y 起始坐标Y
  * @param s 汉字
  * @param sizey 字号
  * @param color 颜色
+ * @param utf8_charnum 汉字的UTF-8字节数
  */
 void EPD_ShowChinese24x24(uint16_t x,uint16_t y,uint8_t *s,uint8_t sizey,uint16_t color,uint8_t utf8_charnum)
 {
-  uint8_t i,j;
-  uint16_t k;
-  uint16_t HZnum;
-  uint16_t TypefaceNum;
-  uint16_t x0=x;
-  TypefaceNum=(sizey/8+((sizey%8)?1:0))*sizey;
-  HZnum=sizeof(tfont24)/sizeof(typFNT_GB24);  
-  for(k=0;k<HZnum;k++) 
-  {
-    // 根据utf8_charnum判断对应字节数是否匹配
-    uint8_t match = 1;
-    for (uint8_t m = 0; m < utf8_charnum; m++) 
-    {
-      if (tfont24[k].Index[m] != *(s + m)) 
-      {
-        match = 0;
-        break;
-      }
-    }    
-    if(match)
-    {   
-      for(i=0;i<TypefaceNum;i++)
-      {
-        for(j=0;j<8;j++)
-        {  
-          if(tfont24[k].Msk[i]&(0x01<<j))  Paint_SetPixel(x,y,color);
-          x++;
-          if((x-x0)==sizey)
-          {
-            x=x0;
-            y++;
-            break;
-          }
-        }
-      }
-    }            
-    continue;
-  }
-} 
+  EPD_ShowChineseUTF8(x,y,s,sizey,color,utf8_charnum);
+}
 
 /**
- * @brief 函数功能：显示汉字，32*32字号
+ * @brief 函数功能：显示汉字，32x32字号
  * 
  * @param x 起始坐标X
  * @param y 起始坐标Y
  * @param s 汉字
  * @param sizey 字号
  * @param color 颜色
+ * @param utf8_charnum 汉字的UTF-8字节数
  */
 void EPD_ShowChinese32x32(uint16_t x,uint16_t y,uint8_t *s,uint8_t sizey,uint16_t color,uint8_t utf8_charnum)
 {
-  uint8_t i,j;
-  uint16_t k;
-  uint16_t HZnum;
-  uint16_t TypefaceNum;
-  uint16_t x0=x;
-  TypefaceNum=(sizey/8+((sizey%8)?1:0))*sizey;
-  HZnum=sizeof(tfont32)/sizeof(typFNT_GB32);  
-  for(k=0;k<HZnum;k++) 
-  {
-    // 根据utf8_charnum判断对应字节数是否匹配
-    uint8_t match = 1;
-    for (uint8_t m = 0; m < utf8_charnum; m++) 
-    {
-      if (tfont32[k].Index[m] != *(s + m)) 
-      {
-        match = 0;
-        break;
-      }
-    }    
-    if(match)
-    {   
-      for(i=0;i<TypefaceNum;i++)
-      {
-        for(j=0;j<8;j++)
-        {  
-            if(tfont32[k].Msk[i]&(0x01<<j))  Paint_SetPixel(x,y,color);
-            x++;
-            if((x-x0)==sizey)
-            {
-              x=x0;
-              y++;
-              break;
-            }
-        }
-      }
-      break; 
-    }
-  }
+  EPD_ShowChineseUTF8(x,y,s,sizey,color,utf8_charnum);
 }
 
 /**
@@ -766,22 +990,9 @@ void EPD_ShowFourColorPicture(uint16_t x,uint16_t y,uint16_t sizex,uint16_t size
 }
 
 // 将bitmap字模数据 绘制到画布缓冲区
+// 字模按位连续存放，高位在左，每行 width 位，行与行之间不补齐
 void DrawBitmapToBuffer(uint16_t x, uint16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, uint16_t color)
 {
-    uint16_t x0 = x;
-    uint16_t SizeNum = (width / 8 + ((width % 8) ? 1 : 0)) * height;    // 计算该字符需要的字节数
-
-    for(uint8_t i=0;i<SizeNum;i++){             // 遍历字节数组
-        for(uint8_t j=0;j<8;j++){               // 遍历每个字节的位
-            if(bitmap[i]&(0x80>>j)){
-                Paint_SetPixel(x, y, color);    //画点
-            }  
-            x++;
-            if((x-x0)==width){                  //换行
-                x=x0;
-                y++;
-            }
-        }
-    }
+    Paint_DrawMono(x, y, bitmap, width, height, width, 0, color);
 }
 
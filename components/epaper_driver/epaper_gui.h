@@ -2,7 +2,7 @@
  * @file epaper_gui.h
  * @author liying (respire_ly@qq.com)
  * @brief 墨水屏GUI驱动
- * @version 1.0
+ * @version 1.4
  * @date 2025-04-18
  * 
  * @copyright Copyright (c) 2025  freelance
@@ -11,6 +11,10 @@
  * | Date | Version | Author | Description |
  * | --- | --- | --- | --- |
  * | 2025-04-18 | 1.0 | liying | 墨水屏GUI驱动 |
+ * | 2026-10-18 | 1.1 | liying | 增加按行/列填充的span绘制，矩形、清屏、字模按字节写入 |
+ * | 2026-10-18 | 1.2 | liying | 画布创建时算好旋转后的起点和步长，画点、画字模不再逐点判断方向 |
+ * | 2026-10-18 | 1.3 | liying | 记录画过的区域（脏区域），用于局部上传 |
+ * | 2026-10-18 | 1.4 | liying | 去掉脏区域，屏幕不再局部上传 |
  */
 
 #ifndef EPAPER_GUI_H
@@ -42,6 +46,11 @@ typedef struct {
 	uint16_t rotate;		/**< 显示方向 */
 	uint16_t widthByte;		/**< widthByte =  widthMemory/4，如果有余数再加一个字节来存储 */
 	uint16_t heightByte;	/**< heightByte = heightMemory */
+	int32_t origin;			/**< 逻辑坐标(0,0)在内存中的像素序号，像素序号 = X + Y*widthByte*4 */
+	int32_t xStride;		/**< 逻辑X加1时像素序号的增量 */
+	int32_t yStride;		/**< 逻辑Y加1时像素序号的增量 */
+	uint16_t xLimit;		/**< 逻辑X的范围 [0,xLimit) */
+	uint16_t yLimit;		/**< 逻辑Y的范围 [0,yLimit) */
 }PAINT;
 
 extern PAINT Paint;
@@ -58,6 +67,27 @@ void Paint_NewImage(uint8_t *image,uint16_t Width,uint16_t Height,uint16_t Rotat
 /** @brief  函数功能：设置某个坐标像素点的颜色 */
 void Paint_SetPixel(uint16_t Xpoint,uint16_t Ypoint,uint16_t Color);
 
+/**
+ * @brief 函数功能：颜色扩展为一个字节的4个像素，用于整字节填充
+ * @param Color 颜色，0~3
+ */
+static inline uint8_t Paint_ColorPattern(uint8_t Color)
+{
+	return (Color&0x03)*0x55;
+}
+
+/** @brief  函数功能：填充实心矩形，坐标均包含，越界部分自动裁剪 */
+void Paint_FillRect(int x0,int y0,int x1,int y1,uint8_t Color);
+
+/** @brief  函数功能：画水平线段 */
+void Paint_DrawHSpan(int x,int y,int len,uint8_t Color);
+
+/** @brief  函数功能：画竖直线段 */
+void Paint_DrawVSpan(int x,int y,int len,uint8_t Color);
+
+/** @brief  函数功能：把单色位图画到画布上，为1的位画成 Color，为0的位不改变 */
+void Paint_DrawMono(int x,int y,const uint8_t *bits,int w,int h,uint32_t row_bits,uint8_t lsb_first,uint8_t Color);
+
 /** @brief  函数功能：清除画布 */
 void Paint_Clear(uint8_t Color);
 
@@ -112,5 +142,8 @@ void DrawBitmapToBuffer(uint16_t x, uint16_t y, const uint8_t *bitmap, uint8_t w
 // 函数功能：获取UTF-8字符长度
 int get_utf8_char_length(uint8_t first_byte);
 
+/** @brief  函数功能：解码一个UTF-8字符，len 返回字节数，无效编码时为0 */
+uint32_t EPD_UTF8_Decode(const char *s, int *len);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * @file epaper_panel.h
+ * @author liying (respire_ly@qq.com)
+ * @brief 墨水屏面板统一接口，每种屏幕一个实现
+ * @version 1.4
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 墨水屏面板统一接口 |
+ * | 2026-10-18 | 1.1 | liying | 增加 begin_partial、erase_rect，支持只重画变化的部分 |
+ * | 2026-10-18 | 1.2 | liying | flush 返回画面是否变化，未变化时不刷新 |
+ * | 2026-10-18 | 1.3 | liying | MCU深度睡眠前调用 sleep |
+ * | 2026-10-18 | 1.4 | liying | 去掉没有调用的 begin_partial、erase_rect、write_window，画面变化由 flush 比较 |
+ *
+ * @par 使用方法
+ * 上层只通过 EPD_PANEL_OPS 操作屏幕，不再直接调用 EPD_* / QY_SSD1680_* 函数：<br>
+ * begin_frame → draw_glyph（多次）→ flush → refresh_async → wait_done → sleep<br>
+ * flush 返回0表示画面与上次显示的相同，此时跳过 refresh_async、wait_done 和 sleep<br>
+ * 新增屏幕时实现一个 EPD_PANEL_OPS 并加入 main/display/epaper_display.c 的列表即可，
+ * 语录抓取代码不需要改动
+ */
+
+#ifndef EPAPER_PANEL_H
+#define EPAPER_PANEL_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @name 面板能力位
+ * @{
+ */
+#define EPD_PANEL_CAP_FRAMEBUFFER  (1 << 0)   /**< 先画到MCU里的整帧画布，flush 时一次发送 */
+#define EPD_PANEL_CAP_PARTIAL      (1 << 2)   /**< 支持局部刷新 */
+#define EPD_PANEL_CAP_4COLOR       (1 << 3)   /**< 黑白红黄4色 */
+#define EPD_PANEL_CAP_GRAY4        (1 << 4)   /**< 4灰阶 */
+/** @} */
+
+/**
+ * @brief 结构体：面板操作接口
+ * @details 不支持的操作填NULL，调用前先看 caps
+ */
+typedef struct {
+	const char *model;		/**< 服务器下发的 screen_model，如 "zjy_3.52_4colors" */
+	const char *name;		/**< 日志里显示的名称 */
+	uint16_t width;			/**< 显示宽度（像素），即 placements 坐标系的宽 */
+	uint16_t height;		/**< 显示高度（像素） */
+	uint32_t caps;			/**< EPD_PANEL_CAP_* 组合 */
+
+	/** 准备新的一帧（清画布或清屏），有画布的屏幕可以推迟到 flush 再初始化 */
+	void (*begin_frame)(void);
+	/** 在 (x,y) 画一个单色字模，bitmap 为 w*h/8 字节，1为前景 */
+	void (*draw_glyph)(int x, int y, const uint8_t *bitmap, int w, int h);
+	/** 把画布与上次显示的画面比较后发送到控制器RAM，返回0表示未变化、不需要刷新；没有画布的屏幕为NULL */
+	uint8_t (*flush)(void);
+	/** 启动刷新后立即返回，完成时置位 EPD_BUS_IDLE_BIT */
+	void (*refresh_async)(void);
+	/** 等待 refresh_async 启动的刷新完成 */
+	esp_err_t (*wait_done)(uint32_t timeout_ms);
+	/** 进入深度睡眠，MCU深度睡眠前调用；wait_done 已经让控制器睡眠的屏幕为NULL */
+	void (*sleep)(void);
+}EPD_PANEL_OPS;
+
+/** @brief 中景园3.52寸黑白红黄4色屏，实现在 epaper_panel_zjy352.c */
+extern const EPD_PANEL_OPS EPD_Panel_ZJY352;
+
+#endif
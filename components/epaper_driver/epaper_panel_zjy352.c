@@ -0,0 +1,90 @@
+/**
+ * @file epaper_panel_zjy352.c
+ * @author liying (respire_ly@qq.com)
+ * @brief 中景园3.52寸黑白红黄4色屏的面板接口实现
+ * @version 1.5
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 中景园3.52寸4色屏面板接口 |
+ * | 2026-10-18 | 1.1 | liying | 按脏区域只上传变化的窗口，可选局部刷新 |
+ * | 2026-10-18 | 1.2 | liying | 与上次显示的画面逐块比较，未变化时不唤醒屏幕 |
+ * | 2026-10-18 | 1.3 | liying | 变化不连续时分多个窗口上传 |
+ * | 2026-10-18 | 1.4 | liying | 去掉没有调用的 begin_partial、erase_rect；变化到最后不足8列时整屏上传 |
+ * | 2026-10-18 | 1.5 | liying | 去掉窗口上传和局部刷新：每次刷新后屏幕深度睡眠，唤醒后控制器RAM里没有上一帧，只保留未变化时跳过 |
+ */
+
+#include "epaper_panel.h"
+#include "esp_attr.h"
+#include "epaper.h"
+#include "epaper_gui.h"
+#include "epaper_framediff.h"
+
+/** 画布像素数据，17280字节=16.875Kb。放在DMA可访问的内部RAM、4字节对齐，颜色不需要转换时整帧一个DMA事务发完 */
+static DMA_ATTR uint8_t s_canvas[EPD_W*EPD_H/4];
+
+/**
+ * @brief 函数功能：创建画布并清成白色
+ * @details 函数实现：屏幕到 flush 确认画面有变化时才初始化，未变化时不复位屏幕
+ */
+static void ZJY352_BeginFrame(void)
+{
+  Paint_NewImage(s_canvas,EPD_W,EPD_H,0,WHITE);   // 创建画布
+  Paint_Clear(WHITE);                             // 画布清屏
+}
+
+/**
+ * @brief 函数功能：把单色字模画到画布上，前景为黑色
+ */
+static void ZJY352_DrawGlyph(int x, int y, const uint8_t *bitmap, int w, int h)
+{
+  DrawBitmapToBuffer(x, y, bitmap, w, h, BLACK);
+}
+
+/**
+ * @brief 函数功能：与上次显示的画面比较，有变化时把画布发送到SRAM
+ * @details 函数实现：\n
+ * 1、EPD_FrameDiff 逐块比较画布与上次显示的画面，完全相同时直接返回，不初始化屏幕 \n
+ * 2、否则初始化屏幕后整屏发送。每次刷新后屏幕都进入深度睡眠，控制器RAM里没有上一帧，
+ * 变化再少也不能只发送窗口，EPD_DIFF_PARTIAL 与 EPD_DIFF_FULL 的处理相同
+ * @return uint8_t 1：有变化，需要刷新；0：未变化
+ */
+static uint8_t ZJY352_Flush(void)
+{
+  EPD_DIFF_RESULT diff;
+
+  if(EPD_FrameDiff(s_canvas,Paint.widthByte,Paint.heightByte,2,&diff)==EPD_DIFF_SKIP) return 0;
+
+  EPD_Init();
+  EPD_Display(s_canvas);
+  return 1;
+}
+
+/**
+ * @brief 函数功能：等待刷新完成，超时时丢弃上次显示的画面记录，下次整屏刷新
+ */
+static esp_err_t ZJY352_WaitDone(uint32_t timeout_ms)
+{
+  esp_err_t ret=EPD_Update_Wait(timeout_ms);
+
+  if(ret!=ESP_OK) EPD_FrameDiff_Invalidate();
+  return ret;
+}
+
+const EPD_PANEL_OPS EPD_Panel_ZJY352 = {
+  .model         = "zjy_3.52_4colors",
+  .name          = "中景园 3.52寸 黑白红黄4色屏幕",
+  .width         = EPD_H,        // 0度时逻辑X对应内存的行，宽384、高180
+  .height        = EPD_W,
+  .caps          = EPD_PANEL_CAP_FRAMEBUFFER | EPD_PANEL_CAP_4COLOR,
+  .begin_frame   = ZJY352_BeginFrame,
+  .draw_glyph    = ZJY352_DrawGlyph,
+  .flush         = ZJY352_Flush,
+  .refresh_async = EPD_Update_Async,
+  .wait_done     = ZJY352_WaitDone,
+  .sleep         = EPD_DeepSleep,
+};
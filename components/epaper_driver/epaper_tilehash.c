@@ -0,0 +1,183 @@
+/**
+ * @file epaper_tilehash.c
+ * @author liying (respire_ly@qq.com)
+ * @brief 画布分块哈希与比较，纯C实现，不依赖ESP-IDF，可在主机上用合成画面测试
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 画布分块哈希与比较 |
+ */
+
+#include "epaper_tilehash.h"
+#include <string.h>
+
+/** @brief 块哈希初值 */
+#define EPD_TILE_SEED  0x811C9DC5u
+
+/**
+ * @brief 函数功能：把一行中一块的数据并入哈希
+ * @details 函数实现：异或后乘奇数再循环移位，对固定的 h 是 w 的一一映射，
+ * 块内只有一个字变化时哈希一定变化
+ */
+static inline uint32_t EPD_TileMix(uint32_t h, uint32_t w)
+{
+  h=(h^w)*0x9E3779B1u;
+  return (h<<13)|(h>>19);
+}
+
+/**
+ * @brief 函数功能：计算分块几何参数
+ *
+ * @param geom 输出的几何参数
+ * @param width_bytes 画布每行字节数
+ * @param rows 画布行数
+ * @param bits_per_pixel 每像素位数，1或2
+ * @return uint16_t 总块数
+ */
+uint16_t EPD_TileHash_Geom(EPD_TILE_GEOM *geom, uint16_t width_bytes, uint16_t rows, uint8_t bits_per_pixel)
+{
+  geom->width_bytes=width_bytes;
+  geom->rows=rows;
+  geom->px_per_byte=8/bits_per_pixel;
+  geom->tile_bytes=16/geom->px_per_byte;   // 每块16像素宽
+  geom->tiles_x=(width_bytes+geom->tile_bytes-1)/geom->tile_bytes;
+  geom->tiles_y=(rows+EPD_TILE_ROWS-1)/EPD_TILE_ROWS;
+  return geom->tiles_x*geom->tiles_y;
+}
+
+/**
+ * @brief 函数功能：计算画布每块的32位哈希
+ * @details 函数实现：按行顺序读画布，一行中每块的数据一次读成一个32位字并入该块的哈希，
+ * 画布只读一遍，不需要按块跳着读。最右一列不满一块时按实际字节数读
+ *
+ * @param geom 几何参数
+ * @param image 画布数据
+ * @param hash 输出的哈希表，tiles_x*tiles_y 个
+ */
+void EPD_TileHash_Compute(const EPD_TILE_GEOM *geom, const uint8_t *image, uint32_t *hash)
+{
+  uint16_t r,tx,full,tail;
+  uint8_t tb=geom->tile_bytes;
+  uint32_t *h;
+  uint32_t w;
+
+  full=geom->width_bytes/tb;            // 满块数
+  tail=geom->width_bytes-full*tb;       // 最右一块的字节数，0表示没有不满的块
+
+  for(r=0;r<geom->rows;r++)
+  {
+    const uint8_t *p=image+(uint32_t)r*geom->width_bytes;
+
+    h=hash+(r/EPD_TILE_ROWS)*geom->tiles_x;
+    if(r%EPD_TILE_ROWS==0)
+    {
+      for(tx=0;tx<geom->tiles_x;tx++) h[tx]=EPD_TILE_SEED;
+    }
+    if(tb==4)                           // 2bpp，常量长度的memcpy编译成一次非对齐读
+    {
+      for(tx=0;tx<full;tx++,p+=4)
+      {
+        memcpy(&w,p,4);                 // 行首不一定4字节对齐
+        h[tx]=EPD_TileMix(h[tx],w);
+      }
+    }
+    else
+    {
+      for(tx=0;tx<full;tx++,p+=tb)
+      {
+        w=0;
+        memcpy(&w,p,tb);
+        h[tx]=EPD_TileMix(h[tx],w);
+      }
+    }
+    if(tail)
+    {
+      w=0;
+      memcpy(&w,p,tail);
+      h[tx]=EPD_TileMix(h[tx],w);
+    }
+  }
+}
+
+/**
+ * @brief 函数功能：比较两张哈希表，输出变化区域
+ * @details 函数实现：\n
+ * 1、逐行找连续变化的块，与上一行重叠的区域向下延伸，否则新建一个区域 \n
+ * 2、区域数超过 max_rects 时并入最后一个区域 \n
+ * 3、块坐标换算成画布内存的像素坐标，最右、最下的块按画布边界截断
+ *
+ * @param geom 几何参数
+ * @param old_hash 上次的哈希表，为NULL时所有块都算变化
+ * @param new_hash 本次的哈希表
+ * @param rects 输出的变化区域
+ * @param max_rects rects 的容量，至少为1
+ * @param rect_count 输出的区域个数
+ * @return uint16_t 变化的块数
+ */
+uint16_t EPD_TileHash_Diff(const EPD_TILE_GEOM *geom, const uint32_t *old_hash, const uint32_t *new_hash,
+                           EPD_TILE_RECT *rects, uint8_t max_rects, uint8_t *rect_count)
+{
+  uint16_t tx,ty,a,n=0,changed=0;
+  uint8_t k,count=0;
+  uint16_t tile_px=geom->tile_bytes*geom->px_per_byte;
+
+  for(ty=0;ty<geom->tiles_y;ty++)
+  {
+    for(tx=0;tx<geom->tiles_x;)
+    {
+      if(old_hash&&old_hash[n+tx]==new_hash[n+tx])
+      {
+        tx++;
+        continue;
+      }
+      for(a=tx;tx<geom->tiles_x&&!(old_hash&&old_hash[n+tx]==new_hash[n+tx]);tx++) changed++;
+
+      // 连续变化的块 [a,tx-1]，先找上一行延伸下来的区域（块坐标）
+      for(k=0;k<count;k++)
+      {
+        if(rects[k].Y1+1>=ty&&rects[k].X0<=tx-1&&rects[k].X1>=a) break;
+      }
+      if(k==count)
+      {
+        if(count<max_rects)
+        {
+          rects[k].X0=a; rects[k].X1=tx-1;
+          rects[k].Y0=ty; rects[k].Y1=ty;
+          count++;
+          continue;
+        }
+        k=count-1;                      // 区域太多，并入最后一个
+      }
+      if(a<rects[k].X0) rects[k].X0=a;
+      if(tx-1>rects[k].X1) rects[k].X1=tx-1;
+      if(ty<rects[k].Y0) rects[k].Y0=ty;
+      if(ty>rects[k].Y1) rects[k].Y1=ty;
+    }
+    n+=geom->tiles_x;
+  }
+
+  for(k=0;k<count;k++)
+  {
+    rects[k].X0*=tile_px;
+    rects[k].X1=(rects[k].X1+1)*tile_px-1;
+    if(rects[k].X1>=geom->width_bytes*geom->px_per_byte) rects[k].X1=geom->width_bytes*geom->px_per_byte-1;
+    rects[k].Y0*=EPD_TILE_ROWS;
+    rects[k].Y1=(rects[k].Y1+1)*EPD_TILE_ROWS-1;
+    if(rects[k].Y1>=geom->rows) rects[k].Y1=geom->rows-1;
+  }
+  *rect_count=count;
+  return changed;
+}
+
+/**
+ * @brief 函数功能：变化区域的面积（像素）
+ */
+uint32_t EPD_TileRect_Area(const EPD_TILE_RECT *rect)
+{
+  return (uint32_t)(rect->X1-rect->X0+1)*(rect->Y1-rect->Y0+1);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file epaper_tilehash.h
+ * @author liying (respire_ly@qq.com)
+ * @brief 画布分块哈希与比较，纯C实现，不依赖ESP-IDF，可在主机上用合成画面测试
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025  freelance
+ *
+ * @par changelog:
+ * | Date | Version | Author | Description |
+ * | --- | --- | --- | --- |
+ * | 2026-10-18 | 1.0 | liying | 画布分块哈希与比较 |
+ *
+ * @par 分块
+ * 每块 EPD_TILE_ROWS 行 × tile_bytes 字节：2bpp画布 tile_bytes=4，1bpp画布 tile_bytes=2，都是16×16像素。
+ * 最右一列块不满 tile_bytes 时按实际字节数计算。哈希表按块的行优先顺序存放，哈希表的保存（RTC内存等）由调用者负责
+ */
+
+#ifndef EPAPER_TILEHASH_H
+#define EPAPER_TILEHASH_H
+
+#include <stdint.h>
+
+/** @brief 每块的行数 */
+#define EPD_TILE_ROWS  16
+
+/** @brief 结构体：分块几何参数 */
+typedef struct {
+	uint16_t width_bytes;	/**< 画布每行字节数 */
+	uint16_t rows;			/**< 画布行数 */
+	uint8_t tile_bytes;		/**< 每块每行的字节数，1~4 */
+	uint8_t px_per_byte;	/**< 每字节像素数，2bpp为4，1bpp为8 */
+	uint16_t tiles_x;		/**< 每行块数 */
+	uint16_t tiles_y;		/**< 块的行数 */
+}EPD_TILE_GEOM;
+
+/** @brief 结构体：变化区域，画布内存坐标（像素列、行），起止都包含 */
+typedef struct {
+	uint16_t X0;
+	uint16_t Y0;
+	uint16_t X1;
+	uint16_t Y1;
+}EPD_TILE_RECT;
+
+/** @brief  函数功能：计算分块几何参数，返回总块数 */
+uint16_t EPD_TileHash_Geom(EPD_TILE_GEOM *geom, uint16_t width_bytes, uint16_t rows, uint8_t bits_per_pixel);
+
+/** @brief  函数功能：计算画布每块的32位哈希 */
+void EPD_TileHash_Compute(const EPD_TILE_GEOM *geom, const uint8_t *image, uint32_t *hash);
+
+/** @brief  函数功能：比较两张哈希表，输出变化区域，返回变化的块数 */
+uint16_t EPD_TileHash_Diff(const EPD_TILE_GEOM *geom, const uint32_t *old_hash, const uint32_t *new_hash,
+                           EPD_TILE_RECT *rects, uint8_t max_rects, uint8_t *rect_count);
+
+/** @brief  函数功能：变化区域的面积（像素） */
+uint32_t EPD_TileRect_Area(const EPD_TILE_RECT *rect);
+
+#endif
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+根据 epaper_font.c 中的汉字字库 tfont12/16/24/32 生成按码点排序的索引 epaper_font_index.c
+
+每个汉字一项：解码后的Unicode码点，以及它在各字号字库中的下标（没有该字号时为 EPD_FONT_NONE），
+按码点升序排列，EPD_Font_Find 对它做二分查找，一次查找得到所有字号的下标。
+同一字号里重复的汉字只保留第一个，与原来的线性查找先画到的那个一致。
+
+用法：gen_font_index.py epaper_font.c epaper_font_index.c
+"""
+
+import re
+import sys
+
+SIZES = (12, 16, 24, 32)
+
+
+def parse_tables(src):
+    """返回 {字号: [汉字, ...]}，按字库中的顺序"""
+    tables = {}
+    for size in SIZES:
+        m = re.search(r'typFNT_GB%d\s+tfont%d\s*\[[^\]]*\]\s*=\s*\{(.*?)\n\}\s*;' % (size, size), src, re.S)
+        if not m:
+            sys.exit('gen_font_index: tfont%d not found' % size)
+        tables[size] = re.findall(r'\{\s*"([^"]+)"\s*,\s*\{', m.group(1))
+    return tables
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: gen_font_index.py epaper_font.c epaper_font_index.c')
+    with open(sys.argv[1], encoding='utf-8') as f:
+        tables = parse_tables(f.read())
+
+    index = {}
+    for slot, size in enumerate(SIZES):
+        for k, ch in enumerate(tables[size]):
+            if len(ch) != 1:
+                sys.exit('gen_font_index: tfont%d[%d] "%s" is not one character' % (size, k, ch))
+            if len(ch.encode('utf-8')) > 4:
+                sys.exit('gen_font_index: tfont%d[%d] longer than 4 bytes' % (size, k))
+            idx = index.setdefault(ord(ch), [None] * len(SIZES))
+            if idx[slot] is None:
+                idx[slot] = k
+            else:
+                print('gen_font_index: duplicate "%s" in tfont%d, keep [%d]' % (ch, size, idx[slot]), file=sys.stderr)
+
+    lines = [
+        '// 由 tools/gen_font_index.py 根据 epaper_font.c 生成，不要手工修改',
+        '#include "epaper_font.h"',
+        '',
+        'const EPD_FONT_INDEX tfont_index[%d]={' % max(len(index), 1),
+    ]
+    for cp in sorted(index):
+        idx = ','.join('EPD_FONT_NONE' if k is None else str(k) for k in index[cp])
+        lines.append('{0x%04X,{%s}},   /* %s */' % (cp, idx, chr(cp)))
+    if not index:
+        lines.append('{0,{EPD_FONT_NONE,EPD_FONT_NONE,EPD_FONT_NONE,EPD_FONT_NONE}},')
+    lines += [
+        '};',
+        '',
+        'const uint16_t tfont_index_num=%d;' % len(index),
+        '',
+    ]
+
+    out = '\n'.join(lines)
+    # 总是写入：输出比输入旧时 CMake 会在每次构建时重新运行这个脚本
+    with open(sys.argv[2], 'w', encoding='utf-8') as f:
+        f.write(out)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,4 +1,7 @@
 #include "qy_ssd1680_epaper.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include "esp_attr.h"
 #include "qy_ssd1680_font.h"
 
 // 4灰阶的波形驱动设置 Waveform Setting，可对照datasheet Figure 6-6
@@ -27,76 +30,61 @@ const unsigned char LUT_DATA_4Gray[159] = {
 // GPIO初始化
 static void QY_SSD1680_GPIOInit(void)
 {
-    gpio_config_t io_conf = {};
-
-    io_conf.pin_bit_mask =  1ULL << QY_SSD1680_GPIO_BUSY;
-    io_conf.mode = GPIO_MODE_INPUT;
-    gpio_config(&io_conf);
-
-    io_conf.pin_bit_mask =  (1ULL << QY_SSD1680_GPIO_RST) | (1ULL << QY_SSD1680_GPIO_DC) | (1ULL << QY_SSD1680_GPIO_CS) | (1ULL << QY_SSD1680_GPIO_SCL) | (1ULL << QY_SSD1680_GPIO_SDA);
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    gpio_config(&io_conf);    
+    EPD_BUS_PINS pins = {
+        .busy = QY_SSD1680_GPIO_BUSY,
+        .rst  = QY_SSD1680_GPIO_RST,
+        .dc   = QY_SSD1680_GPIO_DC,
+        .cs   = QY_SSD1680_GPIO_CS,
+        .scl  = QY_SSD1680_GPIO_SCL,
+        .sda  = QY_SSD1680_GPIO_SDA,
+    };
+
+    EPD_Bus_Init(&pins);
 }
 
-// 忙等待
+// 忙等待：BUSY高电平忙碌，由BUSY中断唤醒，控制器空闲立即返回
 void QY_SSD1680_READBUSY(void)
 { 
-    while(1){	 
-        if(gpio_get_level(QY_SSD1680_GPIO_BUSY)==0) 
-            break;
-         vTaskDelay(10 / portTICK_PERIOD_MS);    
-    }     
+    uint32_t waited_ms;
+
+    if(EPD_Bus_WaitIdle(0, CONFIG_EPD_BUSY_TIMEOUT_MS, &waited_ms)!=ESP_OK){
+        ESP_LOGW("SSD1680", "BUSY timeout after %" PRIu32 " ms", waited_ms);
+        return;
+    }
+    ESP_LOGD("SSD1680", "BUSY released after %" PRIu32 " ms", waited_ms);
 }
 
 // 向总线上写一个字节
 void QY_SSD1680_WR_Bus(unsigned char TxData)
-{				   			 
-	unsigned char TempData;
-	unsigned char scnt;
-	TempData=TxData;
-
-    QY_SSD1680_EPD_SCL_Clr();  
-	for(scnt=0;scnt<8;scnt++){ 
-		if(TempData&0x80){
-            QY_SSD1680_EPD_SDA_Set();
-        }else{
-            QY_SSD1680_EPD_SDA_Clr();
-        }  
-		QY_SSD1680_EPD_SCL_Set();  
-	    QY_SSD1680_EPD_SCL_Clr();  
-		TempData=TempData<<1;
-    }
+{
+    EPD_Bus_WriteData(&TxData, 1);
 }
 
 // 写命令
 void QY_SSD1680_WR_REG(unsigned char cmd)
 {
-	QY_SSD1680_EPD_CS_Set();
-	QY_SSD1680_EPD_CS_Clr();
-	QY_SSD1680_EPD_DC_Clr();  // D/C#   0:command  1:data
-
-	QY_SSD1680_WR_Bus(cmd);
-	QY_SSD1680_EPD_CS_Set();
+    EPD_Bus_WriteCmd(cmd);      // D/C#   0:command  1:data
 }
 
 // 写数据
 void QY_SSD1680_WR_DATA8(unsigned char data)
 {
-	QY_SSD1680_EPD_CS_Set();
-	QY_SSD1680_EPD_CS_Clr();
-	QY_SSD1680_EPD_DC_Set();  // D/C#   0:command  1:data
+    EPD_Bus_WriteData(&data, 1);
+}
 
-	QY_SSD1680_WR_Bus(data);
-	QY_SSD1680_EPD_CS_Set();
+// 写命令+整块数据：写RAM(0x24/0x26)、LUT(0x32)时一次交给总线，不再逐字节切换CS、DC
+void QY_SSD1680_WR_CMD_DATA(unsigned char cmd, const unsigned char *datas, unsigned int len)
+{
+    EPD_Bus_WriteCmdData(cmd, datas, len);
 }
 
 // 硬件复位：RST引脚
 void QY_SSD1680_HW_RESET(void)
 {
     vTaskDelay(20 / portTICK_PERIOD_MS);
-	QY_SSD1680_EPD_RES_Clr();     
+	EPD_Bus_SetRST(0);
 	vTaskDelay(10 / portTICK_PERIOD_MS);  
-	QY_SSD1680_EPD_RES_Set(); 			 
+	EPD_Bus_SetRST(1);			 
 	vTaskDelay(10 / portTICK_PERIOD_MS); 
     QY_SSD1680_READBUSY();
 }
@@ -160,7 +148,6 @@ void QY_SSD1680_Init(void)
 // 4灰阶初始化
 void QY_SSD1680_Init_4GRAY(void)
 {
-    unsigned char i;
 	int XStart,XEnd,YStart_L,YStart_H,YEnd_L,YEnd_H;	
 	
 	XStart=0x00;
@@ -206,11 +193,8 @@ void QY_SSD1680_Init_4GRAY(void)
 	QY_SSD1680_WR_DATA8(LUT_DATA_4Gray[156]);   // VSH2   
 	QY_SSD1680_WR_DATA8(LUT_DATA_4Gray[157]);   // VSL   
    
-    QY_SSD1680_WR_REG(0x32);        // Write LUT register 
-    for(i=0;i<152;i++){
-        QY_SSD1680_WR_DATA8(LUT_DATA_4Gray[i]);
-    }
-        
+    QY_SSD1680_WR_CMD_DATA(0x32, LUT_DATA_4Gray, 152);    // Write LUT register
+
     
 	QY_SSD1680_WR_REG(0x44);        // 设置 RAM X 的起始、结束位置
 	QY_SSD1680_WR_DATA8(XStart);		
@@ -245,14 +229,35 @@ void QY_SSD1680_Update_and_DeepSleep(void)
 
 // 局部刷新并休眠
 void QY_SSD1680_Update_and_DeepSleep_Part(void)
+{
+    QY_SSD1680_Update_Part_Async();
+    QY_SSD1680_Update_Wait_and_DeepSleep(CONFIG_EPD_BUSY_TIMEOUT_MS);
+}
+
+// 启动局部刷新后立即返回，刷新完成时置位 EPD_BUS_IDLE_BIT
+void QY_SSD1680_Update_Part_Async(void)
 {
 	QY_SSD1680_WR_REG(0x22);    // 显示控制2：设置序列
 	QY_SSD1680_WR_DATA8(0xFF);  // 使能时钟、使能模拟、加载温度、显示模式2、失能模拟、失能晶振
 	QY_SSD1680_WR_REG(0x20);    // 激活序列
-	QY_SSD1680_READBUSY(); 	
+	EPD_Bus_StartIdleNotify(0);
+}
+
+// 等待异步刷新完成后进入深度睡眠，超时也会让控制器进入睡眠
+esp_err_t QY_SSD1680_Update_Wait_and_DeepSleep(uint32_t timeout_ms)
+{
+    uint32_t waited_ms;
+    esp_err_t ret = EPD_Bus_WaitIdleNotify(timeout_ms, &waited_ms);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW("SSD1680", "refresh not finished after %" PRIu32 " ms", waited_ms);
+    } else {
+        ESP_LOGI("SSD1680", "refresh finished in %" PRIu32 " ms", waited_ms);
+    }
 
     QY_SSD1680_WR_REG(0x10);    // 进入深度睡眠模式1
-    QY_SSD1680_WR_DATA8(0x01); 	
+    QY_SSD1680_WR_DATA8(0x01); 
+    return ret;
 }
 
 // 4灰阶刷新并休眠
@@ -270,55 +275,33 @@ void QY_SSD1680_Update_and_DeepSleep_4GRAY(void)
 // 清屏
 void QY_SSD1680_Clear(void)
 {
-   unsigned int k;
     QY_SSD1680_WR_REG(0x24);        //写BW RAM，黑0白1
-    for(k=0;k<ALLSCREEN_GRAGHBYTES;k++){
-        QY_SSD1680_WR_DATA8(0xFF);
-    }
+    EPD_Bus_FillData(0xFF, ALLSCREEN_GRAGHBYTES);
 	
     QY_SSD1680_WR_REG(0x26);        //写RED RAM，红1非红0
-    for(k=0;k<ALLSCREEN_GRAGHBYTES;k++){
-        QY_SSD1680_WR_DATA8(0xFF);
-    }	
+    EPD_Bus_FillData(0xFF, ALLSCREEN_GRAGHBYTES);
     QY_SSD1680_Update_and_DeepSleep();
 }
 
 // 显示
 void QY_SSD1680_Display(const unsigned char *datas)
 {
-    unsigned int i;
-    QY_SSD1680_WR_REG(0x24);        //写BW RAM，黑0白1
-    for(i=0;i<ALLSCREEN_GRAGHBYTES;i++){               
-        QY_SSD1680_WR_DATA8(*datas);
-        datas++;
-    }
+    QY_SSD1680_WR_CMD_DATA(0x24, datas, ALLSCREEN_GRAGHBYTES);     //写BW RAM，黑0白1
     QY_SSD1680_Update_and_DeepSleep();	 
 }
 
 // 底图
 void QY_SSD1680_Display_Part_BaseMap(const unsigned char * datas)
 {
-	unsigned int i;   
-	const unsigned char  *datas_flag;   
-	datas_flag=datas;
-    QY_SSD1680_WR_REG(0x24);  // 写BW RAM，黑0白1
-    for(i=0;i<ALLSCREEN_GRAGHBYTES;i++){               
-        QY_SSD1680_WR_DATA8(*datas);
-        datas++;
-    }
-    datas=datas_flag;
-    QY_SSD1680_WR_REG(0x26);   // 写RED RAM，红1非红0
-    for(i=0;i<ALLSCREEN_GRAGHBYTES;i++){               
-        QY_SSD1680_WR_DATA8(*datas);
-        datas++;
-    }
+    QY_SSD1680_WR_CMD_DATA(0x24, datas, ALLSCREEN_GRAGHBYTES);     // 写BW RAM，黑0白1
+    QY_SSD1680_WR_CMD_DATA(0x26, datas, ALLSCREEN_GRAGHBYTES);     // 写RED RAM，红1非红0
     QY_SSD1680_Update_and_DeepSleep();      
 }
 
 // 局部刷新
 void QY_SSD1680_Display_Part(int h_start,int v_start,const unsigned char * datas,int PART_WIDTH,int PART_HEIGHT,unsigned char mode)
 {
-	int i;  
+	int i,n,len;
 	int vend,hstart_H,hstart_L,hend,hend_H,hend_L;
 	
 	v_start=v_start/8;				// X起始坐标		
@@ -349,101 +332,80 @@ void QY_SSD1680_Display_Part(int h_start,int v_start,const unsigned char * datas
 	QY_SSD1680_WR_DATA8(hstart_H);
 	QY_SSD1680_READBUSY();	
 	
-	QY_SSD1680_WR_REG(0x24);        // 写BW RAM，黑0白1
-    for(i=0;i<PART_WIDTH*PART_HEIGHT/8;i++){                         
-        if (mode==POS){             // 正显
-            QY_SSD1680_WR_DATA8(*datas);
-            datas++;
+	len=PART_WIDTH*PART_HEIGHT/8;
+    if (mode==POS){                 // 正显
+        QY_SSD1680_WR_CMD_DATA(0x24, datas, len);      // 写BW RAM，黑0白1
+    }else if (mode==NEG){           // 反显，按块取反后发送
+        unsigned char *buf=EPD_Bus_TxBuffer();
+        QY_SSD1680_WR_REG(0x24);
+        while(len>0){
+            n=len>EPD_BUS_CHUNK_SIZE?EPD_BUS_CHUNK_SIZE:len;
+            for(i=0;i<n;i++){
+                buf[i]=~datas[i];
+            }
+            EPD_Bus_WriteData(buf, n);
+            datas+=n;
+            len-=n;
         }
-        if (mode==NEG){             // 反显
-            QY_SSD1680_WR_DATA8(~(*datas));
-            datas++;
-        }	
-        if (mode==OFF){             // 清除（白色）
-            QY_SSD1680_WR_DATA8(0xFF);
-        }						
+    }else if (mode==OFF){           // 清除（白色）
+        QY_SSD1680_WR_REG(0x24);
+        EPD_Bus_FillData(0xFF, len);
     }
 
 }
 
-// 4灰阶 BW RAM数据处理
-static uint8_t In2bytes_Out1byte_RAM1(uint8_t data1,uint8_t data2)
-{
-    uint8_t i; 
-    uint8_t TempData1,TempData2;
-    uint8_t outdata=0x00;
-    TempData1=data1;
-    TempData2=data2;
-	
-    for(i=0;i<4;i++){ 
-        outdata=outdata<<1;
-        if( ((TempData1&0xC0)==0xC0) || ((TempData1&0xC0)==0x40))
-           outdata=outdata|0x01;
-        else 
-          outdata=outdata|0x00;
-
-        TempData1=TempData1<<2;
-    }
-
-    for(i=0;i<4;i++){ 
-        outdata=outdata<<1;
-         if((TempData2&0xC0)==0xC0||(TempData2&0xC0)==0x40)
-           outdata=outdata|0x01;
-        else 
-          outdata=outdata|0x00;
-
-        TempData2=TempData2<<2;
-    }
-    return outdata;
-}
-
-// 4灰阶 RED RAM数据处理
-static uint8_t In2bytes_Out1byte_RAM2(uint8_t data1,uint8_t data2)
+// 4灰阶拆分表：一个输入字节是4个2位灰度像素，高4位是4个像素的BW位（像素低位），低4位是RED位（像素高位）
+// 像素 11、01 写BW RAM的1，像素 11、10 写RED RAM的1，与原来逐位判断的结果相同
+#define GRAY_BW4(b)     ((((b)>>3)&8)|(((b)>>2)&4)|(((b)>>1)&2)|((b)&1))
+#define GRAY_SPLIT(b)   (GRAY_BW4(b)<<4|GRAY_BW4((b)>>1))
+#define GRAY_SPLIT4(b)  GRAY_SPLIT(b),GRAY_SPLIT((b)+1),GRAY_SPLIT((b)+2),GRAY_SPLIT((b)+3)
+#define GRAY_SPLIT16(b) GRAY_SPLIT4(b),GRAY_SPLIT4((b)+4),GRAY_SPLIT4((b)+8),GRAY_SPLIT4((b)+12)
+#define GRAY_SPLIT64(b) GRAY_SPLIT16(b),GRAY_SPLIT16((b)+16),GRAY_SPLIT16((b)+32),GRAY_SPLIT16((b)+48)
+static const DRAM_ATTR uint8_t gray_split[256] = {GRAY_SPLIT64(0),GRAY_SPLIT64(64),GRAY_SPLIT64(128),GRAY_SPLIT64(192)};
+
+// 4灰阶图片一次拆成BW、RED两个平面，每2个输入字节查2次表得到两个平面各1个字节（已取反，可直接写RAM）
+// bw、red 可以为NULL，只输出另一个平面；len 为每个平面的字节数
+void QY_SSD1680_Split_4GRAY(const unsigned char *datas, unsigned char *bw, unsigned char *red, unsigned int len)
 {
-    uint8_t i; 
-    uint8_t TempData1,TempData2;
-    uint8_t outdata=0x00;
-    TempData1=data1;
-    TempData2=data2;
-	
-    for(i=0;i<4;i++){ 
-        outdata=outdata<<1;
-        if( ((TempData1&0xC0)==0xC0) || ((TempData1&0xC0)==0x80))
-           outdata=outdata|0x01;
-        else 
-          outdata=outdata|0x00;
-
-        TempData1=TempData1<<2;
-    }
-
-    for(i=0;i<4;i++){ 
-        outdata=outdata<<1;
-         if((TempData2&0xC0)==0xC0||(TempData2&0xC0)==0x80)
-           outdata=outdata|0x01;
-        else 
-          outdata=outdata|0x00;
+    unsigned int i;
 
-        TempData2=TempData2<<2;
+    for(i=0;i<len;i++){
+        uint8_t hi=gray_split[datas[2*i]];      // 前4个像素
+        uint8_t lo=gray_split[datas[2*i+1]];    // 后4个像素
+        if(bw)  bw[i] =~((hi&0xF0)|(lo>>4));
+        if(red) red[i]=~((hi<<4)|(lo&0x0F));
     }
-    return outdata;
 }
 
 // 全屏4灰阶刷新
 void QY_SSD1680_Display_4GRAY(const unsigned char *datas)
 {
-    unsigned int i;
-	uint8_t tempOriginal;   
-	
-    QY_SSD1680_WR_REG(0x24);   // 写BW RAM，黑0白1
-    for(i=0;i<ALLSCREEN_GRAGHBYTES*2;i+=2){               
-        tempOriginal= In2bytes_Out1byte_RAM1( *(datas+i),*(datas+i+1));
-        QY_SSD1680_WR_DATA8(~tempOriginal); 
-    }
-	 
-	QY_SSD1680_WR_REG(0x26);   // 写RED RAM，红1非红0
-    for(i=0;i<ALLSCREEN_GRAGHBYTES*2;i+=2){               
-        tempOriginal= In2bytes_Out1byte_RAM2( *(datas+i),*(datas+i+1));
-        QY_SSD1680_WR_DATA8(~tempOriginal); 
+    unsigned char *planes=malloc(ALLSCREEN_GRAGHBYTES*2);
+
+    if(planes){                 // 一遍拆出两个平面，各一次整块发送
+        QY_SSD1680_Split_4GRAY(datas, planes, planes+ALLSCREEN_GRAGHBYTES, ALLSCREEN_GRAGHBYTES);
+        QY_SSD1680_WR_CMD_DATA(0x24, planes, ALLSCREEN_GRAGHBYTES);                         // 写BW RAM，黑0白1
+        QY_SSD1680_WR_CMD_DATA(0x26, planes+ALLSCREEN_GRAGHBYTES, ALLSCREEN_GRAGHBYTES);    // 写RED RAM，红1非红0
+        free(planes);
+    }else{                      // 内存不够时每个平面拆到暂存缓冲区分块发送
+        unsigned int i,n;
+
+        ESP_LOGW("SSD1680", "4GRAY planes alloc failed, split in chunks");
+        QY_SSD1680_WR_REG(0x24);   // 写BW RAM，黑0白1
+        for(i=0;i<ALLSCREEN_GRAGHBYTES;i+=n){
+            n=ALLSCREEN_GRAGHBYTES-i>EPD_BUS_CHUNK_SIZE?EPD_BUS_CHUNK_SIZE:ALLSCREEN_GRAGHBYTES-i;
+            unsigned char *buf=EPD_Bus_StreamBuffer();
+            QY_SSD1680_Split_4GRAY(datas+2*i, buf, NULL, n);
+            EPD_Bus_StreamSend(n);
+        }
+        QY_SSD1680_WR_REG(0x26);   // 写RED RAM，红1非红0
+        for(i=0;i<ALLSCREEN_GRAGHBYTES;i+=n){
+            n=ALLSCREEN_GRAGHBYTES-i>EPD_BUS_CHUNK_SIZE?EPD_BUS_CHUNK_SIZE:ALLSCREEN_GRAGHBYTES-i;
+            unsigned char *buf=EPD_Bus_StreamBuffer();
+            QY_SSD1680_Split_4GRAY(datas+2*i, NULL, buf, n);
+            EPD_Bus_StreamSend(n);
+        }
+        EPD_Bus_StreamFlush();
     }
 	 
    QY_SSD1680_Update_and_DeepSleep_4GRAY();    // 4灰阶刷新并休眠
@@ -8,6 +8,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "epaper_bus.h"
+#include "epaper_panel.h"
 
 #define QY_SSD1680_GPIO_BUSY   35      
 #define QY_SSD1680_GPIO_RST    22      
@@ -16,16 +18,7 @@
 #define QY_SSD1680_GPIO_SCL    18
 #define QY_SSD1680_GPIO_SDA    19  
 
-#define QY_SSD1680_EPD_SCL_Clr() 	gpio_set_level(QY_SSD1680_GPIO_SCL, 0);
-#define QY_SSD1680_EPD_SCL_Set() 	gpio_set_level(QY_SSD1680_GPIO_SCL, 1);
-#define QY_SSD1680_EPD_SDA_Clr() 	gpio_set_level(QY_SSD1680_GPIO_SDA, 0);
-#define QY_SSD1680_EPD_SDA_Set() 	gpio_set_level(QY_SSD1680_GPIO_SDA, 1);
-#define QY_SSD1680_EPD_RES_Clr() 	gpio_set_level(QY_SSD1680_GPIO_RST, 0);
-#define QY_SSD1680_EPD_RES_Set() 	gpio_set_level(QY_SSD1680_GPIO_RST, 1);
-#define QY_SSD1680_EPD_DC_Clr() 	gpio_set_level(QY_SSD1680_GPIO_DC, 0);
-#define QY_SSD1680_EPD_DC_Set() 	gpio_set_level(QY_SSD1680_GPIO_DC, 1);
-#define QY_SSD1680_EPD_CS_Clr() 	gpio_set_level(QY_SSD1680_GPIO_CS, 0);  
-#define QY_SSD1680_EPD_CS_Set() 	gpio_set_level(QY_SSD1680_GPIO_CS, 1);   
+// 引脚电平的读写都在 epaper_bus.c 里，与中景园4色屏共用，SPI+DMA 或 GPIO 模拟时序由 menuconfig 选择
 
 // 显示模式选择
 #define POS     1       // 正显
@@ -40,6 +33,7 @@ void QY_SSD1680_READBUSY(void);                     // 忙等待
 void QY_SSD1680_WR_Bus(unsigned char TxData);       // 向总线上写一个字节
 void QY_SSD1680_WR_REG(unsigned char cmd);          // 写命令
 void QY_SSD1680_WR_DATA8(unsigned char data);       // 写数据
+void QY_SSD1680_WR_CMD_DATA(unsigned char cmd, const unsigned char *datas, unsigned int len);   // 写命令+整块数据
 
 void QY_SSD1680_HW_RESET(void);                     // 硬件复位：RST引脚
 void QY_SSD1680_Init(void);                         // 无灰阶初始化
@@ -48,12 +42,17 @@ void QY_SSD1680_Init_4GRAY(void);                   // 4灰阶初始化
 void QY_SSD1680_Update_and_DeepSleep_Part(void);    // 局部刷新并休眠
 void QY_SSD1680_Update_and_DeepSleep(void);         // 全屏刷新并休眠
 void QY_SSD1680_Update_and_DeepSleep_4GRAY(void);   // 4灰阶刷新并休眠
+void QY_SSD1680_Update_Part_Async(void);            // 启动局部刷新后立即返回，完成时置位 EPD_BUS_IDLE_BIT
+esp_err_t QY_SSD1680_Update_Wait_and_DeepSleep(uint32_t timeout_ms);    // 等待异步刷新完成并休眠
+
+extern const EPD_PANEL_OPS QY_SSD1680_Panel;        // 面板接口，实现在 qy_ssd1680_panel.c
 
 void QY_SSD1680_Clear(void);                        // 清屏
 void QY_SSD1680_Display(const unsigned char *datas);        // 显示(无灰阶)
 void QY_SSD1680_Display_Part_BaseMap(const unsigned char * datas);
 void QY_SSD1680_Display_Part(int h_start,int v_start,const unsigned char * datas,int PART_WIDTH,int PART_HEIGHT,unsigned char mode);
 void QY_SSD1680_Display_4GRAY(const unsigned char *datas);  // 显示(4灰阶)
+void QY_SSD1680_Split_4GRAY(const unsigned char *datas, unsigned char *bw, unsigned char *red, unsigned int len);  // 4灰阶图片拆成BW、RED两个平面
 
 void test_qy_ssd1680_epaper(void);                  // 屏幕测试函数
 
@@ -0,0 +1,88 @@
+// 奇耘2.9寸黑白屏的面板接口实现
+#include <string.h>
+#include "qy_ssd1680_epaper.h"
+#include "ssd1680_epaper.h"
+#include "epaper_panel.h"
+#include "epaper_framediff.h"
+#include "esp_attr.h"
+
+// 1bpp画布，按控制器RAM的顺序存放：每行16字节对应竖直方向128像素，共296行对应水平方向，4736字节
+// 行号就是 placements 的x，行内字节是y/8，与 QY_SSD1680_Display_Part 写入的字模格式相同
+static DMA_ATTR uint8_t s_canvas[ALLSCREEN_GRAGHBYTES];
+
+// 创建画布并清成白色，屏幕到 flush 确认画面有变化时才初始化
+static void QY290_BeginFrame(void)
+{
+    SSD1680_Paint_NewImage(s_canvas, EPD_HEIGHT, EPD_WIDTH, SSD1680_ROTATE_270, SSD1680_WHITE);
+    SSD1680_Clear(SSD1680_WHITE);
+}
+
+// 字模合成到画布，覆盖原来的内容，与 Display_Part 正显的效果相同
+// data 为 w 行、每行 h/8 字节，与 Display_Part 一样 y 按8像素对齐
+static void QY290_DrawGlyph(int x, int y, const uint8_t *data, int w, int h)
+{
+    int col_bytes = h / 8;                      // 字模每行字节数
+    int v = y / 8;                              // 画布行内起始字节
+    int n = col_bytes;
+    int skip = 0;
+
+    if (v < 0) {                                // 上边超出画布
+        skip = -v;
+        n -= skip;
+        v = 0;
+    }
+    if (v + n > SSD1680_Paint.WidthByte) {      // 下边超出画布
+        n = SSD1680_Paint.WidthByte - v;
+    }
+    if (n <= 0) {
+        return;
+    }
+
+    for (int c = 0; c < w; c++) {
+        int row = x + c;
+        if (row < 0 || row >= SSD1680_Paint.HeightByte) {
+            continue;
+        }
+        uint8_t *dst = SSD1680_Paint.Image + row * SSD1680_Paint.WidthByte + v;
+        memcpy(dst, data + c * col_bytes + skip, n);
+    }
+}
+
+// 画布与上次显示的画面比较，有变化时初始化、清屏，再用一次窗口写入整帧
+// 返回：   1,有变化；0,未变化，不需要刷新
+static uint8_t QY290_Flush(void)
+{
+    if (EPD_FrameDiff(s_canvas, SSD1680_Paint.WidthByte, SSD1680_Paint.HeightByte, 1, NULL) == EPD_DIFF_SKIP) {
+        return 0;
+    }
+    QY_SSD1680_Init();          // 墨水屏初始化
+    QY_SSD1680_Clear();         // 清屏
+    QY_SSD1680_HW_RESET();      // 复位唤醒控制器
+    QY_SSD1680_Display_Part(0, 0, s_canvas, EPD_WIDTH, EPD_HEIGHT, POS);  // 整屏一个窗口，一次设置、一次发送
+    return 1;
+}
+
+// 刷新完成后控制器直接进入深度睡眠，超时时丢弃上次显示的画面记录
+static esp_err_t QY290_WaitDone(uint32_t timeout_ms)
+{
+    esp_err_t ret = QY_SSD1680_Update_Wait_and_DeepSleep(timeout_ms);
+
+    if (ret != ESP_OK) {
+        EPD_FrameDiff_Invalidate();
+    }
+    return ret;
+}
+
+const EPD_PANEL_OPS QY_SSD1680_Panel = {
+    .model         = "qy_2.9_2colors",
+    .name          = "奇耘 2.9寸 黑白屏幕",
+    .width         = EPD_WIDTH,
+    .height        = EPD_HEIGHT,
+    .caps          = EPD_PANEL_CAP_FRAMEBUFFER | EPD_PANEL_CAP_PARTIAL | EPD_PANEL_CAP_GRAY4,
+    .begin_frame   = QY290_BeginFrame,
+    .draw_glyph    = QY290_DrawGlyph,       // 先合成到画布，flush 时一次写入
+    .flush         = QY290_Flush,
+    .refresh_async = QY_SSD1680_Update_Part_Async,
+    .wait_done     = QY290_WaitDone,
+    .sleep         = NULL,                  // wait_done 已让控制器进入深度睡眠
+};
@@ -1,80 +1,61 @@
 #include "ssd1680_epaper.h"
+#include <inttypes.h>
+#include "esp_log.h"
 #include "../epaper_driver/epaper_font.h"
 
 
 SSD1680_PAINT SSD1680_Paint;
 
-// 初始化 GPIO 引脚
+// 初始化 GPIO 引脚，引脚和总线交给 epaper_bus
 void SSD1680_GPIOInit(void)
 {
-    gpio_config_t io_conf = {};
-
-    io_conf.pin_bit_mask =  1ULL << SSD1680_GPIO_BUSY;
-    io_conf.mode = GPIO_MODE_INPUT;
-    gpio_config(&io_conf);
-
-    io_conf.pin_bit_mask =  (1ULL << SSD1680_GPIO_RST) | (1ULL << SSD1680_GPIO_DC) | (1ULL << SSD1680_GPIO_CS) | (1ULL << SSD1680_GPIO_SCL) | (1ULL << SSD1680_GPIO_SDA);
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    gpio_config(&io_conf);    
+    EPD_BUS_PINS pins = {
+        .busy = SSD1680_GPIO_BUSY,
+        .rst  = SSD1680_GPIO_RST,
+        .dc   = SSD1680_GPIO_DC,
+        .cs   = SSD1680_GPIO_CS,
+        .scl  = SSD1680_GPIO_SCL,
+        .sda  = SSD1680_GPIO_SDA,
+    };
+
+    EPD_Bus_Init(&pins);
 }
 
 // 向总线上写入一个字节的数据
 void SSD1680_WR_Bus(uint8_t dat)  
 {
-	uint8_t i;
-
-	SSD1680_EPD_CS_Clr();           // 拉低CS
-
-	for(i=0;i<8;i++){               // 1个字节的8个位，从最高位开始传输
-		SSD1680_EPD_SCL_Set();      // 时钟SCL拉低
-    if(dat&0x80){                   // 显示数据SDA
-			SSD1680_EPD_SDA_Set();      
-		}else{
-			SSD1680_EPD_SDA_Clr();
-		}
-		SSD1680_EPD_SCL_Set();      // 制造SCL上升沿
-		dat<<=1;
-	}
-
-	SSD1680_EPD_CS_Set();	        // 拉高CS    
+    EPD_Bus_WriteData(&dat, 1);
 }
 
 // 向墨水屏写入指令-Command
 void SSD1680_WR_REG(uint8_t reg)  
 {
-	SSD1680_EPD_DC_Clr();
-	SSD1680_WR_Bus(reg);
-	SSD1680_EPD_DC_Set();  
+    EPD_Bus_WriteCmd(reg);
 }
 
 // 向墨水屏写入 8 位数据-Parameter
 void SSD1680_WR_DATA8(uint8_t dat)
 {
-    SSD1680_EPD_DC_Set();
-    SSD1680_WR_Bus(dat);
-    SSD1680_EPD_DC_Set();       // 其实这句是可以省略的，但是对应上面写指令的代码，没有去掉
+    EPD_Bus_WriteData(&dat, 1);
 }
 
-// 读取并等待墨水屏的忙碌状态
+// 读取并等待墨水屏的忙碌状态：BUSY高电平忙碌，由BUSY中断唤醒
 void SSD1680_READBUSY(void)
 {
-  while(1)
-  {
-    if(gpio_get_level(SSD1680_GPIO_BUSY)==0)
-    {
-      break;
+    uint32_t waited_ms;
+
+    if(EPD_Bus_WaitIdle(0, CONFIG_EPD_BUSY_TIMEOUT_MS, &waited_ms)!=ESP_OK){
+        ESP_LOGW("SSD1680", "BUSY timeout after %" PRIu32 " ms", waited_ms);
     }
-    vTaskDelay(10 / portTICK_PERIOD_MS);    
-  }
 }
 
 // 对墨水屏进行硬件复位操作
 void SSD1680_HW_RESET(void)
 {
     vTaskDelay(100 / portTICK_PERIOD_MS);
-    SSD1680_EPD_RES_Clr();
+    EPD_Bus_SetRST(0);
     vTaskDelay(20 / portTICK_PERIOD_MS);  // 至少10ms
-    SSD1680_EPD_RES_Set();
+    EPD_Bus_SetRST(1);
     vTaskDelay(20 / portTICK_PERIOD_MS);  // 至少10ms
     SSD1680_READBUSY();
     SSD1680_WR_REG(0x12);  //SWRESET
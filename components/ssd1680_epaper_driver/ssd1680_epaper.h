@@ -7,6 +7,7 @@
 #include "sdkconfig.h"   
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "epaper_bus.h"
 
 // GPIO 定义
 #define SSD1680_GPIO_BUSY   35      
@@ -17,16 +18,7 @@
 #define SSD1680_GPIO_SDA    19  
 
 
-#define SSD1680_EPD_SCL_Clr() 	gpio_set_level(SSD1680_GPIO_SCL, 0);
-#define SSD1680_EPD_SCL_Set() 	gpio_set_level(SSD1680_GPIO_SCL, 1);
-#define SSD1680_EPD_SDA_Clr() 	gpio_set_level(SSD1680_GPIO_SDA, 0);
-#define SSD1680_EPD_SDA_Set() 	gpio_set_level(SSD1680_GPIO_SDA, 1);
-#define SSD1680_EPD_RES_Clr() 	gpio_set_level(SSD1680_GPIO_RST, 0);
-#define SSD1680_EPD_RES_Set() 	gpio_set_level(SSD1680_GPIO_RST, 1);
-#define SSD1680_EPD_DC_Clr() 	gpio_set_level(SSD1680_GPIO_DC, 0);
-#define SSD1680_EPD_DC_Set() 	gpio_set_level(SSD1680_GPIO_DC, 1);
-#define SSD1680_EPD_CS_Clr() 	gpio_set_level(SSD1680_GPIO_CS, 0);  
-#define SSD1680_EPD_CS_Set() 	gpio_set_level(SSD1680_GPIO_CS, 1);   
+// 引脚电平的读写都在 epaper_bus.c 里
 
 
 #define SSD1680_W   128
@@ -10,6 +10,9 @@
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "driver/rtc_io.h"
 
 void print_chip_info(void) {
     ESP_LOGI("BUILD", "%s", BUILD_ID);          
@@ -76,4 +79,17 @@ void memory_monitor_task(void *pvParameters)
 }
 void start_memory_monitor_task(void) {
     xTaskCreate(memory_monitor_task, "MemoryMonitor", 2048, NULL, 5, NULL);
-}
\ No newline at end of file
+}
+
+
+void enter_deep_sleep(uint64_t sleep_us) {
+    ESP_LOGI("sleep", "开始深度睡眠");
+
+    rtc_gpio_deinit(WAKE_PIN);              // 切换为RTC模式
+    gpio_reset_pin(WAKE_PIN);               // 复位GPIO配置
+    rtc_gpio_init(WAKE_PIN);                // 初始化RTC引脚
+    rtc_gpio_set_direction(WAKE_PIN, RTC_GPIO_MODE_INPUT_ONLY); // 输入模式
+    esp_sleep_enable_ext0_wakeup(WAKE_PIN , 0);                 // 34号引脚低电平唤醒
+    esp_sleep_enable_timer_wakeup(sleep_us);                    // 定时唤醒
+    esp_deep_sleep_start();
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <stdint.h>
+
+#define WAKE_PIN    34          // 34号引脚用于外部唤醒（连接按键）
+
 void print_chip_info(void);
 void init_nvs(void);
 
 void start_memory_monitor_task(void);
 
+// 配置按键和定时唤醒后进入深度睡眠，不返回
+void enter_deep_sleep(uint64_t sleep_us);
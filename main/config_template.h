@@ -5,3 +5,9 @@
 #define WIFI_PASS      "your_wifi_password"
 
 #define API_URL        "http://your.server.ip/api"
+
+// 可选：固定IP，定义后不走DHCP，深度睡眠唤醒时连接更快（不定义时唤醒后沿用上次DHCP拿到的IP，最多12小时）
+// #define WIFI_STATIC_IP       "192.168.1.50"
+// #define WIFI_STATIC_NETMASK  "255.255.255.0"
+// #define WIFI_STATIC_GW       "192.168.1.1"
+// #define WIFI_STATIC_DNS      "192.168.1.1"
@@ -0,0 +1,255 @@
+#include "epaper_display.h"
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "epaper_framediff.h"
+#include "glyph_map.h"
+#include "epaper_gui.h"
+#include "font_store.h"
+#include "glyph_cache.h"
+#include "qy_ssd1680_epaper.h"
+
+#define TAG "EPD"
+
+// 支持的面板，menuconfig 固定面板时只链接对应的实现
+static const EPD_PANEL_OPS *const panels[] = {
+#if CONFIG_EPD_PANEL_AUTO || CONFIG_EPD_PANEL_ZJY352
+    &EPD_Panel_ZJY352,
+#endif
+#if CONFIG_EPD_PANEL_AUTO || CONFIG_EPD_PANEL_QY290
+    &QY_SSD1680_Panel,
+#endif
+};
+
+// 已启动、尚未等待完成的刷新
+static const EPD_PANEL_OPS *pending_panel = NULL;
+
+const EPD_PANEL_OPS *epaper_display_resolve_panel(const char *screen_model) {
+#if CONFIG_EPD_PANEL_AUTO
+    static const EPD_PANEL_OPS *last_panel = NULL;     // 同一设备每次都是同一块屏，先比上一次的结果
+
+    if (screen_model == NULL) {
+        return NULL;
+    }
+    if (last_panel && strcmp(screen_model, last_panel->model) == 0) {
+        return last_panel;
+    }
+    for (size_t i = 0; i < sizeof(panels) / sizeof(panels[0]); i++) {
+        if (strcmp(screen_model, panels[i]->model) == 0) {
+            last_panel = panels[i];
+            return last_panel;
+        }
+    }
+    return NULL;
+#else
+    if (screen_model && strcmp(screen_model, panels[0]->model) != 0) {
+        ESP_LOGW(TAG, "服务器屏幕型号 %s 与配置的 %s 不一致，按配置显示", screen_model, panels[0]->model);
+    }
+    return panels[0];
+#endif
+}
+
+// 上一次显示内容的指纹，放在RTC内存，深度睡眠后保留
+static RTC_DATA_ATTR uint32_t last_fingerprint;
+static RTC_DATA_ATTR uint32_t last_fingerprint_valid;     // 等于 FINGERPRINT_MAGIC 才有效
+#define FINGERPRINT_MAGIC 0x51465052
+
+// 本次要画的字模和位置，点阵可能在服务器下发的字模里，也可能在 flash 字库里
+typedef struct {
+    const uint8_t *data;
+    uint8_t width;
+    uint8_t height;
+    int16_t x;
+    int16_t y;
+} glyph_draw_t;
+
+// 按位置数组得到要画的字模和位置
+// 直接用服务器给的 glyph_index 取字模；字模没有点阵时按字模项的字符查哈希表，下标越界时才按语录中对应字符的码点查，
+// 服务器没有下发的字再依次到 flash 字模缓存、flash 字库里找（字库适用于该屏幕和字号时）
+// 返回：   要画的字模个数，-1 表示语录中有无效的 UTF-8 编码
+static int collect_glyph_draws(const EPD_PANEL_OPS *panel, const char *quote, int font_size,
+                               const GlyphBitmap *glyphs, int glyph_count,
+                               const GlyphPlacement *placements, int placement_count, glyph_draw_t *draws) {
+    static glyph_map_t map;       // 1.5KB，不放在栈上
+    bool map_ready = false;       // 只有用到时才建表
+    bool use_store = font_store_matches(panel->model) && font_store_info()->height == font_size;
+    const char *p = quote;
+    int count = 0;
+
+    for (int i = 0; i < placement_count && i < MAX_BITMAPS; i++) {
+        // 第 i 个位置对应语录的第 i 个字符
+        uint32_t codepoint = 0;
+        if (*p != '\0') {
+            int len;
+            codepoint = EPD_UTF8_Decode(p, &len);
+            if (len == 0) {
+                return -1;                        // 无效的 UTF-8 编码
+            }
+            p += len;
+        }
+
+        int g = placements[i].glyph_index;
+        if (g < glyph_count && glyphs[g].data == NULL && glyphs[g].character[0] != '\0') {
+            // 字模项有字符但没有点阵，查找时用字模项的字符，语录里第 i 个字符不一定是它
+            int len;
+            uint32_t c = EPD_UTF8_Decode(glyphs[g].character, &len);
+            if (len > 0) {
+                codepoint = c;
+            }
+        }
+        if (g >= glyph_count || glyphs[g].data == NULL) {
+            if (!map_ready) {
+                glyph_map_build(&map, glyphs, glyph_count);
+                map_ready = true;
+            }
+            g = glyph_map_find(&map, codepoint);
+        }
+        if (g >= 0) {
+            draws[count].data = glyphs[g].data;
+            draws[count].width = glyphs[g].width;
+            draws[count].height = glyphs[g].height;
+        } else if ((draws[count].data = glyph_cache_find(codepoint, font_size)) != NULL) {
+            draws[count].width = font_size;       // 缓存里的点阵直接读 flash
+            draws[count].height = font_size;
+        } else {
+            const uint8_t *bits = use_store ? font_store_find(codepoint) : NULL;
+            if (bits == NULL) {
+                continue;                         // 没有这个字的字模，不画
+            }
+            draws[count].data = bits;             // 直接指向映射的 flash，不复制
+            draws[count].width = font_store_info()->width;
+            draws[count].height = font_store_info()->height;
+        }
+        draws[count].x = placements[i].x;
+        draws[count].y = placements[i].y;
+        count++;
+    }
+    return count;
+}
+
+// 计算显示内容的指纹：屏幕型号 + 每个字模的位置、尺寸和点阵
+// 字模点阵或排版变化都会改变指纹，只比较语录文本时这些变化会被漏掉
+static uint32_t glyph_draws_fingerprint(const EPD_PANEL_OPS *panel, const glyph_draw_t *draws, int count) {
+    uint32_t h = EPD_Hash32((const uint8_t *)panel->model, strlen(panel->model), 0);
+
+    for (int k = 0; k < count; k++) {
+        uint8_t head[6] = {
+            (uint8_t)draws[k].x, (uint8_t)(draws[k].x >> 8),
+            (uint8_t)draws[k].y, (uint8_t)(draws[k].y >> 8),
+            draws[k].width, draws[k].height,
+        };
+        h = EPD_Hash32(head, sizeof(head), h);
+        h = EPD_Hash32(draws[k].data, ((uint32_t)draws[k].width * draws[k].height + 7) / 8, h);
+    }
+    return h;
+}
+
+// 服务器下发的字模存入 flash 缓存，并把本次用到的较旧缓存字模移到最新的扇区
+// 画完之后才调用，写 flash 可能擦掉 draws 指向的缓存扇区
+// 缓存里的字按字号的方格取出，尺寸不是字号方格的字模不缓存
+static void update_glyph_cache(int font_size, const GlyphBitmap *glyphs, int glyph_count) {
+    for (int i = 0; i < glyph_count; i++) {
+        int len;
+        uint32_t codepoint = EPD_UTF8_Decode(glyphs[i].character, &len);
+        if (len == 0 || glyphs[i].data == NULL || glyphs[i].width != font_size || glyphs[i].height != font_size) {
+            continue;
+        }
+        glyph_cache_put(codepoint, font_size, glyphs[i].data,
+                        ((uint32_t)glyphs[i].width * glyphs[i].height + 7) / 8);
+    }
+    glyph_cache_commit();
+}
+
+// 统计语录中本地和服务器都没有字模的字数，服务器按缓存摘要省略了字模时，用它判断布隆过滤器是否误判
+int epaper_display_missing_glyphs(const char *screen_model, const char *quote, int font_size,
+                                  const GlyphBitmap *glyphs, int glyph_count,
+                                  const GlyphPlacement *placements, int placement_count) {
+    glyph_draw_t draws[MAX_BITMAPS];
+    const EPD_PANEL_OPS *panel = epaper_display_resolve_panel(screen_model);
+
+    if (panel == NULL) {
+        return 0;
+    }
+    int count = collect_glyph_draws(panel, quote, font_size, glyphs, glyph_count, placements, placement_count, draws);
+    if (count < 0) {
+        return 0;
+    }
+    return (placement_count < MAX_BITMAPS ? placement_count : MAX_BITMAPS) - count;
+}
+
+// 显示语录到墨水屏的函数
+// 参数：   screen_model,屏幕型号，不同的屏幕驱动不同
+//          quote,语录文本
+//          font_size,字号，也是缓存字模的键
+//          glyphs,字模数组
+//          glyph_count,字模数组大小
+//          placements,字符位置数组，控制字符在屏幕中显示的位置
+//          placement_count,字符位置数组大小
+void display_quote_on_epaper(const char *screen_model, const char *quote, int font_size,
+                             const GlyphBitmap *glyphs, int glyph_count,
+                             const GlyphPlacement *placements, int placement_count) {
+    glyph_draw_t draws[MAX_BITMAPS];
+
+    // 1. 型号只解析一次，之后全部通过面板接口操作
+    const EPD_PANEL_OPS *panel = epaper_display_resolve_panel(screen_model);
+    if (panel == NULL) {
+        ESP_LOGE(TAG, "不支持的屏幕型号: %s", screen_model);
+        return;
+    }
+
+    int count = collect_glyph_draws(panel, quote, font_size, glyphs, glyph_count, placements, placement_count, draws);
+    if (count < 0) {
+        ESP_LOGW(TAG, "invalid UTF-8 coding.");
+        return;                                 // 无效的 UTF-8 编码，直接返回
+    }
+
+    // 2. 与上一次显示的内容比较指纹，相同则不唤醒屏幕
+    uint32_t fingerprint = glyph_draws_fingerprint(panel, draws, count);
+    if (last_fingerprint_valid == FINGERPRINT_MAGIC && fingerprint == last_fingerprint) {
+        ESP_LOGI(TAG, "显示内容未变化，跳过刷新");
+        update_glyph_cache(font_size, glyphs, glyph_count);
+        return;
+    }
+
+    // 3. 内容不同：画到屏幕
+    ESP_LOGI(TAG, "%s", panel->name);
+    panel->begin_frame();
+    for (int k = 0; k < count; k++) {
+        panel->draw_glyph(draws[k].x, draws[k].y, draws[k].data, draws[k].width, draws[k].height);
+    }
+
+    // 有画布的屏幕逐块比较上一次显示的画面，没有变化时不刷新
+    if (panel->flush && !panel->flush()) {
+        ESP_LOGI(TAG, "画面未变化，跳过刷新");
+        last_fingerprint = fingerprint;
+        last_fingerprint_valid = FINGERPRINT_MAGIC;
+        update_glyph_cache(font_size, glyphs, glyph_count);
+        return;
+    }
+    panel->refresh_async();                     // 启动刷新，不等待，BUSY空闲时置位事件
+    pending_panel = panel;
+    last_fingerprint = fingerprint;
+    last_fingerprint_valid = FINGERPRINT_MAGIC;
+    update_glyph_cache(font_size, glyphs, glyph_count);    // 屏幕刷新的同时写 flash
+}
+
+// 等待 display_quote_on_epaper 启动的刷新完成，由语录任务在深度睡眠前调用
+// 刷新完成（或超时）后屏幕也进入深度睡眠，控制器在 MCU 睡眠期间不再耗电，下次刷新前重新复位
+// 参数：   timeout_ms,超时时间
+// 返回：   true,刷新完成或没有刷新；false,超时
+bool wait_quote_display_done(uint32_t timeout_ms) {
+    esp_err_t ret = ESP_OK;
+
+    if (pending_panel) {
+        ret = pending_panel->wait_done(timeout_ms);
+        if (pending_panel->sleep) {
+            pending_panel->sleep();
+        }
+        pending_panel = NULL;
+        if (ret != ESP_OK) {
+            last_fingerprint_valid = 0;         // 不确定屏幕上是什么，下次强制刷新
+        }
+    }
+    return ret == ESP_OK;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "quote_fetcher.h"
+#include "epaper_panel.h"
+
+// 根据服务器下发的屏幕型号查找面板，menuconfig 固定了面板时直接返回该面板
+const EPD_PANEL_OPS *epaper_display_resolve_panel(const char *screen_model);
+
+// 显示语录到墨水屏，只启动刷新，不等待刷新完成
+void display_quote_on_epaper(const char *screen_model, const char *quote, int font_size,
+                             const GlyphBitmap *glyphs, int glyph_count,
+                             const GlyphPlacement *placements, int placement_count);
+
+// 统计语录中本地和服务器都没有字模的字数
+int epaper_display_missing_glyphs(const char *screen_model, const char *quote, int font_size,
+                                  const GlyphBitmap *glyphs, int glyph_count,
+                                  const GlyphPlacement *placements, int placement_count);
+
+// 等待 display_quote_on_epaper 启动的刷新完成，返回 false 表示超时
+bool wait_quote_display_done(uint32_t timeout_ms);
@@ -0,0 +1,112 @@
+#include "font_store.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#define TAG "FONT"
+
+static const font_store_header_t *store = NULL;     // 映射后的文件头，NULL 表示没有字库
+static const uint32_t *store_index = NULL;          // 码点索引
+static const uint8_t *store_bitmaps = NULL;         // 点阵
+static esp_partition_mmap_handle_t store_handle;
+
+// 检查文件头，偏移和长度都不能超出分区
+static bool font_store_header_valid(const font_store_header_t *h, size_t partition_size) {
+    uint32_t expect_bytes;
+
+    if (h->magic != FONT_STORE_MAGIC || h->version != FONT_STORE_VERSION) {
+        return false;
+    }
+    if (h->header_size < sizeof(font_store_header_t) || h->total_size > partition_size || h->glyph_count == 0) {
+        return false;
+    }
+    if (h->layout == FONT_LAYOUT_COLUMNS) {
+        if (h->height % 8) {
+            return false;
+        }
+        expect_bytes = (uint32_t)h->width * (h->height / 8);
+    } else if (h->layout == FONT_LAYOUT_ROWS) {
+        expect_bytes = ((uint32_t)h->width * h->height + 7) / 8;
+    } else {
+        return false;
+    }
+    if (h->glyph_bytes != expect_bytes) {
+        return false;
+    }
+    if (h->index_offset % 4 || h->index_offset < h->header_size ||          // 索引按 uint32_t 直接读 flash，必须4字节对齐
+        (uint64_t)h->index_offset + (uint64_t)h->glyph_count * 4 > h->total_size) {
+        return false;
+    }
+    if ((uint64_t)h->bitmap_offset + (uint64_t)h->glyph_count * h->glyph_bytes > h->total_size) {
+        return false;
+    }
+    return memchr(h->screen_model, '\0', sizeof(h->screen_model)) != NULL;
+}
+
+// 查找字库分区并映射
+// 先用 esp_partition_read 读出文件头检查，再只映射字库实际占用的部分，不占用整个分区的 MMU 页
+esp_err_t font_store_open(void) {
+    font_store_header_t head;
+    const void *ptr;
+    esp_err_t err;
+
+    if (store) {
+        return ESP_OK;
+    }
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           FONT_STORE_PARTITION);
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    err = esp_partition_read(part, 0, &head, sizeof(head));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!font_store_header_valid(&head, part->size)) {
+        ESP_LOGW(TAG, "字库分区内容无效");
+        return ESP_ERR_INVALID_STATE;
+    }
+    err = esp_partition_mmap(part, 0, head.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &store_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "字库映射失败: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    store = (const font_store_header_t *)ptr;
+    store_index = (const uint32_t *)((const uint8_t *)ptr + head.index_offset);
+    store_bitmaps = (const uint8_t *)ptr + head.bitmap_offset;
+    ESP_LOGI(TAG, "字库 %08" PRIX32 ": %" PRIu32 " 个字, %ux%u, %s",
+             head.font_id, head.glyph_count, head.width, head.height, head.screen_model);
+    return ESP_OK;
+}
+
+const font_store_header_t *font_store_info(void) {
+    return store;
+}
+
+bool font_store_matches(const char *screen_model) {
+    return store && screen_model && strcmp(store->screen_model, screen_model) == 0;
+}
+
+// 按码点二分查找，索引和点阵都在 flash 中，只读不复制
+const uint8_t *font_store_find(uint32_t codepoint) {
+    uint32_t lo = 0, hi, mid;
+
+    if (store == NULL) {
+        return NULL;
+    }
+    hi = store->glyph_count;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (store_index[mid] < codepoint) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == store->glyph_count || store_index[lo] != codepoint) {
+        return NULL;
+    }
+    return store_bitmaps + lo * store->glyph_bytes;
+}
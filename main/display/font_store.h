@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 存放在 flash 数据分区里的点阵字库，由 tools/font_compiler.py 生成，格式（小端）：
+//   文件头    font_store_header_t，64 字节
+//   码点索引  glyph_count 个 uint32_t，按码点升序，从 index_offset 开始
+//   点阵      glyph_count 个字模，每个 glyph_bytes 字节，顺序与索引相同，从 bitmap_offset 开始
+// 整个分区用 esp_partition_mmap 映射到地址空间，查找和取点阵都直接读 flash cache，不复制到内存
+
+#define FONT_STORE_PARTITION    "font"          // 分区名，见 partitions.csv
+#define FONT_STORE_MAGIC        0x31465045      // "EPF1"
+#define FONT_STORE_VERSION      1
+
+// 点阵排列方式，与服务器给对应屏幕下发的字模相同
+#define FONT_LAYOUT_ROWS        0               // 逐行，高位在左，1 为前景，行间不补齐（zjy_3.52_4colors）
+#define FONT_LAYOUT_COLUMNS     1               // 逐列，每列 height/8 字节，高位在上，0 为前景（qy_2.9_2colors）
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // FONT_STORE_MAGIC
+    uint16_t version;           // FONT_STORE_VERSION
+    uint16_t header_size;       // 文件头字节数
+    uint32_t glyph_count;       // 字模个数
+    uint32_t index_offset;      // 码点索引的偏移
+    uint32_t bitmap_offset;     // 点阵的偏移
+    uint32_t total_size;        // 字库总字节数
+    uint32_t font_id;           // 索引和点阵的 CRC32，请求语录时告诉服务器设备上是哪个字库
+    uint16_t glyph_bytes;       // 每个字模的字节数
+    uint8_t  width;             // 字模宽度（像素）
+    uint8_t  height;            // 字模高度（像素）
+    uint8_t  layout;            // FONT_LAYOUT_*
+    uint8_t  reserved[3];
+    char     screen_model[28];  // 字模适用的屏幕型号，与 EPD_PANEL_OPS.model 相同
+} font_store_header_t;
+
+_Static_assert(sizeof(font_store_header_t) == 64, "font_store_header_t must be 64 bytes");
+
+// 查找字库分区并映射，检查文件头；分区不存在或内容无效时返回错误，之后的查找都返回 NULL
+esp_err_t font_store_open(void);
+
+// 字库文件头，未打开时返回 NULL
+const font_store_header_t *font_store_info(void);
+
+// 字库是否适用于该屏幕型号
+bool font_store_matches(const char *screen_model);
+
+// 按码点二分查找字模，返回 flash 中点阵的地址，没有时返回 NULL
+const uint8_t *font_store_find(uint32_t codepoint);
@@ -0,0 +1,365 @@
+#include "glyph_cache.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "mbedtls/base64.h"
+#include "epaper_framediff.h"
+
+#define TAG "GCACHE"
+
+#define SECTOR_SIZE         4096
+#define MAX_SECTORS         32                      // 偏移按4字节存成 uint16_t，最多 128KB
+#define SECTOR_MAGIC        0x31534347              // "GCS1"
+#define MAX_GLYPH_BYTES     1024                    // 与 FONT_72_SIZE 相同
+#define INDEX_BITS          12
+#define INDEX_SLOTS         (1 << INDEX_BITS)
+#define INDEX_LIMIT         (INDEX_SLOTS * 3 / 4)   // 装载率上限，超过时重建索引或不再缓存
+#define KEY_EMPTY           0xFFFFFFFF              // 空槽，也是 flash 擦除后的值
+#define OFF_NONE            0xFFFF                  // 已删除的槽
+#define MAX_PROMOTE         64                      // 一次显示最多移动的字模数
+#define BLOOM_K             7                       // 每位数组 10 位/字时误判率约 1%
+#define BLOOM_MIN_BITS      1024
+#define BLOOM_MAX_BITS      32768                   // 请求头不超过约 5.5KB
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;           // 扇区序号，越大越新，0 表示空扇区
+} sector_head_t;
+
+typedef struct {
+    uint32_t key;           // 码点 | 字号 << 24
+    uint16_t len;           // 点阵字节数
+    uint16_t check;         // key 和点阵的校验，写到一半掉电的记录校验不过，扫描时跳过
+} record_head_t;
+
+enum { SCAN_ADD, SCAN_REMOVE };
+
+static const esp_partition_t *part = NULL;
+static const uint8_t *base = NULL;                  // 整个分区的映射，NULL 表示未打开
+static esp_partition_mmap_handle_t map_handle;
+static uint16_t sector_count;
+static uint32_t sector_seq[MAX_SECTORS];
+static uint16_t head;                               // 正在写的扇区
+static uint32_t head_pos;                           // 扇区内的写入位置
+
+// 开放寻址哈希索引，偏移以4字节为单位，128KB 分区用 uint16_t 足够
+static uint32_t *index_key = NULL;
+static uint16_t *index_off = NULL;
+static uint16_t index_used;                         // 非空槽数，含已删除的
+static uint16_t index_live;                         // 有效的字模数
+
+static uint32_t promote_key[MAX_PROMOTE];
+static uint8_t promote_count;
+static uint8_t rec_buf[sizeof(record_head_t) + MAX_GLYPH_BYTES];
+
+static inline uint32_t glyph_key(uint32_t codepoint, uint8_t size) {
+    return (codepoint & 0xFFFFFF) | ((uint32_t)size << 24);
+}
+
+static inline uint32_t align4(uint32_t n) {
+    return (n + 3) & ~3u;
+}
+
+static uint16_t record_check(uint32_t key, const uint8_t *data, uint16_t len) {
+    uint8_t k[4] = { (uint8_t)key, (uint8_t)(key >> 8), (uint8_t)(key >> 16), (uint8_t)(key >> 24) };
+    uint32_t h = EPD_Hash32(data, len, EPD_Hash32(k, sizeof(k), 0));
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+// 查找 key 所在的槽，没有返回 -1
+static int index_find(uint32_t key) {
+    uint32_t slot = (key * 2654435761u) >> (32 - INDEX_BITS);
+
+    while (index_key[slot] != KEY_EMPTY) {
+        if (index_key[slot] == key) {
+            return slot;
+        }
+        slot = (slot + 1) & (INDEX_SLOTS - 1);
+    }
+    return -1;
+}
+
+// 记录 key 的最新位置，同一个 key 的旧记录不再使用
+static void index_set(uint32_t key, uint16_t off) {
+    int slot = index_find(key);
+
+    if (slot < 0) {
+        if (index_used >= INDEX_SLOTS - INDEX_SLOTS / 8) {
+            return;                                         // 至少留 1/8 空槽，查找才能停下来
+        }
+        slot = (key * 2654435761u) >> (32 - INDEX_BITS);
+        while (index_key[slot] != KEY_EMPTY && index_off[slot] != OFF_NONE) {  // 已删除的槽可以复用
+            slot = (slot + 1) & (INDEX_SLOTS - 1);
+        }
+        if (index_key[slot] == KEY_EMPTY) {
+            index_used++;
+        }
+        index_key[slot] = key;
+        index_off[slot] = OFF_NONE;
+    }
+    if (index_off[slot] == OFF_NONE) {
+        index_live++;
+    }
+    index_off[slot] = off;
+}
+
+// 逐条读扇区里的记录，按 op 加入或移出索引
+// 返回：   日志结束的位置，遇到写坏的记录头时返回 SECTOR_SIZE，扇区不再写入
+static uint32_t sector_scan(uint16_t s, int op) {
+    const uint8_t *p = base + (uint32_t)s * SECTOR_SIZE;
+    uint32_t pos = sizeof(sector_head_t);
+    record_head_t r;
+
+    while (pos + sizeof(r) <= SECTOR_SIZE) {
+        memcpy(&r, p + pos, sizeof(r));
+        if (r.key == KEY_EMPTY && r.len == 0xFFFF && r.check == 0xFFFF) {
+            break;                                          // 擦除状态，后面没有记录
+        }
+        if (r.len == 0 || r.len > MAX_GLYPH_BYTES || pos + sizeof(r) + r.len > SECTOR_SIZE) {
+            return SECTOR_SIZE;
+        }
+        uint16_t off = ((uint32_t)s * SECTOR_SIZE + pos) / 4;
+        if (op == SCAN_ADD && r.check == record_check(r.key, p + pos + sizeof(r), r.len)) {
+            index_set(r.key, off);
+        } else if (op == SCAN_REMOVE) {
+            int slot = index_find(r.key);
+            if (slot >= 0 && index_off[slot] == off) {     // 索引指向的是这条记录才删除
+                index_off[slot] = OFF_NONE;
+                index_live--;
+            }
+        }
+        pos += align4(sizeof(r) + r.len);
+    }
+    return pos;
+}
+
+// 擦除扇区作为新的写入扇区，扇区里原来的字模移出索引
+static esp_err_t sector_start(uint16_t s, uint32_t seq) {
+    sector_head_t h = { SECTOR_MAGIC, seq };
+    esp_err_t err;
+
+    if (sector_seq[s]) {
+        sector_scan(s, SCAN_REMOVE);
+    }
+    sector_seq[s] = 0;
+    err = esp_partition_erase_range(part, (uint32_t)s * SECTOR_SIZE, SECTOR_SIZE);
+    if (err == ESP_OK) {
+        err = esp_partition_write(part, (uint32_t)s * SECTOR_SIZE, &h, sizeof(h));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "扇区 %u 擦写失败: %s", s, esp_err_to_name(err));
+        return err;
+    }
+    sector_seq[s] = seq;
+    head = s;
+    head_pos = sizeof(h);
+    return ESP_OK;
+}
+
+// 扫描整个分区重建索引，也用来清掉累积的已删除槽
+static esp_err_t glyph_cache_rebuild(void) {
+    uint32_t max_seq = 0;
+    sector_head_t h;
+
+    memset(index_key, 0xFF, INDEX_SLOTS * sizeof(index_key[0]));
+    index_used = 0;
+    index_live = 0;
+    head = 0;
+    for (uint16_t s = 0; s < sector_count; s++) {
+        memcpy(&h, base + (uint32_t)s * SECTOR_SIZE, sizeof(h));
+        sector_seq[s] = (h.magic == SECTOR_MAGIC && h.seq != KEY_EMPTY) ? h.seq : 0;
+        if (sector_seq[s] > max_seq) {
+            max_seq = sector_seq[s];
+            head = s;
+        }
+    }
+    if (max_seq == 0) {
+        return sector_start(0, 1);                          // 空分区
+    }
+    // 扇区按环形顺序写入，从 head 的下一个开始就是从旧到新，新记录覆盖旧记录
+    for (uint16_t i = 1; i <= sector_count; i++) {
+        uint16_t s = (head + i) % sector_count;
+        if (sector_seq[s]) {
+            head_pos = sector_scan(s, SCAN_ADD);
+        }
+    }
+    return ESP_OK;
+}
+
+// 查找缓存分区、映射并扫描建索引
+esp_err_t glyph_cache_open(void) {
+    const void *ptr;
+    esp_err_t err;
+
+    if (base) {
+        return ESP_OK;
+    }
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, GLYPH_CACHE_PARTITION);
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    sector_count = part->size / SECTOR_SIZE;
+    if (sector_count > MAX_SECTORS) {
+        sector_count = MAX_SECTORS;
+    }
+    if (sector_count < 4) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    index_key = malloc(INDEX_SLOTS * sizeof(index_key[0]));
+    index_off = malloc(INDEX_SLOTS * sizeof(index_off[0]));
+    if (index_key == NULL || index_off == NULL) {
+        free(index_key);
+        free(index_off);
+        index_key = NULL;
+        index_off = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    err = esp_partition_mmap(part, 0, (uint32_t)sector_count * SECTOR_SIZE, ESP_PARTITION_MMAP_DATA, &ptr, &map_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "缓存映射失败: %s", esp_err_to_name(err));
+        free(index_key);
+        free(index_off);
+        index_key = NULL;
+        index_off = NULL;
+        return err;
+    }
+    base = ptr;
+    err = glyph_cache_rebuild();
+    ESP_LOGI(TAG, "字模缓存: %u 个字", index_live);
+    return err;
+}
+
+// 按码点和字号查找，命中最旧 1/4 扇区里的字模时记下来，commit 时移到最新的扇区
+const uint8_t *glyph_cache_find(uint32_t codepoint, uint8_t size) {
+    uint32_t key = glyph_key(codepoint, size);
+    int slot;
+
+    if (base == NULL || (slot = index_find(key)) < 0 || index_off[slot] == OFF_NONE) {
+        return NULL;
+    }
+    uint32_t addr = (uint32_t)index_off[slot] * 4;
+    uint16_t s = addr / SECTOR_SIZE;
+    if (sector_seq[head] - sector_seq[s] >= sector_count * 3u / 4 && promote_count < MAX_PROMOTE) {
+        int k = 0;
+        while (k < promote_count && promote_key[k] != key) {
+            k++;
+        }
+        if (k == promote_count) {
+            promote_key[promote_count++] = key;
+        }
+    }
+    return base + addr + sizeof(record_head_t);
+}
+
+// 追加一条记录，当前扇区写满时换到下一个扇区（擦掉最旧的）
+static esp_err_t glyph_cache_append(uint32_t key, const uint8_t *data, uint16_t len) {
+    record_head_t r = { key, len, record_check(key, data, len) };
+    uint32_t need = align4(sizeof(r) + len);
+    esp_err_t err;
+
+    if (head_pos + need > SECTOR_SIZE) {
+        err = sector_start((head + 1) % sector_count, sector_seq[head] + 1);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    memcpy(rec_buf, &r, sizeof(r));
+    if (data != rec_buf + sizeof(r)) {
+        memcpy(rec_buf + sizeof(r), data, len);
+    }
+    uint32_t addr = (uint32_t)head * SECTOR_SIZE + head_pos;
+    err = esp_partition_write(part, addr, rec_buf, sizeof(r) + len);   // 记录头和点阵一次写入
+    if (err != ESP_OK) {
+        head_pos = SECTOR_SIZE;                             // 不确定写了多少，这个扇区不再写入
+        return err;
+    }
+    head_pos += need;
+    index_set(key, addr / 4);
+    return ESP_OK;
+}
+
+// 保存一个字模，已经缓存的不重复写入
+esp_err_t glyph_cache_put(uint32_t codepoint, uint8_t size, const uint8_t *data, uint16_t len) {
+    uint32_t key = glyph_key(codepoint, size);
+    int slot;
+
+    if (base == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (data == NULL || len == 0 || len > MAX_GLYPH_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    slot = index_find(key);
+    if (slot >= 0 && index_off[slot] != OFF_NONE) {
+        return ESP_OK;
+    }
+    if (index_used >= INDEX_LIMIT) {
+        glyph_cache_rebuild();                              // 清掉已删除的槽
+        if (index_used >= INDEX_LIMIT) {
+            return ESP_ERR_NO_MEM;                          // 字都很小时扇区装得下的字比索引多
+        }
+    }
+    return glyph_cache_append(key, data, len);
+}
+
+// 把记录下来的较旧字模重新追加到最新的扇区
+void glyph_cache_commit(void) {
+    for (int k = 0; k < promote_count; k++) {
+        int slot = index_find(promote_key[k]);
+        if (slot < 0 || index_off[slot] == OFF_NONE) {
+            continue;                                       // 前面的追加擦掉了它所在的扇区
+        }
+        const uint8_t *rec = base + (uint32_t)index_off[slot] * 4;
+        record_head_t r;
+        memcpy(&r, rec, sizeof(r));
+        memcpy(rec_buf + sizeof(r), rec + sizeof(r), r.len);  // 先复制到内存，追加时可能擦除原来的扇区
+        if (glyph_cache_append(r.key, rec_buf + sizeof(r), r.len) != ESP_OK) {
+            break;
+        }
+    }
+    promote_count = 0;
+}
+
+// 布隆过滤器加入一个 key，哈希方法见头文件
+static void bloom_add(uint8_t *bits, uint32_t m, uint32_t key) {
+    uint8_t k[4] = { (uint8_t)key, (uint8_t)(key >> 8), (uint8_t)(key >> 16), (uint8_t)(key >> 24) };
+    uint32_t h1 = EPD_Hash32(k, sizeof(k), 0);
+    uint32_t h2 = ((h1 >> 17) | (h1 << 15)) | 1;
+
+    for (uint32_t j = 0; j < BLOOM_K; j++) {
+        uint32_t bit = (h1 + j * h2) & (m - 1);             // m 是2的幂
+        bits[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+// 生成 X-Glyph-Cache 请求头的值
+char *glyph_cache_summary(void) {
+    uint32_t m = BLOOM_MIN_BITS;
+    size_t olen;
+
+    if (base == NULL || index_live == 0) {
+        return NULL;
+    }
+    while (m < (uint32_t)index_live * 10 && m < BLOOM_MAX_BITS) {
+        m <<= 1;
+    }
+    uint8_t *bits = calloc(1, m / 8);
+    size_t b64_len = (m / 8 + 2) / 3 * 4 + 1;
+    char *out = malloc(24 + b64_len);
+    if (bits == NULL || out == NULL) {
+        free(bits);
+        free(out);
+        return NULL;
+    }
+    for (int i = 0; i < INDEX_SLOTS; i++) {
+        if (index_key[i] != KEY_EMPTY && index_off[i] != OFF_NONE) {
+            bloom_add(bits, m, index_key[i]);
+        }
+    }
+    int n = snprintf(out, 24, "k=%d;m=%lu;", BLOOM_K, (unsigned long)m);
+    mbedtls_base64_encode((unsigned char *)out + n, b64_len, &olen, bits, m / 8);
+    free(bits);
+    return out;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 服务器下发过的字模缓存在 flash 分区里，按 (码点, 字号) 查找，下次同样的字不用再下载
+//
+// 分区按 4KB 扇区组成环形日志，每个扇区开头是扇区头（magic + 序号），后面依次追加字模记录：
+//   uint32 key（码点 | 字号 << 24）、uint16 点阵字节数、uint16 校验、点阵，按4字节对齐
+// 写满一个扇区后擦除最旧的扇区继续写，被擦除的字模从索引里删掉。
+// 命中的字模如果在最旧的 1/4 扇区里，就重新追加到最新的扇区，擦除时丢掉的总是最久没用过的字，近似 LRU。
+// 启动时扫描一遍分区，在内存里建 key → 偏移的哈希索引；分区用 esp_partition_mmap 映射，查到的点阵直接读 flash
+//
+// 请求时用 glyph_cache_summary 生成缓存的布隆过滤器放在 X-Glyph-Cache 请求头里，服务器可以不下发已缓存的字：
+//   值为 "k=<哈希个数>;m=<位数>;<base64 位数组>"，第 i 位在第 i/8 字节的低位起第 i%8 位
+//   h1 = FNV-1a32(key 的4个小端字节)，h2 = (h1 >> 17 | h1 << 15) | 1，第 j 个哈希是 (h1 + j*h2) mod m，按32位无符号数计算
+// 布隆过滤器有误判，服务器因此漏发的字由调用者检查后去掉请求头重新请求
+
+#define GLYPH_CACHE_PARTITION   "glyphs"        // 分区名，见 partitions.csv
+#define GLYPH_CACHE_HEADER      "X-Glyph-Cache" // 请求头名
+
+// 查找缓存分区、映射并扫描建索引
+esp_err_t glyph_cache_open(void);
+
+// 按码点和字号查找，返回 flash 中点阵的地址，没有时返回 NULL
+// 命中较旧的字模时只做记录，glyph_cache_commit 时再移到最新的扇区，调用者拿到的地址在 commit 之前一直有效
+const uint8_t *glyph_cache_find(uint32_t codepoint, uint8_t size);
+
+// 保存一个字模，已经缓存的不重复写入
+esp_err_t glyph_cache_put(uint32_t codepoint, uint8_t size, const uint8_t *data, uint16_t len);
+
+// 把 glyph_cache_find 记录的较旧字模移到最新的扇区，之前 find 返回的地址可能失效
+void glyph_cache_commit(void);
+
+// 生成 X-Glyph-Cache 请求头的值，返回 malloc 的字符串，缓存为空或未打开时返回 NULL
+char *glyph_cache_summary(void);
@@ -0,0 +1,45 @@
+#include "glyph_map.h"
+#include <string.h>
+#include "epaper_gui.h"
+
+// 乘法哈希，取高 GLYPH_MAP_BITS 位
+static inline uint32_t glyph_map_slot(uint32_t codepoint) {
+    return (codepoint * 2654435761u) >> (32 - GLYPH_MAP_BITS);
+}
+
+// 用字模数组建表，线性探测
+void glyph_map_build(glyph_map_t *map, const GlyphBitmap *glyphs, int glyph_count) {
+    memset(map->codepoint, 0, sizeof(map->codepoint));
+
+    for (int i = 0; i < glyph_count && i < MAX_BITMAPS; i++) {
+        int len;
+        uint32_t cp = EPD_UTF8_Decode(glyphs[i].character, &len);
+        if (len == 0 || cp == 0 || glyphs[i].data == NULL) {
+            continue;
+        }
+        uint32_t slot = glyph_map_slot(cp);
+        while (map->codepoint[slot] != 0 && map->codepoint[slot] != cp) {
+            slot = (slot + 1) & (GLYPH_MAP_SLOTS - 1);
+        }
+        if (map->codepoint[slot] == 0) {            // 重复的字符保留第一个
+            map->codepoint[slot] = cp;
+            map->index[slot] = (uint16_t)i;
+        }
+    }
+}
+
+// 按码点查找字模下标，遇到空槽说明不存在
+int glyph_map_find(const glyph_map_t *map, uint32_t codepoint) {
+    uint32_t slot = glyph_map_slot(codepoint);
+
+    if (codepoint == 0) {
+        return -1;
+    }
+    while (map->codepoint[slot] != 0) {
+        if (map->codepoint[slot] == codepoint) {
+            return map->index[slot];
+        }
+        slot = (slot + 1) & (GLYPH_MAP_SLOTS - 1);
+    }
+    return -1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include "quote_fetcher.h"
+
+// 码点→字模下标的开放寻址哈希表，槽数是 MAX_BITMAPS 的2倍以上，装载率不超过一半
+#define GLYPH_MAP_BITS  8
+#define GLYPH_MAP_SLOTS (1 << GLYPH_MAP_BITS)
+
+_Static_assert(GLYPH_MAP_SLOTS >= 2 * MAX_BITMAPS, "GLYPH_MAP_BITS too small for MAX_BITMAPS");
+
+typedef struct {
+    uint32_t codepoint[GLYPH_MAP_SLOTS];    // 0 表示空槽
+    uint16_t index[GLYPH_MAP_SLOTS];        // 字模数组下标
+} glyph_map_t;
+
+// 用字模数组建表，同一个字符出现多次时保留第一个
+void glyph_map_build(glyph_map_t *map, const GlyphBitmap *glyphs, int glyph_count);
+
+// 按码点查找字模下标，找不到返回 -1
+int glyph_map_find(const glyph_map_t *map, uint32_t codepoint);
@@ -0,0 +1,97 @@
+#include "http_session.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define TAG "HTTP"
+
+// 记录耗时后交给调用者的事件处理函数
+static esp_err_t session_event_handler(esp_http_client_event_t *evt) {
+    http_session_t *s = (http_session_t *)evt->user_data;
+    esp_err_t err = ESP_OK;
+
+    if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+        s->connected_us = esp_timer_get_time();
+        s->connections++;
+    }
+    evt->user_data = s->user_data;
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        int64_t t = esp_timer_get_time();
+        err = s->handler(evt);
+        s->last.parse_us += esp_timer_get_time() - t;
+    } else {
+        err = s->handler(evt);
+    }
+    evt->user_data = s;
+    return err;
+}
+
+esp_err_t http_session_open(http_session_t *s, const char *url, http_event_handle_cb handler, int buffer_size_tx) {
+    memset(s, 0, sizeof(*s));
+    s->handler = handler;
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = session_event_handler,
+        .buffer_size = 1024*2,                  // 接收缓冲区，每收满一次解析一次，响应长度不受它限制
+        .buffer_size_tx = buffer_size_tx,
+        .user_data = s,
+    };
+    s->client = esp_http_client_init(&config);
+    return s->client ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void http_session_set_header(http_session_t *s, const char *key, const char *value) {
+    if (value) {
+        esp_http_client_set_header(s->client, key, value);
+    } else {
+        esp_http_client_delete_header(s->client, key);
+    }
+}
+
+esp_err_t http_session_perform(http_session_t *s, const char *url, void *user_data) {
+    esp_err_t err;
+
+    if (s->requests > 0) {
+        esp_http_client_set_url(s->client, url);   // host 和端口没变时保持原来的连接
+    }
+    s->user_data = user_data;
+    s->requests++;
+    memset(&s->last, 0, sizeof(s->last));
+    s->connected_us = 0;
+    s->start_us = esp_timer_get_time();
+
+    err = esp_http_client_perform(s->client);
+
+    int64_t end = esp_timer_get_time();
+    int64_t from = s->start_us;
+    if (s->connected_us) {
+        s->last.connect_us = s->connected_us - s->start_us;
+        from = s->connected_us;
+    }
+    s->last.transfer_us = end - from - s->last.parse_us;
+    s->total.connect_us += s->last.connect_us;
+    s->total.transfer_us += s->last.transfer_us;
+    s->total.parse_us += s->last.parse_us;
+    ESP_LOGI(TAG, "第 %d 个请求: 连接 %d ms%s，传输 %d ms，解析 %d ms", s->requests,
+             (int)(s->last.connect_us / 1000), s->connected_us ? "" : "（复用）",
+             (int)(s->last.transfer_us / 1000), (int)(s->last.parse_us / 1000));
+    return err;
+}
+
+int http_session_status(const http_session_t *s) {
+    return esp_http_client_get_status_code(s->client);
+}
+
+void http_session_close(http_session_t *s) {
+    if (s->client == NULL) {
+        return;
+    }
+    if (s->requests > 0) {
+        ESP_LOGI(TAG, "%d 个请求，%d 次连接: 连接 %d ms，传输 %d ms，解析 %d ms", s->requests, s->connections,
+                 (int)(s->total.connect_us / 1000), (int)(s->total.transfer_us / 1000),
+                 (int)(s->total.parse_us / 1000));
+    }
+    esp_http_client_cleanup(s->client);
+    s->client = NULL;
+}
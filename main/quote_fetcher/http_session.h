@@ -0,0 +1,56 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+// 一次唤醒里的 HTTP 会话：所有请求共用一个 esp_http_client，服务器保持连接时后面的请求不再建立 TCP（和 TLS）连接。
+// 请求依次发送，上一个响应收完再发下一个；每个请求记下连接、传输和解析的耗时，关闭时打印合计。
+//   连接：从开始请求到连接建立，复用连接时为 0
+//   解析：调用者的事件处理函数处理 HTTP_EVENT_ON_DATA 的时间，也就是边收边解析、写 flash 的时间
+//   传输：其余的时间，发送请求、等待和接收响应
+
+typedef struct {
+    int64_t connect_us;
+    int64_t transfer_us;
+    int64_t parse_us;
+} http_timing_t;
+
+typedef struct {
+    esp_http_client_handle_t client;
+    http_event_handle_cb handler;   // 调用者的事件处理函数
+    void *user_data;                // 当前请求交给 handler 的 user_data
+    int64_t start_us;               // 当前请求开始的时间
+    int64_t connected_us;           // 当前请求建立连接的时间，复用连接时为 0
+    http_timing_t last;             // 上一个请求的耗时
+    http_timing_t total;            // 所有请求的合计
+    int requests;
+    int connections;                // 建立连接的次数，小于请求数说明复用了连接
+} http_session_t;
+
+// 创建会话，这时还不连接
+// 参数：   handler,事件处理函数，evt->user_data 是每个请求传入的 user_data
+//          buffer_size_tx,发送缓冲区大小，要放得下最长的请求头，0 为默认大小
+esp_err_t http_session_open(http_session_t *s, const char *url, http_event_handle_cb handler, int buffer_size_tx);
+
+// 设置之后每个请求都带的请求头，value 为 NULL 时删除
+void http_session_set_header(http_session_t *s, const char *key, const char *value);
+
+// 发送一个请求并收完响应，host 和端口不变时复用连接
+// 参数：   user_data,这个请求交给事件处理函数的 user_data
+esp_err_t http_session_perform(http_session_t *s, const char *url, void *user_data);
+
+// 上一个请求的状态码
+int http_session_status(const http_session_t *s);
+
+// 关闭连接，打印合计耗时
+void http_session_close(http_session_t *s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,30 +1,37 @@
 #include "quote_fetcher.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
-#include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "config.h"
 #include "esp_mac.h"
-#include <esp_sleep.h>
 #include "nvs_flash.h"
-#include "driver/rtc_io.h"
+#include <inttypes.h>
+#include "font_store.h"
+#include "glyph_cache.h"
+#include "quote_stream.h"
+#include "screen_ring.h"
+#include "http_session.h"
+#include "wake_policy.h"
+#include "board_init.h"
+#include <strings.h>
+#include <time.h>
 
 #define TAG "QUOTE"
 
-#define WAKE_PIN    34          // 34号引脚用于外部唤醒（连接按键）
-
 // 全局变量保存回调函数
 static quote_display_callback_t display_callback = NULL;
+static quote_display_wait_callback_t display_wait_callback = NULL;
+static quote_glyph_check_callback_t glyph_check_callback = NULL;
 
 
 #define MAX_URL_LEN 256
 
-#define REFRESH_INTERVAL_US 3600000000ULL    // 10分钟=600000000ULL，60分钟=3600000000ULL,单位微秒
+#define BATCH_SCREENS 8                       // 有屏幕缓存分区时一次请求的屏数，不超过 SCREEN_RING_MAX
 
-#define NVS_NAMESPACE "epaper_quote"       // NVS命名空间（用于存储last_quote）
-#define NVS_KEY_LAST_QUOTE "last_quote"    // NVS中存储last_quote的键
-#define LAST_QUOTE_MAX_LEN 256             // 语录最大长度
+#define NVS_NAMESPACE "epaper_quote"       // NVS命名空间（用于存储ETag）
+#define NVS_KEY_ETAG "etag"                // NVS中存储当前显示内容ETag的键
+#define ETAG_MAX_LEN 64                    // ETag最大长度（含'\0'），更长的不保存
 
 esp_err_t generate_device_request_url(char *url_out, size_t max_len, request_reason_t reason)
 {
@@ -68,10 +75,22 @@ esp_err_t generate_device_request_url(char *url_out, size_t max_len, request_rea
             break;
     }
 
-    // 拼接URL字符串
-    int ret = snprintf(url_out, max_len,
-                      "%s?mac=%s&reason=%s",
-                      BASE_URL, mac_str, reason_str);
+    // 拼接URL字符串，设备上有字库时带上字库ID，服务器只需下发字库里没有的字
+    const font_store_header_t *font = font_store_info();
+    int ret;
+    if (font) {
+        ret = snprintf(url_out, max_len,
+                       "%s?mac=%s&reason=%s&font=%08" PRIX32,
+                       BASE_URL, mac_str, reason_str, font->font_id);
+    } else {
+        ret = snprintf(url_out, max_len,
+                       "%s?mac=%s&reason=%s",
+                       BASE_URL, mac_str, reason_str);
+    }
+    // 有屏幕缓存时一次下载之后的几屏，之后定时唤醒不联网
+    if (ret >= 0 && (size_t)ret < max_len && screen_ring_available()) {
+        ret += snprintf(url_out + ret, max_len - ret, "&batch=%d", BATCH_SCREENS);
+    }
 
     // 检查URL是否被截断
     if (ret < 0 || (size_t)ret >= max_len) {
@@ -88,29 +107,81 @@ void register_quote_display_callback(quote_display_callback_t callback) {
     display_callback = callback;
 }
 
+// 注册等待刷新完成回调函数
+void register_quote_display_wait_callback(quote_display_wait_callback_t callback) {
+    display_wait_callback = callback;
+}
+
+// 注册缺字检查回调函数
+void register_quote_glyph_check_callback(quote_glyph_check_callback_t callback) {
+    glyph_check_callback = callback;
+}
+
+// 响应接收状态
+typedef struct {
+    quote_stream_t *stream;
+    bool binary;                // 服务器返回的是二进制语录（QUOTE_PAYLOAD_MIME）
+    bool batch;                 // 服务器返回的是批量响应（QUOTE_BATCH_MIME），写进屏幕缓存
+    bool started;               // 已经开始解析
+    int len;                    // 已收到的字节数
+    char etag[ETAG_MAX_LEN];    // 响应的 ETag，没有或太长时为空
+} http_body_t;
+
+// 一次请求的结果
+typedef enum {
+    FETCH_FAILED = 0,           // 请求或解析失败
+    FETCH_SHOWN,                // 已交给显示回调
+    FETCH_NOT_MODIFIED,         // 304，内容与屏幕上的相同
+    FETCH_RETRY,                // 服务器省略的字模本地没有，需要不带摘要重新请求
+} fetch_result_t;
+
+// 服务器下发的字模直接写进 flash 字模缓存，显示时从缓存读
+static bool cache_glyph(uint32_t codepoint, int font_size, const uint8_t *data, uint16_t len) {
+    return glyph_cache_put(codepoint, font_size, data, len) == ESP_OK;
+}
+
 // HTTP事件处理函数
 static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
-    static int total_len = 0;
-    char *buffer = (char *)evt->user_data;
-    int buffer_size = 10240; // 10 KB
+    http_body_t *body = (http_body_t *)evt->user_data;
 
     switch (evt->event_id) {
+        case HTTP_EVENT_ON_HEADER:
+            if (strcasecmp(evt->header_key, "Content-Type") == 0 &&
+                strncasecmp(evt->header_value, QUOTE_PAYLOAD_MIME, strlen(QUOTE_PAYLOAD_MIME)) == 0) {
+                body->binary = true;
+            } else if (strcasecmp(evt->header_key, "Content-Type") == 0 &&
+                       strncasecmp(evt->header_value, QUOTE_BATCH_MIME, strlen(QUOTE_BATCH_MIME)) == 0) {
+                body->batch = true;
+            } else if (strcasecmp(evt->header_key, "ETag") == 0 && strlen(evt->header_value) < sizeof(body->etag)) {
+                strcpy(body->etag, evt->header_value);
+            }
+            break;
+
         case HTTP_EVENT_ON_DATA:
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                // 判断是否还有空间追加
-                if (total_len + evt->data_len < buffer_size - 1) {
-                    memcpy(buffer + total_len, evt->data, evt->data_len);
-                    total_len += evt->data_len;
-                    buffer[total_len] = '\0';  // 保证字符串结尾
-                } else {
-                    ESP_LOGW(TAG, "响应内容超出缓冲区，已截断");
-                }
+            // 错误页面不解析，免得把里面的内容当作字模写进缓存
+            if (esp_http_client_get_status_code(evt->client) != 200) {
+                break;
+            }
+            // 收到一段解析一段，不保存整个响应
+            // 分块传输（Transfer-Encoding: chunked）时 esp_http_client 已经去掉了块头，这里和定长响应一样处理，
+            // 块边界落在哪里都可以，结束由最后的0长度块决定，quote_stream_end 检查内容是否完整
+            if (!body->started && body->batch) {
+                screen_ring_store_begin(time(NULL));
+            } else if (!body->started) {
+                quote_stream_begin(body->stream, body->binary, cache_glyph);
+            }
+            body->started = true;
+            if (body->batch) {
+                screen_ring_store_feed(evt->data, evt->data_len);    // 批量响应边收边写进屏幕缓存，显示时再解析
+            } else {
+                quote_stream_feed(body->stream, evt->data, evt->data_len);
             }
+            body->len += evt->data_len;
             break;
 
         case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP 响应完整内容: %s", buffer);
-            total_len = 0; // 重置
+            ESP_LOGI(TAG, "HTTP 响应: %s %d 字节%s", body->batch ? "批量" : body->binary ? "二进制语录" : "JSON", body->len,
+                     esp_http_client_is_chunked_response(evt->client) ? "（分块）" : "");
             break;
 
         default:
@@ -120,145 +191,163 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
 }
 
 
+// 检查字模是否齐全后显示
+// 参数：   check_glyphs,服务器可能省略了字模（请求带了缓存摘要，或是之前下载保存的屏幕）
+// 返回：   FETCH_RETRY,服务器按摘要省略的字本地却没有（布隆过滤器误判或已被挤出缓存），不显示残缺的语录，需要去掉摘要重新请求
+static fetch_result_t show_quote(bool check_glyphs, const quote_stream_t *q) {
+    int missing = 0;
+
+    ESP_LOGI(TAG, "语录内容: %s, 屏幕型号：%s, 字号: %d", q->quote, q->screen_model, q->font_size);
+    if (check_glyphs && glyph_check_callback) {
+        missing = glyph_check_callback(q->screen_model, q->quote, q->font_size,
+                                       q->glyphs, q->glyph_count, q->placements, q->placement_count);
+    }
+    if (missing > 0) {
+        ESP_LOGW(TAG, "缺少 %d 个字模，不带缓存摘要重新请求", missing);
+        return FETCH_RETRY;
+    }
+    if (display_callback == NULL) {
+        return FETCH_FAILED;
+    }
+    display_callback(q->screen_model, q->quote, q->font_size,
+                     q->glyphs, q->glyph_count, q->placements, q->placement_count);
+    return FETCH_SHOWN;
+}
+
+static quote_stream_t stream;               // 约4KB，大小固定，与响应长度无关，不占任务栈
+
+static esp_err_t feed_stream(void *ctx, const uint8_t *data, size_t len) {
+    return quote_stream_feed((quote_stream_t *)ctx, data, len);
+}
+
+// 显示屏幕缓存里已到时间的一屏
+// 返回：   FETCH_NOT_MODIFIED,没有新到时间的屏，屏幕不用刷新；FETCH_RETRY,缺字；FETCH_FAILED,记录损坏或没有保存的屏
+static fetch_result_t show_due_screen(void) {
+    int i = screen_ring_due(time(NULL));
+    fetch_result_t result = FETCH_FAILED;
+
+    if (i < 0) {
+        return screen_ring_low_time() ? FETCH_NOT_MODIFIED : FETCH_FAILED;
+    }
+    ESP_LOGI(TAG, "显示保存的第 %d 屏", i + 1);
+    quote_stream_begin(&stream, true, cache_glyph);
+    esp_err_t err = screen_ring_read(i, feed_stream, &stream);
+    if (err == ESP_OK) {
+        err = quote_stream_end(&stream);
+    }
+    if (err == ESP_OK) {
+        result = show_quote(true, &stream);
+    } else {
+        ESP_LOGE(TAG, "第 %d 屏读取失败: %s", i + 1, esp_err_to_name(err));
+    }
+    quote_stream_release(&stream);
+    if (result == FETCH_SHOWN) {
+        screen_ring_mark_shown(i);
+    }
+    return result;
+}
+
+// 定时唤醒时不联网，显示屏幕缓存里到时间的一屏
+bool quote_fetcher_show_stored(void) {
+    fetch_result_t result = show_due_screen();
+
+    return result == FETCH_SHOWN || result == FETCH_NOT_MODIFIED;
+}
+
+// 屏幕缓存里下一屏的显示时间，没有时返回 0
+int64_t quote_fetcher_next_screen_time(void) {
+    return screen_ring_next_time(time(NULL));
+}
+
+
+// 请求语录、解析并显示
+// 参数：   session,这次唤醒的 HTTP 会话，重新请求时复用同一个连接
+//          url,请求地址
+//          glyph_summary,已缓存字模的摘要，NULL 表示不带
+//          etag,屏幕上内容的 ETag，非空时带 If-None-Match，服务器内容没变就返回 304，不下载也不解析
+//          new_etag,返回 FETCH_SHOWN 时存放新内容的 ETag，ETAG_MAX_LEN 字节；批量响应没有 ETag，为空
+// 返回：   fetch_result_t
+static fetch_result_t fetch_and_display_quote(http_session_t *session, const char *url, const char *glyph_summary,
+                                              const char *etag, char *new_etag) {
+    http_body_t body = { .stream = &stream };
+    fetch_result_t result = FETCH_FAILED;
+
+    if (screen_ring_available()) {
+        http_session_set_header(session, "Accept", QUOTE_BATCH_MIME ", " QUOTE_PAYLOAD_MIME ";q=0.9, application/json;q=0.5");
+    } else {
+        http_session_set_header(session, "Accept", QUOTE_PAYLOAD_MIME ", application/json;q=0.5");    // 服务器支持时优先返回二进制语录
+    }
+    http_session_set_header(session, GLYPH_CACHE_HEADER, glyph_summary);    // 已缓存字模的摘要，服务器可以不下发这些字；NULL 时去掉
+    http_session_set_header(session, "If-None-Match", etag[0] != '\0' ? etag : NULL);
+
+    esp_err_t err = http_session_perform(session, url, &body);      // 接收状态传递给事件处理函数
+    if (err == ESP_OK) {
+        int status = http_session_status(session);
+        ESP_LOGI(TAG, "HTTP 状态码: %d", status);
+        ESP_LOGI(TAG, "响应数据长度: %d", body.len);
+
+        if (status == 304) {
+            ESP_LOGI(TAG, "内容未变化（ETag %s），不显示", etag);
+            result = FETCH_NOT_MODIFIED;
+        } else if (status == 200 && body.started && body.batch) {
+            // 批量响应的每屏已经写进屏幕缓存，显示第一屏，之后的等定时唤醒
+            // 屏幕上的内容随时间变化，没有对应的 ETag，清掉保存的，下次请求不带 If-None-Match
+            err = screen_ring_store_end();
+            if (err == ESP_OK) {
+                result = show_due_screen();
+                new_etag[0] = '\0';
+            } else {
+                ESP_LOGE(TAG, "批量响应保存失败: %s", esp_err_to_name(err));
+            }
+        } else if (status == 200 && body.started) {
+            err = quote_stream_end(&stream);
+            if (err == ESP_OK) {
+                screen_ring_clear();            // 服务器只给了一条，之前保存的屏幕不再显示
+                result = show_quote(glyph_summary != NULL, &stream);
+                strcpy(new_etag, body.etag);
+            } else {
+                ESP_LOGE(TAG, "语录解析失败: %s", esp_err_to_name(err));
+            }
+            quote_stream_release(&stream);
+        } else {
+            ESP_LOGE(TAG, "状态码错误或无响应数据");
+        }
+    } else {
+        ESP_LOGE(TAG, "请求失败: %s", esp_err_to_name(err));
+    }
+    return result;
+}
+
 static void fetch_quote_task(void *pvParameters) {
     while (1) {
-        // 定义局部变量保存响应内容
-        char quote_buffer[1024*10] = {0};
         // 获取带有 MAC 地址的 URL
         char full_url[MAX_URL_LEN];
-        // 获取唤醒原因
-        esp_sleep_wakeup_cause_t wake_cause = esp_sleep_get_wakeup_cause();
-
-        // 映射为请求原因
-        request_reason_t req_reason;
-        switch (wake_cause) {
-            case ESP_SLEEP_WAKEUP_EXT0:
-            case ESP_SLEEP_WAKEUP_EXT1:
-                req_reason = REQUEST_REASON_BUTTON_TRIGGER;  // 按键触发
-                break;
-            case ESP_SLEEP_WAKEUP_TIMER:
-                req_reason = REQUEST_REASON_TIMER;           // 定时触发
-                break;
-            default:
-                req_reason = REQUEST_REASON_UNKNOWN;         // 未知原因: 上电复位...
-                break;
-        }        
+        // 唤醒原因映射为请求原因
+        request_reason_t req_reason = wake_policy_reason();
         generate_device_request_url(full_url, MAX_URL_LEN, req_reason);
         printf("请求 URL: %s\n", full_url);
 
-        esp_http_client_config_t config = {
-            .url = full_url,
-            .event_handler = http_event_handler,
-            .buffer_size = 1024*10,                 // 设置缓冲区大小,最大10KB
-            .user_data = quote_buffer,              // 将缓冲区传递给事件处理函数
-        };
-
-        esp_http_client_handle_t client = esp_http_client_init(&config);
-        esp_http_client_set_header(client, "Accept", "application/json");
-
-        esp_err_t err = esp_http_client_perform(client);
-        if (err == ESP_OK) {
-            int status = esp_http_client_get_status_code(client);
-            ESP_LOGI(TAG, "HTTP 状态码: %d", status);
-            ESP_LOGI(TAG, "响应数据长度: %d", strlen(quote_buffer));
-
-
-            if (status == 200 && strlen(quote_buffer) > 0) {
-                cJSON *root = cJSON_Parse(quote_buffer);
-                if (root) {
-                    cJSON *quote = cJSON_GetObjectItem(root, "quote");
-                    cJSON *screen_model = cJSON_GetObjectItem(root, "screen_model");
-                    cJSON *fontsize = cJSON_GetObjectItem(root, "fontsize");
-                    cJSON *bitmaps = cJSON_GetObjectItem(root, "bitmaps");
-                    cJSON *positions = cJSON_GetObjectItem(root, "positions");
-
-                    GlyphBitmap glyphs[MAX_BITMAPS];   
-                    int glyph_count = 0;
-                    GlyphPlacement placements[MAX_BITMAPS];
-                    int placement_count = 0;  
-
-                    if (positions) {
-                        cJSON *pos_item = NULL;
-                        cJSON_ArrayForEach(pos_item, positions) {
-                            if (placement_count >= MAX_BITMAPS) break;
-
-                            cJSON *gIndexItem = cJSON_GetObjectItem(pos_item, "index");
-                            cJSON *xItem      = cJSON_GetObjectItem(pos_item, "x");
-                            cJSON *yItem      = cJSON_GetObjectItem(pos_item, "y");
-
-                            if (!cJSON_IsNumber(gIndexItem) || !cJSON_IsNumber(xItem) || !cJSON_IsNumber(yItem)) {
-                                continue;
-                            }
-
-                            placements[placement_count].glyph_index = (uint16_t)gIndexItem->valueint;
-                            placements[placement_count].x = (int16_t)xItem->valueint;
-                            placements[placement_count].y = (int16_t)yItem->valueint;
-                            placement_count++;
-                        }
-                    }                    
-
-                    if (quote && screen_model && fontsize && bitmaps && positions) {
-                        int font_size = fontsize->valueint;                 // 获取字号
-                        int bytes_per_char = (font_size * font_size) / 8;   // 计算每个字符的字节数                    
-                        ESP_LOGI(TAG, "语录内容: %s, 屏幕型号：%s, 字号: %d", quote->valuestring, screen_model->valuestring, font_size);
-
-                        cJSON *glyph_item = NULL;
-                        cJSON_ArrayForEach(glyph_item, bitmaps) {   // 逐个处理json消息的bitmaps字段对象
-                            if (glyph_count >= MAX_BITMAPS) break;
-
-                            const char *key = glyph_item->string;   // 获取当前对象的键名
-                            cJSON *array = glyph_item;              // 获取当前对象的值（数组）
-                            if (!array || !cJSON_IsArray(array)) continue;  // 确保值是数组类型
-
-                            // 复制键名到 GlyphBitmap 的 character 字段
-                            strncpy(glyphs[glyph_count].character, key, sizeof(glyphs[glyph_count].character) - 1); // 复制键名到 GlyphBitmap 的 character 字段
-                            glyphs[glyph_count].character[sizeof(glyphs[glyph_count].character) - 1] = '\0';    // 确保字符串以 null 结尾
-
-                            // 分配动态内存
-                            glyphs[glyph_count].data = malloc(bytes_per_char);
-                            if (!glyphs[glyph_count].data) {
-                                ESP_LOGE(TAG, "内存分配失败");
-                                continue;
-                            }
-
-                            // 复制数组数据到 GlyphBitmap 的 data 字段
-                            int i = 0;
-                            cJSON *num = NULL;
-                            cJSON_ArrayForEach(num, array) {
-                                if (i >= bytes_per_char) break;
-                                glyphs[glyph_count].data[i++] = (uint8_t)cJSON_GetNumberValue(num);
-                            }
-                            glyphs[glyph_count].width = font_size;
-                            glyphs[glyph_count].height = font_size;
-                            glyph_count++;
-                        }
-
-                        if (display_callback) {
-                            display_callback(screen_model->valuestring, quote->valuestring, glyphs, glyph_count, placements);
-                        }
-
-                        // 释放内存
-                        for (int i = 0; i < glyph_count; ++i) {
-                            if (glyphs[i].data) {
-                                free(glyphs[i].data);
-                            }
-                        }
-
-                    } else {
-                        ESP_LOGE(TAG, "字段 quote 或 bitmaps 无效");
-                    }
-                    cJSON_Delete(root);
-                } else {
-                    ESP_LOGE(TAG, "JSON 解析失败");
-                }
-            } else {
-                ESP_LOGE(TAG, "状态码错误或无响应数据");
+        char etag[ETAG_MAX_LEN];
+        char new_etag[ETAG_MAX_LEN] = "";
+        nvs_read_etag(etag, sizeof(etag));
+
+        char *glyph_summary = glyph_cache_summary();
+        fetch_result_t result = FETCH_FAILED;
+        http_session_t session;
+        // 请求头要整个放进发送缓冲区，0 为默认大小
+        if (http_session_open(&session, full_url, http_event_handler,
+                              glyph_summary ? (int)strlen(glyph_summary) + 1024 : 0) == ESP_OK) {
+            result = fetch_and_display_quote(&session, full_url, glyph_summary, etag, new_etag);
+            if (result == FETCH_RETRY) {
+                result = fetch_and_display_quote(&session, full_url, NULL, etag, new_etag);     // 复用同一个连接
             }
-        } else {
-            ESP_LOGE(TAG, "请求失败: %s", esp_err_to_name(err));
+            http_session_close(&session);
+        }
+        free(glyph_summary);
+        if (result == FETCH_FAILED && show_due_screen() == FETCH_SHOWN) {
+            ESP_LOGW(TAG, "联网失败，显示之前保存的屏幕");     // 服务器暂时不可用时按原来的时间表继续显示
         }
 
-        esp_http_client_cleanup(client);
 
         // 监控当前任务或指定任务的剩余栈空间
         // UBaseType_t high_water_mark = uxTaskGetStackHighWaterMark(NULL);
@@ -267,16 +356,19 @@ static void fetch_quote_task(void *pvParameters) {
         //vTaskDelay(pdMS_TO_TICKS(10 * 60 * 1000));  // 10分钟后再请求
 
         // 进入深度睡眠
-        vTaskDelay(pdMS_TO_TICKS(3 * 1000));   // 确保墨水屏刷新完毕
-        ESP_LOGI(TAG, "开始深度睡眠");
+        // 墨水屏刷新和HTTP清理并行进行，BUSY变为空闲后立即睡眠，不再固定等待3秒
+        // 304 时没有启动刷新，这里立即返回
+        bool display_done = !display_wait_callback || display_wait_callback(DISPLAY_WAIT_TIMEOUT_MS);
+        if (!display_done) {
+            ESP_LOGW(TAG, "墨水屏刷新超时");
+        }
 
-        rtc_gpio_deinit(WAKE_PIN);              // 切换为RTC模式
-        gpio_reset_pin(WAKE_PIN);               // 复位GPIO配置
-        rtc_gpio_init(WAKE_PIN);                // 初始化RTC引脚
-        rtc_gpio_set_direction(WAKE_PIN, RTC_GPIO_MODE_INPUT_ONLY); // 输入模式
-        esp_sleep_enable_ext0_wakeup(WAKE_PIN , 0);                 // 34号引脚低电平唤醒
-        esp_sleep_enable_timer_wakeup(REFRESH_INTERVAL_US);         // 定时唤醒
-        esp_deep_sleep_start();
+        // 刷新完成后才保存 ETag，服务器下次返回 304 时屏幕上确实是这份内容
+        if (result == FETCH_SHOWN && display_done && strcmp(new_etag, etag) != 0) {
+            nvs_write_etag(new_etag);
+        }
+        wake_policy_fetch_done(screen_ring_low_time());       // 有保存的屏幕时等它们快显示完再联网
+        enter_deep_sleep(wake_policy_sleep_us());
 
     }
 }
@@ -284,31 +376,30 @@ static void fetch_quote_task(void *pvParameters) {
 
 
 void start_quote_fetch_task(void) {
-    xTaskCreate(fetch_quote_task, "quote_task", 1024*15, NULL, 5, NULL);
+    xTaskCreate(fetch_quote_task, "quote_task", 1024*8, NULL, 5, NULL);     // 响应边收边解析，栈上不再放10KB的缓冲区
 }
 
 
-// 从NVS读取上一次的语录
-esp_err_t nvs_read_last_quote(char *last_quote, size_t max_len) {
+// 从NVS读取当前显示内容的ETag，没有时为空字符串
+esp_err_t nvs_read_etag(char *etag, size_t max_len) {
     esp_err_t err;
     nvs_handle_t nvs_handle;
 
-    // 打开NVS命名空间
+    etag[0] = '\0';
     err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
         ESP_LOGE("NVS", "Open namespace failed: %s", esp_err_to_name(err));
         return err;
     }
 
-    // 读取last_quote（默认初始化为空字符串）
     size_t len = max_len;
-    err = nvs_get_str(nvs_handle, NVS_KEY_LAST_QUOTE, last_quote, &len);
+    err = nvs_get_str(nvs_handle, NVS_KEY_ETAG, etag, &len);
     if (err == ESP_ERR_NVS_NOT_FOUND) {
-        ESP_LOGI("NVS", "No last quote in NVS, init as empty");
-        last_quote[0] = '\0';  // 首次运行时，设为空字符串
+        etag[0] = '\0';        // 首次运行，不带 If-None-Match
         err = ESP_OK;
     } else if (err != ESP_OK) {
-        ESP_LOGE("NVS", "Read last quote failed: %s", esp_err_to_name(err));
+        etag[0] = '\0';
+        ESP_LOGE("NVS", "Read etag failed: %s", esp_err_to_name(err));
     }
 
     nvs_close(nvs_handle);
@@ -316,35 +407,27 @@ esp_err_t nvs_read_last_quote(char *last_quote, size_t max_len) {
 }
 
 
-// 向NVS写入最新的语录
-esp_err_t nvs_write_last_quote(const char *new_quote) {
+// 向NVS写入当前显示内容的ETag，空字符串表示服务器没有给
+esp_err_t nvs_write_etag(const char *etag) {
     esp_err_t err;
     nvs_handle_t nvs_handle;
 
-    // 打开NVS命名空间
     err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
         ESP_LOGE("NVS", "Open namespace failed: %s", esp_err_to_name(err));
         return err;
     }
 
-    // 写入新语录（会覆盖旧值）
-    err = nvs_set_str(nvs_handle, NVS_KEY_LAST_QUOTE, new_quote);
+    err = nvs_set_str(nvs_handle, NVS_KEY_ETAG, etag);
     if (err != ESP_OK) {
-        ESP_LOGE("NVS", "Write last quote failed: %s", esp_err_to_name(err));
+        ESP_LOGE("NVS", "Write etag failed: %s", esp_err_to_name(err));
     } else {
-        // 提交写入（NVS需要手动提交才会生效）
         err = nvs_commit(nvs_handle);
         if (err != ESP_OK) {
-            ESP_LOGE("NVS", "Commit last quote failed: %s", esp_err_to_name(err));
+            ESP_LOGE("NVS", "Commit etag failed: %s", esp_err_to_name(err));
         }
     }
 
     nvs_close(nvs_handle);
     return err;
 }
-
-
-
-
-
@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 #define MAX_BITMAPS 64          // 一次语录不超过 64 个
@@ -29,7 +30,7 @@ typedef struct {
 
 // 定义一个结构体来存储每个字符在画布上的位置
 typedef struct {
-    uint16_t glyph_index;       // 指向字符内容的下标，因为字模是去重过的
+    uint16_t glyph_index;       // 指向字符内容的下标，因为字模是去重过的，即 bitmaps 中的顺序
     int16_t x;
     int16_t y;
 } GlyphPlacement;
@@ -47,13 +48,38 @@ typedef enum {
 void start_quote_fetch_task(void);  
 
 // 回调类型定义
-typedef void (*quote_display_callback_t)(const char *screen_model, const char *quote, const GlyphBitmap *bitmaps, int count, const GlyphPlacement *placements);
+typedef void (*quote_display_callback_t)(const char *screen_model, const char *quote, int font_size,
+                                         const GlyphBitmap *bitmaps, int count,
+                                         const GlyphPlacement *placements, int placement_count);
 
 // 注册显示回调
 void register_quote_display_callback(quote_display_callback_t callback);
 
-esp_err_t nvs_read_last_quote(char *last_quote, size_t max_len);
-esp_err_t nvs_write_last_quote(const char *new_quote);
+// 等待刷新完成回调类型定义，显示回调可以只启动刷新，深度睡眠前再通过它等待完成，返回 false 表示超时
+typedef bool (*quote_display_wait_callback_t)(uint32_t timeout_ms);
+
+#define DISPLAY_WAIT_TIMEOUT_MS 60000         // 等待墨水屏刷新完成的最长时间，联网和本地刷新都用它
+
+// 注册等待刷新完成回调
+void register_quote_display_wait_callback(quote_display_wait_callback_t callback);
+
+// 缺字检查回调类型定义，返回本地和服务器都没有字模的字数，请求带了缓存摘要时在显示前调用
+typedef int (*quote_glyph_check_callback_t)(const char *screen_model, const char *quote, int font_size,
+                                            const GlyphBitmap *bitmaps, int count,
+                                            const GlyphPlacement *placements, int placement_count);
+
+// 注册缺字检查回调
+void register_quote_glyph_check_callback(quote_glyph_check_callback_t callback);
+
+// 定时唤醒时不联网，显示屏幕缓存里到时间的一屏，作为唤醒策略的本地刷新回调
+// 返回：   true,已显示或还没到下一屏的时间；false,没有保存的屏幕、记录损坏或缺字，需要联网
+bool quote_fetcher_show_stored(void);
+
+// 屏幕缓存里下一屏的显示时间，time() 的秒数，没有时返回 0，作为唤醒策略的本地刷新时间回调
+int64_t quote_fetcher_next_screen_time(void);
+
+esp_err_t nvs_read_etag(char *etag, size_t max_len);
+esp_err_t nvs_write_etag(const char *etag);
 
 
 #ifdef __cplusplus
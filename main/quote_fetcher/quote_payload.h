@@ -0,0 +1,64 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// 二进制语录响应，请求时 Accept 里带上 QUOTE_PAYLOAD_MIME，服务器支持时用它代替 JSON：
+//   文件头      16 字节，见 quote_payload_header_t
+//   屏幕型号    model_len 字节，含结尾的 '\0'
+//   语录文本    quote_len 字节，UTF-8，含结尾的 '\0'
+//   字模表      glyph_count 项，每项 8 字节：uint32 码点、uint8 宽、uint8 高、uint16 标志
+//   位置表      placement_count 项，每项 6 字节：uint16 字模下标、int16 x、int16 y
+//   点阵        没有 QUOTE_GLYPH_NO_BITMAP 标志的字模依次存放，每个 (宽*高+7)/8 字节
+// 所有整数都是小端。各部分按顺序排列，边收边解析，见 quote_stream.h
+
+#define QUOTE_PAYLOAD_MIME      "application/x-epaper-quote"
+#define QUOTE_PAYLOAD_MAGIC     0x31515045      // "EPQ1"
+#define QUOTE_PAYLOAD_VERSION   1
+
+#define QUOTE_GLYPH_NO_BITMAP   0x0001          // 服务器没有发点阵（设备已缓存或字库里有），显示时到本地查找
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // QUOTE_PAYLOAD_MAGIC
+    uint8_t  version;           // QUOTE_PAYLOAD_VERSION
+    uint8_t  font_size;         // 字号
+    uint16_t glyph_count;       // 字模表项数
+    uint16_t placement_count;   // 位置表项数
+    uint16_t quote_len;         // 语录文本字节数，含 '\0'
+    uint8_t  model_len;         // 屏幕型号字节数，含 '\0'
+    uint8_t  reserved[3];
+} quote_payload_header_t;
+
+_Static_assert(sizeof(quote_payload_header_t) == 16, "quote_payload_header_t must be 16 bytes");
+
+// 批量响应，设备有屏幕缓存分区时请求带 batch=N，Accept 里 QUOTE_BATCH_MIME 优先，一次下载之后的 N 屏：
+//   文件头      8 字节，见 quote_batch_header_t
+//   每屏        8 字节的 quote_batch_entry_t，后面是 len 字节的二进制语录（上面的格式）
+// 每屏的显示时间是相对服务器生成响应时的秒数，按顺序递增，第一屏一般为 0（立即显示）
+// 不支持批量的服务器照常返回单条语录，设备按 Content-Type 区分；批量响应没有 ETag，也不返回 304
+
+#define QUOTE_BATCH_MIME        "application/x-epaper-batch"
+#define QUOTE_BATCH_MAGIC       0x31425045      // "EPB1"
+#define QUOTE_BATCH_VERSION     1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // QUOTE_BATCH_MAGIC
+    uint8_t  version;           // QUOTE_BATCH_VERSION
+    uint8_t  count;             // 屏数
+    uint16_t reserved;
+} quote_batch_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t display_offset;    // 显示时间，相对响应的秒数
+    uint32_t len;               // 这一屏二进制语录的字节数
+} quote_batch_entry_t;
+
+_Static_assert(sizeof(quote_batch_header_t) == 8, "quote_batch_header_t must be 8 bytes");
+_Static_assert(sizeof(quote_batch_entry_t) == 8, "quote_batch_entry_t must be 8 bytes");
+
+#ifdef __cplusplus
+}
+#endif
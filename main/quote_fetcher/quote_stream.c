@@ -0,0 +1,620 @@
+#include "quote_stream.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "epaper_gui.h"
+
+#define TAG "QSTREAM"
+
+// 二进制语录的各部分，按顺序接收
+enum {
+    BIN_HEADER = 0,
+    BIN_MODEL,
+    BIN_QUOTE,
+    BIN_TABLE,
+    BIN_PLACES,
+    BIN_BITMAPS,
+    BIN_DONE,
+};
+
+// JSON 词法状态
+enum {
+    LEX_VALUE = 0,          // 等待值或结构符号
+    LEX_STRING,
+    LEX_ESCAPE,             // 字符串里的 '\' 之后
+    LEX_UNICODE,            // \uXXXX
+    LEX_NUMBER,
+    LEX_LITERAL,            // true / false / null
+    LEX_DONE,               // 最外层对象已结束
+};
+
+// 第1层关心的键，have 里对应的位是 1 << 键
+enum {
+    KEY_OTHER = 0,
+    KEY_QUOTE,
+    KEY_MODEL,
+    KEY_FONTSIZE,
+    KEY_BITMAPS,
+    KEY_POSITIONS,
+};
+#define HAVE_ALL    ((1 << KEY_QUOTE) | (1 << KEY_MODEL) | (1 << KEY_FONTSIZE) | (1 << KEY_BITMAPS) | (1 << KEY_POSITIONS))
+
+// positions 对象里的键，place_have 里的位
+#define ITEM_INDEX  0x01
+#define ITEM_X      0x02
+#define ITEM_Y      0x04
+
+// 按小端读整数，表项在缓冲区里不一定对齐
+static inline uint16_t rd16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t rd32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 码点编码成 UTF-8，返回字节数，无效码点返回0
+static int utf8_encode(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = 0xC0 | (cp >> 6);
+        out[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = 0xE0 | (cp >> 12);
+        out[1] = 0x80 | ((cp >> 6) & 0x3F);
+        out[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    } else if (cp < 0x110000) {
+        out[0] = 0xF0 | (cp >> 18);
+        out[1] = 0x80 | ((cp >> 12) & 0x3F);
+        out[2] = 0x80 | ((cp >> 6) & 0x3F);
+        out[3] = 0x80 | (cp & 0x3F);
+        return 4;
+    }
+    return 0;
+}
+
+// glyph_buf 里的点阵收齐了：优先交给 sink 写到最终位置，否则 malloc 保留一份
+// 参数：   g,字模，character 已填好
+//          width,height,点阵尺寸，glyph_len 不足的部分补0
+static void glyph_ready(quote_stream_t *s, GlyphBitmap *g, int width, int height) {
+    uint32_t n = ((uint32_t)width * height + 7) / 8;
+    int len;
+
+    g->data = NULL;
+    g->width = 0;
+    g->height = 0;
+    if (n == 0 || n > QUOTE_STREAM_GLYPH_BYTES) {
+        return;                                 // 无效的字模也占一个下标，显示时跳过
+    }
+    if (s->glyph_len < n) {
+        memset(s->glyph_buf + s->glyph_len, 0, n - s->glyph_len);
+    }
+    g->width = width;
+    g->height = height;
+
+    // 缓存按 (码点, 字号) 查找，取出时按字号的方格画，只有方格大小的字模能交给 sink
+    uint32_t codepoint = EPD_UTF8_Decode(g->character, &len);
+    if (s->sink && len > 0 && width == s->font_size && height == s->font_size &&
+        s->sink(codepoint, s->font_size, s->glyph_buf, n)) {
+        return;
+    }
+    g->data = malloc(n);
+    if (g->data == NULL) {
+        ESP_LOGE(TAG, "内存分配失败");
+        return;
+    }
+    memcpy(g->data, s->glyph_buf, n);
+}
+
+// ---------------------------------------------------------------- 二进制语录
+
+// 从输入里取够 want 字节放到 dst，不够时先收下已有的，返回是否取够
+static bool bin_take(quote_stream_t *s, const uint8_t **data, size_t *len, uint8_t *dst, uint32_t want) {
+    uint32_t n = want - s->bin.got;
+
+    if (n > *len) {
+        n = *len;
+    }
+    if (n > 0) {
+        memcpy(dst + s->bin.got, *data, n);
+    }
+    *data += n;
+    *len -= n;
+    s->bin.got += n;
+    if (s->bin.got < want) {
+        return false;
+    }
+    s->bin.got = 0;
+    return true;
+}
+
+static esp_err_t bin_feed(quote_stream_t *s, const uint8_t *data, size_t len) {
+    const quote_payload_header_t *h = &s->bin.head;
+
+    for (;;) {
+        switch (s->bin.state) {
+            case BIN_HEADER:
+                if (!bin_take(s, &data, &len, s->bin.item_buf, sizeof(*h))) {
+                    return ESP_OK;
+                }
+                memcpy(&s->bin.head, s->bin.item_buf, sizeof(*h));
+                if (h->magic != QUOTE_PAYLOAD_MAGIC || h->version != QUOTE_PAYLOAD_VERSION) {
+                    return ESP_ERR_INVALID_VERSION;
+                }
+                if (h->glyph_count > MAX_BITMAPS ||
+                    h->model_len == 0 || h->model_len > QUOTE_STREAM_MODEL_LEN ||
+                    h->quote_len == 0 || h->quote_len > QUOTE_STREAM_QUOTE_LEN) {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                s->font_size = h->font_size;
+                s->bin.state = BIN_MODEL;
+                break;
+
+            case BIN_MODEL:
+                if (!bin_take(s, &data, &len, (uint8_t *)s->screen_model, h->model_len)) {
+                    return ESP_OK;
+                }
+                if (s->screen_model[h->model_len - 1] != '\0') {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                s->bin.state = BIN_QUOTE;
+                break;
+
+            case BIN_QUOTE:
+                if (!bin_take(s, &data, &len, (uint8_t *)s->quote, h->quote_len)) {
+                    return ESP_OK;
+                }
+                if (s->quote[h->quote_len - 1] != '\0') {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                s->bin.state = BIN_TABLE;
+                s->bin.item = 0;
+                break;
+
+            case BIN_TABLE:
+                if (s->bin.item == h->glyph_count) {
+                    s->bin.state = BIN_PLACES;
+                    s->bin.item = 0;
+                    break;
+                }
+                if (!bin_take(s, &data, &len, s->bin.item_buf, 8)) {
+                    return ESP_OK;
+                }
+                {
+                    GlyphBitmap *g = &s->glyphs[s->bin.item];
+                    const uint8_t *e = s->bin.item_buf;
+                    int n = utf8_encode(rd32(e), g->character);
+                    g->character[n] = '\0';
+                    g->data = NULL;
+                    g->width = e[4];
+                    g->height = e[5];
+                    s->bin.has_bitmap[s->bin.item] = !(rd16(e + 6) & QUOTE_GLYPH_NO_BITMAP);
+                    if (s->bin.has_bitmap[s->bin.item] &&
+                        ((uint32_t)g->width * g->height == 0 ||
+                         ((uint32_t)g->width * g->height + 7) / 8 > QUOTE_STREAM_GLYPH_BYTES)) {
+                        return ESP_ERR_INVALID_SIZE;
+                    }
+                    s->glyph_count = ++s->bin.item;
+                }
+                break;
+
+            case BIN_PLACES:
+                if (s->bin.item == h->placement_count) {
+                    s->bin.state = BIN_BITMAPS;
+                    s->bin.item = 0;
+                    break;
+                }
+                if (!bin_take(s, &data, &len, s->bin.item_buf, 6)) {
+                    return ESP_OK;
+                }
+                if (s->placement_count < MAX_BITMAPS) {     // 多出来的位置丢掉，与 JSON 相同
+                    GlyphPlacement *p = &s->placements[s->placement_count++];
+                    p->glyph_index = rd16(s->bin.item_buf);
+                    p->x = (int16_t)rd16(s->bin.item_buf + 2);
+                    p->y = (int16_t)rd16(s->bin.item_buf + 4);
+                }
+                s->bin.item++;
+                break;
+
+            case BIN_BITMAPS:
+                while (s->bin.item < h->glyph_count && !s->bin.has_bitmap[s->bin.item]) {
+                    s->bin.item++;
+                }
+                if (s->bin.item == h->glyph_count) {
+                    s->bin.state = BIN_DONE;
+                    break;
+                }
+                {
+                    GlyphBitmap *g = &s->glyphs[s->bin.item];
+                    uint32_t n = ((uint32_t)g->width * g->height + 7) / 8;
+                    if (!bin_take(s, &data, &len, s->glyph_buf, n)) {
+                        return ESP_OK;
+                    }
+                    s->glyph_len = n;
+                    glyph_ready(s, g, g->width, g->height);
+                }
+                s->bin.item++;
+                break;
+
+            default:
+                return ESP_OK;                  // 后面多余的数据忽略
+        }
+    }
+}
+
+// ---------------------------------------------------------------- JSON
+
+// bitmaps 里的一个字结束，has_data 为 false 时值不是数组，这个字也占一个下标
+static void json_glyph(quote_stream_t *s, bool has_data) {
+    if (s->glyph_count >= MAX_BITMAPS) {
+        return;
+    }
+    int i = s->glyph_count++;
+    GlyphBitmap *g = &s->glyphs[i];
+    memcpy(g->character, s->json.glyph_char, sizeof(g->character));
+    g->data = NULL;
+    g->width = 0;
+    g->height = 0;
+    if (!has_data) {
+        return;
+    }
+    if (s->json.have & (1 << KEY_FONTSIZE)) {
+        glyph_ready(s, g, s->font_size, s->font_size);
+    } else if (s->glyph_len > 0) {
+        // 字号还没出现，不知道尺寸和缓存的键，先留一份，收完后再处理
+        g->data = malloc(s->glyph_len);
+        if (g->data == NULL) {
+            ESP_LOGE(TAG, "内存分配失败");
+            return;
+        }
+        memcpy(g->data, s->glyph_buf, s->glyph_len);
+        s->json.pending_len[i] = s->glyph_len;
+    }
+}
+
+// 第1层的键
+static uint8_t json_top_key(const char *k) {
+    if (strcmp(k, "quote") == 0) {
+        return KEY_QUOTE;
+    } else if (strcmp(k, "screen_model") == 0) {
+        return KEY_MODEL;
+    } else if (strcmp(k, "fontsize") == 0) {
+        return KEY_FONTSIZE;
+    } else if (strcmp(k, "bitmaps") == 0) {
+        return KEY_BITMAPS;
+    } else if (strcmp(k, "positions") == 0) {
+        return KEY_POSITIONS;
+    }
+    return KEY_OTHER;
+}
+
+static void json_key(quote_stream_t *s) {
+    const char *k = s->json.tok;
+    int d = s->json.depth;
+
+    if (d == 1) {
+        s->json.top_key = json_top_key(k);
+    } else if (d == 2 && s->json.top_key == KEY_BITMAPS) {
+        strncpy(s->json.glyph_char, k, sizeof(s->json.glyph_char) - 1);
+        s->json.glyph_char[sizeof(s->json.glyph_char) - 1] = '\0';
+    } else if (d == 3 && s->json.top_key == KEY_POSITIONS) {
+        s->json.item_key = strcmp(k, "index") == 0 ? ITEM_INDEX :
+                           strcmp(k, "x") == 0 ? ITEM_X :
+                           strcmp(k, "y") == 0 ? ITEM_Y : 0;
+    }
+}
+
+// 一个字符串、数字或字面量结束
+// 参数：   lex,值的类型 LEX_STRING / LEX_NUMBER / LEX_LITERAL
+static void json_scalar(quote_stream_t *s, uint8_t lex) {
+    int d = s->json.depth;
+    long num = (lex == LEX_NUMBER) ? strtol(s->json.tok, NULL, 10) : 0;
+
+    if (d == 0) {
+        s->err = ESP_ERR_INVALID_RESPONSE;      // 最外层必须是对象
+    } else if (d == 1) {
+        uint8_t key = s->json.top_key;
+        if (key == KEY_QUOTE && lex == LEX_STRING) {
+            if (s->json.tok_overflow) {
+                s->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            memcpy(s->quote, s->json.tok, s->json.tok_len + 1);
+        } else if (key == KEY_MODEL && lex == LEX_STRING) {
+            if (s->json.tok_overflow || s->json.tok_len >= QUOTE_STREAM_MODEL_LEN) {
+                s->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            memcpy(s->screen_model, s->json.tok, s->json.tok_len + 1);
+        } else if (key == KEY_FONTSIZE && lex == LEX_NUMBER) {
+            if (num <= 0 || num > 255) {
+                s->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            s->font_size = num;
+        } else {
+            return;
+        }
+        s->json.have |= 1 << key;
+    } else if (s->json.top_key == KEY_BITMAPS) {
+        if (d == 2) {
+            json_glyph(s, false);
+        } else if (d == 3 && s->json.stack[2] == '[' && lex == LEX_NUMBER &&
+                   s->glyph_len < QUOTE_STREAM_GLYPH_BYTES) {
+            s->glyph_buf[s->glyph_len++] = (uint8_t)num;
+        }
+    } else if (s->json.top_key == KEY_POSITIONS && d == 3 && s->json.stack[2] == '{' && lex == LEX_NUMBER) {
+        if (s->json.item_key == ITEM_INDEX) {
+            s->json.place.glyph_index = (uint16_t)num;
+        } else if (s->json.item_key == ITEM_X) {
+            s->json.place.x = (int16_t)num;
+        } else if (s->json.item_key == ITEM_Y) {
+            s->json.place.y = (int16_t)num;
+        }
+        s->json.place_have |= s->json.item_key;
+    }
+}
+
+static void json_open(quote_stream_t *s, char c) {
+    int d = s->json.depth + 1;
+
+    if (d > QUOTE_STREAM_DEPTH) {
+        s->err = ESP_ERR_INVALID_SIZE;
+        return;
+    }
+    if (d == 3 && s->json.top_key == KEY_BITMAPS && c == '[') {
+        s->glyph_len = 0;
+    } else if (d == 3 && s->json.top_key == KEY_POSITIONS && c == '{') {
+        s->json.place_have = 0;
+        s->json.item_key = 0;
+    }
+    s->json.stack[d - 1] = c;
+    s->json.depth = d;
+    s->json.want_key = (c == '{');
+}
+
+static void json_close(quote_stream_t *s, char c) {
+    int d = s->json.depth;
+
+    if (d == 0 || s->json.stack[d - 1] != (c == '}' ? '{' : '[')) {
+        s->err = ESP_ERR_INVALID_RESPONSE;
+        return;
+    }
+    if (d == 3 && s->json.top_key == KEY_BITMAPS) {
+        json_glyph(s, c == ']');
+    } else if (d == 3 && s->json.top_key == KEY_POSITIONS && c == '}') {
+        // 缺少字段的位置跳过，与原来的解析相同
+        if (s->json.place_have == (ITEM_INDEX | ITEM_X | ITEM_Y) && s->placement_count < MAX_BITMAPS) {
+            s->placements[s->placement_count++] = s->json.place;
+        }
+    } else if (d == 2 && (s->json.top_key == KEY_BITMAPS || s->json.top_key == KEY_POSITIONS)) {
+        s->json.have |= 1 << s->json.top_key;
+    }
+    s->json.depth = d - 1;
+    s->json.want_key = false;
+    if (d == 1) {
+        s->json.lex = LEX_DONE;
+    }
+}
+
+static void json_tok_put(quote_stream_t *s, char c) {
+    if (s->json.tok_len < sizeof(s->json.tok) - 1) {
+        s->json.tok[s->json.tok_len++] = c;
+        s->json.tok[s->json.tok_len] = '\0';
+    } else {
+        s->json.tok_overflow = true;
+    }
+}
+
+static void json_tok_start(quote_stream_t *s, uint8_t lex) {
+    s->json.lex = lex;
+    s->json.tok_len = 0;
+    s->json.tok[0] = '\0';
+    s->json.tok_overflow = false;
+}
+
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+static void json_char(quote_stream_t *s, uint8_t c) {
+    switch (s->json.lex) {
+        case LEX_STRING:
+            if (c == '"') {
+                s->json.lex = LEX_VALUE;
+                if (s->json.want_key) {
+                    s->json.want_key = false;
+                    json_key(s);
+                } else {
+                    json_scalar(s, LEX_STRING);
+                }
+            } else if (c == '\\') {
+                s->json.lex = LEX_ESCAPE;
+            } else {
+                json_tok_put(s, c);
+            }
+            return;
+
+        case LEX_ESCAPE: {
+            static const char from[] = "\"\\/bfnrt";
+            static const char to[] = "\"\\/\b\f\n\r\t";
+            const char *e = (c != '\0') ? strchr(from, c) : NULL;
+            if (c == 'u') {
+                s->json.lex = LEX_UNICODE;
+                s->json.hex_n = 0;
+                s->json.ucs = 0;
+            } else if (e) {
+                json_tok_put(s, to[e - from]);
+                s->json.lex = LEX_STRING;
+            } else {
+                s->err = ESP_ERR_INVALID_RESPONSE;
+            }
+            return;
+        }
+
+        case LEX_UNICODE: {
+            int v = hex_value(c);
+            if (v < 0) {
+                s->err = ESP_ERR_INVALID_RESPONSE;
+                return;
+            }
+            s->json.ucs = (s->json.ucs << 4) | v;
+            if (++s->json.hex_n < 4) {
+                return;
+            }
+            uint32_t cp = s->json.ucs;
+            s->json.lex = LEX_STRING;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                s->json.high_surrogate = cp;    // 代理对的前一半，等后一半
+                return;
+            }
+            if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                if (s->json.high_surrogate == 0) {
+                    return;                     // 单独的后一半，丢掉
+                }
+                cp = 0x10000 + ((s->json.high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+            }
+            s->json.high_surrogate = 0;
+            char u[4];
+            int n = utf8_encode(cp, u);
+            for (int i = 0; i < n; i++) {
+                json_tok_put(s, u[i]);
+            }
+            return;
+        }
+
+        case LEX_NUMBER:
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+                json_tok_put(s, c);
+                return;
+            }
+            s->json.lex = LEX_VALUE;
+            json_scalar(s, LEX_NUMBER);
+            break;                              // c 是数字后面的符号，继续处理
+
+        case LEX_LITERAL:
+            if (c >= 'a' && c <= 'z') {
+                json_tok_put(s, c);
+                return;
+            }
+            s->json.lex = LEX_VALUE;
+            if (strcmp(s->json.tok, "null") != 0 && strcmp(s->json.tok, "true") != 0 &&
+                strcmp(s->json.tok, "false") != 0) {
+                s->err = ESP_ERR_INVALID_RESPONSE;
+                return;
+            }
+            json_scalar(s, LEX_LITERAL);
+            break;
+
+        case LEX_DONE:
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                s->err = ESP_ERR_INVALID_RESPONSE;
+            }
+            return;
+
+        default:
+            break;
+    }
+    if (s->err != ESP_OK) {
+        return;
+    }
+
+    // LEX_VALUE
+    switch (c) {
+        case ' ': case '\t': case '\r': case '\n': case ':':
+            break;
+        case '{': case '[':
+            json_open(s, c);
+            break;
+        case '}': case ']':
+            json_close(s, c);
+            break;
+        case ',':
+            s->json.want_key = (s->json.depth > 0 && s->json.stack[s->json.depth - 1] == '{');
+            break;
+        case '"':
+            json_tok_start(s, LEX_STRING);
+            break;
+        default:
+            if ((c >= '0' && c <= '9') || c == '-') {
+                json_tok_start(s, LEX_NUMBER);
+                json_tok_put(s, c);
+            } else if (c >= 'a' && c <= 'z') {
+                json_tok_start(s, LEX_LITERAL);
+                json_tok_put(s, c);
+            } else {
+                s->err = ESP_ERR_INVALID_RESPONSE;
+            }
+            break;
+    }
+}
+
+// 字号出现之前收到的字模，现在知道尺寸了，按正常的字模处理
+static void json_finish_pending(quote_stream_t *s) {
+    for (int i = 0; i < s->glyph_count; i++) {
+        GlyphBitmap *g = &s->glyphs[i];
+        if (g->data == NULL || g->width != 0) {
+            continue;
+        }
+        s->glyph_len = s->json.pending_len[i];
+        memcpy(s->glyph_buf, g->data, s->glyph_len);
+        free(g->data);
+        glyph_ready(s, g, s->font_size, s->font_size);
+    }
+}
+
+// ---------------------------------------------------------------- 接口
+
+void quote_stream_begin(quote_stream_t *s, bool binary, quote_glyph_sink_t sink) {
+    memset(s, 0, sizeof(*s));
+    s->binary = binary;
+    s->sink = sink;
+}
+
+esp_err_t quote_stream_feed(quote_stream_t *s, const uint8_t *data, size_t len) {
+    if (s->err != ESP_OK) {
+        return s->err;
+    }
+    if (s->binary) {
+        s->err = bin_feed(s, data, len);
+    } else {
+        for (size_t i = 0; i < len && s->err == ESP_OK; i++) {
+            json_char(s, data[i]);
+        }
+    }
+    return s->err;
+}
+
+esp_err_t quote_stream_end(quote_stream_t *s) {
+    if (s->err != ESP_OK) {
+        return s->err;
+    }
+    if (s->binary) {
+        s->err = bin_feed(s, NULL, 0);          // 走完后面没有数据的部分
+        if (s->err == ESP_OK && s->bin.state != BIN_DONE) {
+            s->err = ESP_ERR_INVALID_SIZE;      // 响应不完整
+        }
+    } else if (s->json.lex != LEX_DONE || (s->json.have & HAVE_ALL) != HAVE_ALL) {
+        s->err = ESP_ERR_INVALID_RESPONSE;      // 不完整或缺少字段
+    } else {
+        json_finish_pending(s);
+    }
+    return s->err;
+}
+
+void quote_stream_release(quote_stream_t *s) {
+    for (int i = 0; i < s->glyph_count; i++) {
+        free(s->glyphs[i].data);
+        s->glyphs[i].data = NULL;
+    }
+    s->glyph_count = 0;
+    s->placement_count = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "quote_fetcher.h"
+#include "quote_payload.h"
+
+// 边收边解析语录响应，HTTP_EVENT_ON_DATA 收到一段就解析一段，不保存整个响应：
+//   JSON 和二进制语录（quote_payload.h）都支持，占用的内存只取决于下面几个上限，与响应长度无关
+//   每个字模的点阵收齐后交给 sink 写到最终位置（flash 字模缓存），显示时按码点和字号去找；
+//   sink 没有保存时才 malloc 一份放在 glyphs[i].data，由 quote_stream_release 释放
+
+#define QUOTE_STREAM_MODEL_LEN      32              // 屏幕型号最大字节数，含 '\0'
+#define QUOTE_STREAM_QUOTE_LEN      512             // 语录文本最大字节数，含 '\0'，也是 JSON 字符串的缓冲区大小
+#define QUOTE_STREAM_GLYPH_BYTES    FONT_72_SIZE    // 单个字模点阵最大字节数，与字模缓存相同
+#define QUOTE_STREAM_DEPTH          8               // JSON 最大嵌套层数
+
+// 字模点阵的最终去处，返回 true 表示已经保存，之后按 (码点, 字号) 查找；返回 false 时由解析器保留一份
+typedef bool (*quote_glyph_sink_t)(uint32_t codepoint, int font_size, const uint8_t *data, uint16_t len);
+
+typedef struct {
+    // 解析结果，quote_stream_end 返回 ESP_OK 后有效
+    char screen_model[QUOTE_STREAM_MODEL_LEN];
+    char quote[QUOTE_STREAM_QUOTE_LEN];
+    int font_size;
+    GlyphBitmap glyphs[MAX_BITMAPS];            // 交给 sink 保存的字模 data 为 NULL
+    int glyph_count;
+    GlyphPlacement placements[MAX_BITMAPS];
+    int placement_count;
+
+    // 解析状态
+    quote_glyph_sink_t sink;
+    bool binary;
+    esp_err_t err;                              // 第一个错误，出错后不再解析
+    uint8_t glyph_buf[QUOTE_STREAM_GLYPH_BYTES];    // 正在接收的字模点阵
+    uint16_t glyph_len;
+    union {
+        struct {
+            uint8_t state;
+            uint8_t item_buf[sizeof(quote_payload_header_t)];   // 文件头、字模表项、位置表项
+            uint32_t got;                       // 当前部分已收到的字节数
+            quote_payload_header_t head;
+            int item;                           // 当前表项或字模的下标
+            bool has_bitmap[MAX_BITMAPS];
+        } bin;
+        struct {
+            uint8_t lex;                        // 词法状态
+            uint8_t depth;
+            char stack[QUOTE_STREAM_DEPTH];     // 每层容器：'{' 或 '['
+            bool want_key;                      // 对象里下一个字符串是键
+            uint8_t top_key;                    // 第1层当前的键
+            uint8_t item_key;                   // positions 里第3层当前的键
+            char tok[QUOTE_STREAM_QUOTE_LEN];   // 字符串、数字和字面量
+            uint16_t tok_len;
+            bool tok_overflow;
+            uint8_t hex_n;                      // \uXXXX 已读的十六进制位数
+            uint32_t ucs;
+            uint32_t high_surrogate;
+            char glyph_char[UTF8_CHAR_BUF_LEN]; // bitmaps 里当前的字
+            GlyphPlacement place;
+            uint8_t place_have;                 // 已有的 index/x/y，按位
+            uint8_t have;                       // 已有的第1层字段，按位
+            uint16_t pending_len[MAX_BITMAPS];  // 字号出现之前收到的字模，先 malloc 保留的字节数
+        } json;
+    };
+} quote_stream_t;
+
+// 开始解析一个响应
+// 参数：   binary,true 为二进制语录，false 为 JSON
+//          sink,字模点阵的去处，NULL 时全部 malloc 保留
+void quote_stream_begin(quote_stream_t *s, bool binary, quote_glyph_sink_t sink);
+
+// 解析收到的一段数据，返回第一个错误，之后的数据忽略
+esp_err_t quote_stream_feed(quote_stream_t *s, const uint8_t *data, size_t len);
+
+// 响应收完，检查是否完整
+// 返回：   ESP_OK,解析结果可用；ESP_ERR_INVALID_SIZE,长度不对或超过上限；ESP_ERR_INVALID_RESPONSE,格式错误或缺少字段
+esp_err_t quote_stream_end(quote_stream_t *s);
+
+// 释放解析器保留的字模
+void quote_stream_release(quote_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,377 @@
+#include "screen_ring.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_partition.h"
+#include "quote_payload.h"
+#include "epaper_framediff.h"
+
+#define TAG "SCREENS"
+
+#define SECTOR_SIZE         4096
+#define RING_MAGIC          0x474E4952      // "RING"，RTC 内存里的记录有效
+#define RECORD_MAGIC        0x31524353      // "SCR1"
+#define RECORD_ALIGN        16
+#define WRITE_BUF_SIZE      512             // 攒够这么多再写 flash
+#define READ_BUF_SIZE       512
+
+typedef struct {
+    uint32_t magic;
+    uint32_t len;           // 二进制语录字节数
+    uint32_t check;         // 二进制语录的哈希，写到一半掉电或被覆盖的记录校验不过
+    uint32_t reserved;
+} record_head_t;
+
+typedef struct {
+    uint32_t off;           // 记录在分区里的偏移
+    uint32_t len;
+    int64_t display_at;     // 显示时间，time() 的秒数
+} screen_item_t;
+
+// 放在RTC内存，深度睡眠后保留
+typedef struct {
+    uint32_t magic;                 // 等于 RING_MAGIC 才有效
+    uint32_t write_off;             // 下一条记录的位置，它所在扇区的后半部分已经擦除
+    uint8_t count;
+    int8_t shown;                   // 最后显示的屏，-1 表示这一批还没有显示过
+    screen_item_t items[SCREEN_RING_MAX];
+} ring_state_t;
+
+static RTC_DATA_ATTR ring_state_t ring;
+
+static const esp_partition_t *part = NULL;
+
+enum { ST_HEADER, ST_ENTRY, ST_DATA, ST_SKIP, ST_DONE };
+
+// 批量响应的解析和写入状态
+static struct {
+    uint8_t state;
+    esp_err_t err;                  // 第一个错误，出错后不再解析
+    int64_t now;
+    uint8_t item_buf[sizeof(quote_batch_header_t)];
+    uint32_t got;                   // 当前部分已收到的字节数
+    quote_batch_header_t head;
+    quote_batch_entry_t entry;
+    int entry_index;
+    uint32_t last_offset;           // 上一屏的显示时间
+    uint32_t erased_end;            // 这一圈已经擦除到的位置
+    uint32_t first_off;             // 这一批第一屏的位置，回到开头后擦除不能碰到它所在的扇区
+    bool wrapped;                   // 第一屏之后回到过分区开头
+    uint32_t rec_off;
+    uint32_t check;
+    uint8_t write_buf[WRITE_BUF_SIZE];
+    uint16_t write_len;
+    uint32_t write_pos;             // write_buf 对应的分区偏移
+} store;
+
+static inline uint32_t align_up(uint32_t n, uint32_t a) {
+    return (n + a - 1) & ~(a - 1);
+}
+
+// 查找屏幕缓存分区，RTC 内存里的记录无效时清空
+esp_err_t screen_ring_open(void) {
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, SCREEN_RING_PARTITION);
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (part->size < 2 * SECTOR_SIZE) {
+        part = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ring.magic != RING_MAGIC || ring.write_off >= part->size || ring.count > SCREEN_RING_MAX) {
+        memset(&ring, 0, sizeof(ring));
+        ring.shown = -1;
+        ring.magic = RING_MAGIC;
+    }
+    ESP_LOGI(TAG, "屏幕缓存: %d 屏，已显示到第 %d 屏", ring.count, ring.shown + 1);
+    return ESP_OK;
+}
+
+bool screen_ring_available(void) {
+    return part != NULL;
+}
+
+void screen_ring_clear(void) {
+    ring.count = 0;
+    ring.shown = -1;
+}
+
+void screen_ring_store_begin(int64_t now) {
+    memset(&store, 0, sizeof(store));
+    store.state = ST_HEADER;
+    store.now = now;
+    store.err = part ? ESP_OK : ESP_ERR_INVALID_STATE;
+    store.erased_end = align_up(ring.write_off, SECTOR_SIZE);
+    screen_ring_clear();
+}
+
+// 把 write_buf 写到 flash
+static esp_err_t store_flush(void) {
+    esp_err_t err = ESP_OK;
+
+    if (store.write_len) {
+        err = esp_partition_write(part, store.write_pos, store.write_buf, store.write_len);
+        store.write_pos += store.write_len;
+        store.write_len = 0;
+    }
+    return err;
+}
+
+// 开始一条记录：找位置，擦除要用到的扇区
+static esp_err_t record_begin(void) {
+    uint32_t size = align_up(sizeof(record_head_t) + store.entry.len, RECORD_ALIGN);
+    uint32_t off = ring.write_off;
+    uint32_t erased_end = store.erased_end;
+    bool wrap = off + size > part->size;
+    esp_err_t err;
+
+    if (wrap) {
+        off = 0;                                // 分区末尾放不下，回到开头
+        erased_end = 0;
+    }
+    // 回到开头以后按扇区擦除，擦到第一屏所在的扇区、或者再绕一圈，就覆盖了这一批前面的屏
+    // 放不下时擦除位置不变，后面较小的屏仍接着 write_off 写
+    if (ring.count > 0 && (store.wrapped || wrap) &&
+        ((store.wrapped && wrap) ||
+         align_up(off + size, SECTOR_SIZE) > (store.first_off & ~(SECTOR_SIZE - 1)))) {
+        return ESP_ERR_NO_MEM;
+    }
+    store.erased_end = erased_end;
+    while (store.erased_end < off + size) {
+        err = esp_partition_erase_range(part, store.erased_end, SECTOR_SIZE);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "擦除 0x%x 失败: %s", (unsigned)store.erased_end, esp_err_to_name(err));
+            return err;
+        }
+        store.erased_end += SECTOR_SIZE;
+    }
+    if (ring.count == 0) {
+        store.first_off = off;
+    } else if (wrap) {
+        store.wrapped = true;
+    }
+    store.rec_off = off;
+    store.check = 0;
+    store.write_pos = off + sizeof(record_head_t);
+    store.write_len = 0;
+    ring.write_off = off + size;
+    if (ring.write_off >= part->size) {
+        ring.write_off = 0;
+        store.erased_end = 0;
+        store.wrapped = true;
+    }
+    return ESP_OK;
+}
+
+// 点阵写完后再写记录头，记录头写成之前这条记录是无效的
+static esp_err_t record_end(void) {
+    record_head_t h = { RECORD_MAGIC, store.entry.len, store.check, 0 };
+    esp_err_t err = store_flush();
+
+    if (err == ESP_OK) {
+        err = esp_partition_write(part, store.rec_off, &h, sizeof(h));
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    screen_item_t *item = &ring.items[ring.count++];
+    item->off = store.rec_off;
+    item->len = store.entry.len;
+    item->display_at = store.now + store.entry.display_offset;
+    return ESP_OK;
+}
+
+// 凑齐一个定长部分，返回 true 表示已凑齐
+static bool store_collect(const uint8_t **p, const uint8_t *end, uint32_t need) {
+    uint32_t n = need - store.got;
+
+    if ((uint32_t)(end - *p) < n) {
+        n = end - *p;
+    }
+    memcpy(store.item_buf + store.got, *p, n);
+    store.got += n;
+    *p += n;
+    if (store.got < need) {
+        return false;
+    }
+    store.got = 0;
+    return true;
+}
+
+// 一屏开始，放不下或超过 SCREEN_RING_MAX 的屏跳过
+static esp_err_t entry_begin(void) {
+    if (store.entry.len < sizeof(quote_payload_header_t)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    // 长度来自网络，先和分区大小比较，后面算记录大小时才不会溢出
+    if (store.entry.len > part->size - sizeof(record_head_t)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (store.entry.display_offset < store.last_offset) {
+        return ESP_ERR_INVALID_RESPONSE;        // 显示时间要递增
+    }
+    store.last_offset = store.entry.display_offset;
+    store.state = ST_SKIP;
+    if (ring.count >= SCREEN_RING_MAX) {
+        ESP_LOGW(TAG, "第 %d 屏超过 %d 屏，丢掉", store.entry_index + 1, SCREEN_RING_MAX);
+        return ESP_OK;
+    }
+    esp_err_t err = record_begin();
+    if (err == ESP_ERR_NO_MEM) {
+        ESP_LOGW(TAG, "第 %d 屏放不下，丢掉", store.entry_index + 1);
+        return ESP_OK;
+    }
+    if (err == ESP_OK) {
+        store.state = ST_DATA;
+    }
+    return err;
+}
+
+// 一屏结束
+static esp_err_t entry_end(void) {
+    esp_err_t err = store.state == ST_DATA ? record_end() : ESP_OK;
+
+    store.entry_index++;
+    store.state = store.entry_index < store.head.count ? ST_ENTRY : ST_DONE;
+    return err;
+}
+
+esp_err_t screen_ring_store_feed(const uint8_t *data, size_t len) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    while (store.err == ESP_OK && p < end) {
+        switch (store.state) {
+            case ST_HEADER:
+                if (!store_collect(&p, end, sizeof(store.head))) {
+                    break;
+                }
+                memcpy(&store.head, store.item_buf, sizeof(store.head));
+                if (store.head.magic != QUOTE_BATCH_MAGIC || store.head.version != QUOTE_BATCH_VERSION) {
+                    store.err = ESP_ERR_INVALID_RESPONSE;
+                    break;
+                }
+                store.state = store.head.count ? ST_ENTRY : ST_DONE;
+                break;
+
+            case ST_ENTRY:
+                if (!store_collect(&p, end, sizeof(store.entry))) {
+                    break;
+                }
+                memcpy(&store.entry, store.item_buf, sizeof(store.entry));
+                store.err = entry_begin();
+                break;
+
+            case ST_DATA:
+            case ST_SKIP: {
+                uint32_t n = store.entry.len - store.got;
+                if ((uint32_t)(end - p) < n) {
+                    n = end - p;
+                }
+                if (store.state == ST_DATA) {
+                    store.check = EPD_Hash32(p, n, store.check);
+                    for (uint32_t i = 0; i < n && store.err == ESP_OK; ) {
+                        uint32_t m = WRITE_BUF_SIZE - store.write_len;
+                        if (m > n - i) {
+                            m = n - i;
+                        }
+                        memcpy(store.write_buf + store.write_len, p + i, m);
+                        store.write_len += m;
+                        i += m;
+                        if (store.write_len == WRITE_BUF_SIZE) {
+                            store.err = store_flush();
+                        }
+                    }
+                }
+                store.got += n;
+                p += n;
+                if (store.err == ESP_OK && store.got == store.entry.len) {
+                    store.got = 0;
+                    store.err = entry_end();
+                }
+                break;
+            }
+
+            default:
+                store.err = ESP_ERR_INVALID_SIZE;  // 最后一屏之后还有数据
+                break;
+        }
+    }
+    return store.err;
+}
+
+esp_err_t screen_ring_store_end(void) {
+    if (store.err == ESP_OK && store.state != ST_DONE) {
+        store.err = ESP_ERR_INVALID_SIZE;
+    }
+    ESP_LOGI(TAG, "保存了 %d/%d 屏%s", ring.count, store.head.count, store.err == ESP_OK ? "" : "（响应不完整）");
+    return store.err;
+}
+
+int screen_ring_due(int64_t now) {
+    int due = -1;
+
+    for (int i = 0; i < ring.count && ring.items[i].display_at <= now + SCREEN_RING_EARLY_S; i++) {
+        due = i;
+    }
+    return due > ring.shown ? due : -1;
+}
+
+void screen_ring_mark_shown(int i) {
+    ring.shown = i;
+}
+
+esp_err_t screen_ring_read(int i, screen_ring_read_callback_t callback, void *ctx) {
+    uint8_t buf[READ_BUF_SIZE];
+    record_head_t h;
+    uint32_t check = 0;
+    esp_err_t err;
+
+    if (part == NULL || i < 0 || i >= ring.count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const screen_item_t *item = &ring.items[i];
+    err = esp_partition_read(part, item->off, &h, sizeof(h));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (h.magic != RECORD_MAGIC || h.len != item->len) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    // 先核对整条记录，损坏的不交给解析器，免得错误的点阵写进字模缓存
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t pos = 0; pos < h.len; pos += sizeof(buf)) {
+            uint32_t n = h.len - pos < sizeof(buf) ? h.len - pos : sizeof(buf);
+            err = esp_partition_read(part, item->off + sizeof(h) + pos, buf, n);
+            if (err == ESP_OK && pass == 1) {
+                err = callback(ctx, buf, n);
+            }
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (pass == 0) {
+                check = EPD_Hash32(buf, n, check);
+            }
+        }
+        if (pass == 0 && check != h.check) {
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+    return ESP_OK;
+}
+
+int64_t screen_ring_next_time(int64_t now) {
+    for (int i = ring.shown + 1; i < ring.count; i++) {
+        if (ring.items[i].display_at > now + SCREEN_RING_EARLY_S) {
+            return ring.items[i].display_at;
+        }
+    }
+    return 0;
+}
+
+int64_t screen_ring_low_time(void) {
+    if (ring.count == 0) {
+        return 0;
+    }
+    return ring.items[ring.count > SCREEN_RING_LOW ? ring.count - SCREEN_RING_LOW : 0].display_at;
+}
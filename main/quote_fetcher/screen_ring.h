@@ -0,0 +1,66 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// 批量下载的屏幕（quote_payload.h 的批量响应）保存在 flash 分区里，定时唤醒时不联网逐屏显示
+//
+// 分区是环形日志，每屏一条记录，按16字节对齐依次追加，剩下的空间放不下时回到分区开头：
+//   uint32 magic、uint32 长度、uint32 校验、uint32 保留，后面是这一屏的二进制语录
+// 写到哪个扇区才擦除哪个扇区，擦写均匀分布在整个分区上。
+// 每屏的位置和显示时间记在 RTC 内存里，深度睡眠后保留；断电后时钟也从头开始，整个缓存作废，第一次唤醒总会联网
+
+#define SCREEN_RING_PARTITION   "screens"       // 分区名，见 partitions.csv
+#define SCREEN_RING_MAX         16              // 一批最多保存的屏数，多的丢掉
+#define SCREEN_RING_LOW         1               // 未显示的屏只剩这么多时联网，下载新的一批
+#define SCREEN_RING_EARLY_S     30              // 定时唤醒比显示时间早这么多以内也算到了
+
+// 查找屏幕缓存分区，RTC 内存里的记录无效时清空
+esp_err_t screen_ring_open(void);
+
+// 分区存在，可以请求批量响应
+bool screen_ring_available(void);
+
+// 开始保存一个批量响应，之前保存的屏幕全部作废
+// 参数：   now,收到响应的时间，time() 的秒数，每屏的显示时间从它算起
+void screen_ring_store_begin(int64_t now);
+
+// 保存收到的一段数据，边收边写 flash，返回第一个错误
+esp_err_t screen_ring_store_feed(const uint8_t *data, size_t len);
+
+// 响应收完，检查是否完整；出错时已经写完的屏幕仍然保留
+// 返回：   ESP_OK,全部保存；ESP_ERR_INVALID_SIZE,长度不对；ESP_ERR_INVALID_RESPONSE,格式错误
+esp_err_t screen_ring_store_end(void);
+
+// 作废保存的屏幕，服务器返回单条语录时调用
+void screen_ring_clear(void);
+
+// 现在该显示的屏
+// 返回：   已到时间的最后一屏的下标，已经显示过或没有到时间的屏时返回 -1
+int screen_ring_due(int64_t now);
+
+// 标记已经显示
+void screen_ring_mark_shown(int i);
+
+// 读取一屏的回调，data 是二进制语录的一段
+typedef esp_err_t (*screen_ring_read_callback_t)(void *ctx, const uint8_t *data, size_t len);
+
+// 读取一屏，先核对校验，再分段交给 callback
+// 返回：   ESP_ERR_INVALID_CRC,记录已损坏或被覆盖；其他为 callback 返回的错误
+esp_err_t screen_ring_read(int i, screen_ring_read_callback_t callback, void *ctx);
+
+// 下一屏的显示时间，time() 的秒数，没有时返回 0
+int64_t screen_ring_next_time(int64_t now);
+
+// 未显示的屏只剩 SCREEN_RING_LOW 个的时间，到时联网；没有保存的屏时返回 0
+int64_t screen_ring_low_time(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,113 @@
+#include "wake_policy.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include <time.h>
+
+#define TAG "WAKE"
+
+#define WAKE_STATE_MAGIC    0x454B4157      // "WAKE"
+#define WAKE_MIN_SLEEP_S    1               // 到期时间已过时也至少睡这么久
+
+// 联网的时间表，放在RTC内存，深度睡眠后保留，断电后第一次唤醒总是联网
+typedef struct {
+    uint32_t magic;                 // 等于 WAKE_STATE_MAGIC 才有效
+    int64_t next_fetch;             // 下次联网的时间，time() 的秒数，RTC时钟在深度睡眠中继续走
+} wake_state_t;
+
+static RTC_DATA_ATTR wake_state_t wake_state;
+
+static wake_local_render_callback_t local_render_callback = NULL;
+static wake_local_deadline_callback_t local_deadline_callback = NULL;
+
+void register_wake_local_render_callback(wake_local_render_callback_t callback) {
+    local_render_callback = callback;
+}
+
+void register_wake_local_deadline_callback(wake_local_deadline_callback_t callback) {
+    local_deadline_callback = callback;
+}
+
+request_reason_t wake_policy_reason(void) {
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_EXT0:
+        case ESP_SLEEP_WAKEUP_EXT1:
+            return REQUEST_REASON_BUTTON_TRIGGER;   // 按键触发
+        case ESP_SLEEP_WAKEUP_TIMER:
+            return REQUEST_REASON_TIMER;            // 定时触发
+        default:
+            return REQUEST_REASON_UNKNOWN;          // 未知原因: 上电复位...
+    }
+}
+
+// 到了联网的时间
+static bool fetch_due(int64_t now) {
+    if (wake_state.magic != WAKE_STATE_MAGIC) {
+        return true;
+    }
+    // 比最长的推迟还远说明时钟被调过，按到期处理
+    if (wake_state.next_fetch - now > WAKE_FETCH_MAX_S) {
+        return true;
+    }
+    return now >= wake_state.next_fetch - WAKE_FETCH_SLACK_S;
+}
+
+wake_action_t wake_policy_decide(void) {
+    request_reason_t reason = wake_policy_reason();
+    int64_t now = time(NULL);
+
+    if (reason != REQUEST_REASON_TIMER) {
+        ESP_LOGI(TAG, "非定时唤醒（%d），联网", reason);
+        return WAKE_ACTION_NETWORK;
+    }
+    if (fetch_due(now)) {
+        ESP_LOGI(TAG, "到了联网时间，联网");
+        return WAKE_ACTION_NETWORK;
+    }
+    if (local_render_callback == NULL) {
+        ESP_LOGI(TAG, "没有本地刷新，联网");
+        return WAKE_ACTION_NETWORK;
+    }
+    ESP_LOGI(TAG, "距离下次联网还有 %d 秒，只在本地刷新", (int)(wake_state.next_fetch - now));
+    return WAKE_ACTION_LOCAL;
+}
+
+bool wake_policy_run_local(void) {
+    if (local_render_callback == NULL || !local_render_callback()) {
+        ESP_LOGW(TAG, "本地没有可显示的内容，改为联网");
+        return false;
+    }
+    return true;
+}
+
+void wake_policy_fetch_done(int64_t next_fetch) {
+    int64_t now = time(NULL);
+
+    if (next_fetch <= now) {
+        next_fetch = now + WAKE_FETCH_INTERVAL_S;
+    } else if (next_fetch > now + WAKE_FETCH_MAX_S) {
+        next_fetch = now + WAKE_FETCH_MAX_S;
+    }
+    wake_state.next_fetch = next_fetch;
+    wake_state.magic = WAKE_STATE_MAGIC;
+}
+
+uint64_t wake_policy_sleep_us(void) {
+    int64_t now = time(NULL);
+    int64_t wake_at = wake_state.magic == WAKE_STATE_MAGIC ? wake_state.next_fetch : now + WAKE_FETCH_INTERVAL_S;
+
+    if (local_deadline_callback != NULL) {
+        int64_t deadline = local_deadline_callback();
+        if (deadline > 0 && deadline < wake_at) {
+            wake_at = deadline;
+        }
+    }
+    int64_t sleep_s = wake_at - now;
+    if (sleep_s < WAKE_MIN_SLEEP_S) {
+        sleep_s = WAKE_MIN_SLEEP_S;
+    } else if (sleep_s > WAKE_FETCH_MAX_S) {
+        sleep_s = WAKE_FETCH_MAX_S;
+    }
+    ESP_LOGI(TAG, "%d 秒后唤醒", (int)sleep_s);
+    return (uint64_t)sleep_s * 1000000ULL;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "quote_fetcher.h"
+
+// 唤醒策略：app_main 一开始根据唤醒原因和 RTC 内存里保留的状态决定这次是否需要联网，
+// 不需要时只在本地刷新屏幕，不初始化 NVS 和 WiFi，直接回到深度睡眠
+//   上电、按键唤醒、没有注册本地刷新回调时总是联网，与原来相同
+//   定时唤醒且没到下次联网的时间（一般是上次联网后 WAKE_FETCH_INTERVAL_S，批量下载后由屏幕缓存决定）时交给本地刷新回调
+
+#define WAKE_FETCH_INTERVAL_S   3600        // 联网获取内容的间隔，秒
+#define WAKE_FETCH_SLACK_S      300         // RTC 慢时钟有误差，定时唤醒可能提前几分钟，差这么多以内也算到期
+#define WAKE_FETCH_MAX_S        (7 * 24 * 3600) // 批量下载后下次联网最多推迟这么久
+
+typedef enum {
+    WAKE_ACTION_NETWORK,    // 初始化 NVS 和 WiFi，联网获取内容
+    WAKE_ACTION_LOCAL,      // 调用本地刷新回调，不联网
+} wake_action_t;
+
+// 本地刷新回调，只在定时唤醒时调用，返回 false 表示本地没有可显示的内容，改为联网
+typedef bool (*wake_local_render_callback_t)(void);
+
+// 下一次需要本地刷新的时间回调，返回 time() 的秒数，没有时返回 0
+typedef int64_t (*wake_local_deadline_callback_t)(void);
+
+// 注册本地刷新回调
+void register_wake_local_render_callback(wake_local_render_callback_t callback);
+
+// 注册本地刷新时间回调，深度睡眠的时长取它和下次联网时间中较早的一个
+void register_wake_local_deadline_callback(wake_local_deadline_callback_t callback);
+
+// 把唤醒原因映射为请求原因
+request_reason_t wake_policy_reason(void);
+
+// 决定这次唤醒是否需要联网
+wake_action_t wake_policy_decide(void);
+
+// 调用本地刷新回调
+// 返回：   true,已在本地处理；false,需要联网
+bool wake_policy_run_local(void);
+
+// 联网结束，记下次联网的时间
+// 参数：   next_fetch,下次联网的时间，time() 的秒数；为 0 或已经过去时推迟 WAKE_FETCH_INTERVAL_S，与原来失败后也等一个周期相同
+void wake_policy_fetch_done(int64_t next_fetch);
+
+// 计算到下次唤醒的时长，微秒
+uint64_t wake_policy_sleep_us(void);
+
+#ifdef __cplusplus
+}
+#endif
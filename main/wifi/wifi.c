@@ -10,28 +10,124 @@
 #include "wifi_html.h"
 #include "driver/gpio.h"
 #include "cJSON.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <time.h>
 
 #define WIFI_CONNECTED_BIT BIT0
+#define WIFI_FAIL_BIT      BIT1         // 连接失败（断开事件），快速连接时不用等到超时
 static EventGroupHandle_t wifi_event_group;
 static const char *TAG = "wifi";
 
-// WiFi扫描结果存储
-static wifi_ap_record_t *ap_records;
-static uint16_t ap_count = 0;
-
 // 保存WiFi信息
 static char saved_ssid[32] = {0};
 static char saved_pass[64] = {0};
 
+#define FAST_CONNECT_MAGIC       0x54534146     // "FAST"
+#define FAST_CONNECT_TIMEOUT_MS  1500           // 按缓存的AP连接的最长时间，超时后重新扫描
+#define FULL_CONNECT_TIMEOUT_MS  5000           // 扫描连接的最长时间
+#define IP_REUSE_MAX_S           (12 * 3600)    // 缓存的IP最多用这么久，之后重新走DHCP，不超过常见租期的一半
+
+// 上次成功连接的AP和拿到的IP，放在RTC内存，深度睡眠后保留，断电后重新扫描
+typedef struct {
+    uint32_t magic;                 // 等于 FAST_CONNECT_MAGIC 才有效
+    uint32_t config_hash;           // SSID和密码的哈希，重新配网后不再使用
+    uint8_t bssid[6];
+    uint8_t channel;
+    esp_netif_ip_info_t ip_info;
+    esp_ip4_addr_t dns;
+    int64_t ip_time;                // 通过DHCP拿到IP的时间，秒，RTC时钟在深度睡眠中继续走
+} fast_connect_t;
+
+static RTC_DATA_ATTR fast_connect_t fast_connect;
+
+static esp_netif_t *sta_netif;
+static bool fast_attempt;           // 本次按缓存的BSSID和信道连接
+static bool reuse_ip;               // 本次直接使用缓存或配置的IP，不走DHCP
+static int64_t connect_start_us;
+
+// FNV-1a
+static uint32_t wifi_config_hash(const char *ssid, const char *pass) {
+    uint32_t h = 0x811C9DC5;
+    for (const char *p = ssid; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 0x01000193;
+    }
+    h = (h ^ 0xFF) * 0x01000193;        // 分隔，"ab"+"c" 与 "a"+"bc" 不同
+    for (const char *p = pass; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 0x01000193;
+    }
+    return h;
+}
+
+// 连上AP后设置固定IP，不走DHCP，设置后会产生 IP_EVENT_STA_GOT_IP
+static void apply_static_ip(void) {
+    esp_netif_ip_info_t ip_info;
+    esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4 };
+
+#ifdef WIFI_STATIC_IP
+    ip_info.ip.addr = esp_ip4addr_aton(WIFI_STATIC_IP);
+    ip_info.netmask.addr = esp_ip4addr_aton(WIFI_STATIC_NETMASK);
+    ip_info.gw.addr = esp_ip4addr_aton(WIFI_STATIC_GW);
+    dns.ip.u_addr.ip4.addr = esp_ip4addr_aton(WIFI_STATIC_DNS);
+#else
+    ip_info = fast_connect.ip_info;
+    dns.ip.u_addr.ip4 = fast_connect.dns;
+#endif
+    esp_netif_dhcpc_stop(sta_netif);
+    if (esp_netif_set_ip_info(sta_netif, &ip_info) != ESP_OK) {
+        ESP_LOGW(TAG, "设置固定IP失败");
+        return;
+    }
+    esp_netif_set_dns_info(sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+}
+
+// 连接成功，记下AP和IP，下次唤醒时直接连
+static void save_fast_connect(const ip_event_got_ip_t *event) {
+    wifi_ap_record_t ap;
+
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    memcpy(fast_connect.bssid, ap.bssid, sizeof(fast_connect.bssid));
+    fast_connect.channel = ap.primary;
+    fast_connect.config_hash = wifi_config_hash(saved_ssid, saved_pass);
+    if (!reuse_ip) {
+        // 通过DHCP拿到的新租约才更新时间，沿用缓存IP时保持原来的时间
+        esp_netif_dns_info_t dns;
+        fast_connect.ip_info = event->ip_info;
+        fast_connect.dns.addr = 0;
+        if (esp_netif_get_dns_info(sta_netif, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK) {
+            fast_connect.dns = dns.ip.u_addr.ip4;
+        }
+        fast_connect.ip_time = time(NULL);
+    }
+    fast_connect.magic = FAST_CONNECT_MAGIC;
+}
+
+// WiFi扫描结果存储
+static wifi_ap_record_t *ap_records;
+static uint16_t ap_count = 0;
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        connect_start_us = esp_timer_get_time();
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        if (reuse_ip) {
+            apply_static_ip();
+        }
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "WiFi disconnected");
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+        ESP_LOGI(TAG, "WiFi disconnected, reason %d", event->reason);
+        xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG, "WiFi 连接耗时 %d ms（%s%s）", (int)((esp_timer_get_time() - connect_start_us) / 1000),
+                 fast_attempt ? "缓存的AP" : "扫描", reuse_ip ? "，固定IP" : "，DHCP");
+        save_fast_connect(event);
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
@@ -60,13 +156,41 @@ static bool load_wifi_config(char *ssid, char *pass) {
     return true;
 }
 
+// 填写STA配置
+// 参数：   fast,true 时直连缓存的AP，只在它的信道上找，不扫描全部信道
+static void sta_config(wifi_config_t *wifi_config, const char *ssid, const char *pass, bool fast) {
+    memset(wifi_config, 0, sizeof(*wifi_config));
+    strcpy((char *)wifi_config->sta.ssid, ssid);
+    strcpy((char *)wifi_config->sta.password, pass);
+    wifi_config->sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    if (fast) {
+        wifi_config->sta.bssid_set = true;
+        memcpy(wifi_config->sta.bssid, fast_connect.bssid, sizeof(fast_connect.bssid));
+        wifi_config->sta.channel = fast_connect.channel;
+        wifi_config->sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config->sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config->sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+}
+
 // 启动 STA 模式
+// 深度睡眠唤醒时如果 RTC 内存里有上次连接的 AP，直接按 BSSID 和信道连接；租约还新时沿用上次的 IP，省去 DHCP
 void wifi_init_sta(const char *ssid, const char *pass) {
     wifi_event_group = xEventGroupCreate();
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    sta_netif = esp_netif_create_default_wifi_sta();
+
+    fast_attempt = fast_connect.magic == FAST_CONNECT_MAGIC &&
+                   fast_connect.config_hash == wifi_config_hash(ssid, pass);
+#ifdef WIFI_STATIC_IP
+    reuse_ip = true;
+#else
+    reuse_ip = fast_attempt && fast_connect.ip_info.ip.addr != 0 &&
+               time(NULL) - fast_connect.ip_time < IP_REUSE_MAX_S;
+#endif
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -84,16 +208,46 @@ void wifi_init_sta(const char *ssid, const char *pass) {
                                                         NULL,
                                                         &instance_got_ip));
 
-    wifi_config_t wifi_config = {0};
-    strcpy((char *)wifi_config.sta.ssid, ssid);
-    strcpy((char *)wifi_config.sta.password, pass);
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    wifi_config_t wifi_config;
+    sta_config(&wifi_config, ssid, pass, fast_attempt);
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
-    ESP_LOGI(TAG, "wifi_init_sta finished.");
+    ESP_LOGI(TAG, "wifi_init_sta finished%s.", fast_attempt ? " (fast connect)" : "");
+}
+
+// 等待连接成功，快速连接失败时作废缓存，改为扫描连接
+static bool wifi_wait_connected(void) {
+    EventBits_t bits;
+
+    if (fast_attempt) {
+        bits = xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE,
+                                   pdMS_TO_TICKS(FAST_CONNECT_TIMEOUT_MS));
+        if (bits & WIFI_CONNECTED_BIT) {
+            return true;
+        }
+        ESP_LOGW(TAG, "按缓存的AP连接失败，重新扫描");
+        fast_connect.magic = 0;
+        fast_attempt = false;
+#ifndef WIFI_STATIC_IP
+        if (reuse_ip) {
+            reuse_ip = false;
+            esp_netif_dhcpc_start(sta_netif);   // 可能已经停掉了DHCP
+        }
+#endif
+        esp_wifi_disconnect();
+
+        wifi_config_t wifi_config;
+        sta_config(&wifi_config, saved_ssid, saved_pass, false);
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        xEventGroupClearBits(wifi_event_group, WIFI_FAIL_BIT);
+        esp_wifi_connect();
+    }
+    bits = xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdFALSE,
+                               pdMS_TO_TICKS(FULL_CONNECT_TIMEOUT_MS));
+    return (bits & WIFI_CONNECTED_BIT) != 0;
 }
 
 // 添加URL解码辅助函数
@@ -351,8 +505,7 @@ wifi_init_result_t wifi_init(void)
         ESP_LOGI(TAG, "加载到的WiFi配置 - SSID: '%s'", saved_ssid);
         ESP_LOGI(TAG, "加载到的WiFi配置 - 密码: '%s'", saved_pass);
         wifi_init_sta(saved_ssid, saved_pass);
-        EventBits_t bits = xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(5000));
-        if (bits & WIFI_CONNECTED_BIT) {
+        if (wifi_wait_connected()) {
             ESP_LOGI(TAG, "WiFi 已连接");
             return WIFI_INIT_CONNECTED;  // 返回连接成功状态
         } else {
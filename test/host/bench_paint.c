@@ -0,0 +1,217 @@
+// 画布绘制和颜色转换的性能对比，整帧 180x384（中景园3.52寸屏的画布）
+//   填充：改动前逐像素判断方向的 Paint_SetPixel 与按行填充的 Paint_FillRect
+//   字模：改动前逐位调用 Paint_SetPixel 的 DrawBitmapToBuffer 与按字节写入的 Paint_DrawMono，一屏 24x24 的字
+//   颜色转换：每字节4次 Color_Conversion 与256项整字节转换表（与 epaper.c 的 s_color_lut 生成方式相同）
+// 两条路径的结果先逐字节比较（填充和字模四个方向都比较），一致后才计时
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "epaper.h"
+#include "epaper_gui.h"
+
+#define FRAME_BYTES  (EPD_W * EPD_H / 4)
+#define FRAME_PIXELS ((double)EPD_W * EPD_H)
+#define GLYPH_MAX    32
+
+static uint8_t canvas_a[FRAME_BYTES];
+static uint8_t canvas_b[FRAME_BYTES];
+static uint8_t out_a[FRAME_BYTES];
+static uint8_t out_b[FRAME_BYTES];
+static uint8_t color_lut[256];
+static uint8_t glyph[GLYPH_MAX * GLYPH_MAX / 8];
+static int glyph_size = 24;
+
+// 以下两个函数原样取自改动前的 epaper_gui.c，作为对照；与现在的函数同名，只加了 Base_ 前缀
+
+static void Base_Paint_SetPixel(uint16_t Xpoint,uint16_t Ypoint,uint16_t Color)
+{
+  uint16_t X, Y;
+  uint32_t Addr;
+  uint8_t Rdata;
+
+  switch(Paint.rotate)      // 计算旋转后的坐标
+  {
+      case 0:
+          X=Paint.widthMemory-Ypoint-1;
+          Y=Xpoint;
+          break;
+      case 90:
+          X=Paint.widthMemory-Xpoint-1;
+          Y=Paint.heightMemory-Ypoint-1;
+          break;
+      case 180:
+          X=Ypoint;
+          Y=Paint.heightMemory-Xpoint-1;
+          break;
+      case 270:
+          X=Xpoint;
+          Y=Ypoint;
+          break;
+        default:
+            return;
+    }
+  Addr=X/4+Y*Paint.widthByte;
+  Color = Color % 4;
+  Rdata = Paint.Image[Addr];
+  Rdata = Rdata & (~(0xC0 >> ((X % 4)*2)));
+  Paint.Image[Addr]=Rdata|((Color<<6)>>((X%4)*2));
+}
+
+// 将bitmap字模数据 绘制到画布缓冲区
+static void Base_DrawBitmapToBuffer(uint16_t x, uint16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, uint16_t color)
+{
+    uint16_t x0 = x;
+    uint16_t SizeNum = (width / 8 + ((width % 8) ? 1 : 0)) * height;    // 计算该字符需要的字节数
+
+    for(uint8_t i=0;i<SizeNum;i++){             // 遍历字节数组
+        for(uint8_t j=0;j<8;j++){               // 遍历每个字节的位
+            if(bitmap[i]&(0x80>>j)){
+                Base_Paint_SetPixel(x, y, color);    //画点
+            }
+            x++;
+            if((x-x0)==width){                  //换行
+                x=x0;
+                y++;
+            }
+        }
+    }
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 重复运行 fn 至少 0.3 秒，每次处理 pixels 个像素，返回每秒处理的像素数
+static double measure(void (*fn)(int), int arg, double pixels) {
+    int rounds = 0;
+    double start = now_s();
+    double elapsed;
+
+    do {
+        fn(arg);
+        rounds++;
+        elapsed = now_s() - start;
+    } while (elapsed < 0.3);
+    return rounds * pixels / elapsed;
+}
+
+// 逻辑坐标的范围（旋转后），改动前的 Paint_SetPixel 没有越界检查，只能画在范围内
+static void fill_per_pixel(int color) {
+    for (int y = 0; y < Paint.yLimit; y++) {
+        for (int x = 0; x < Paint.xLimit; x++) {
+            Base_Paint_SetPixel(x, y, color);
+        }
+    }
+}
+
+static void fill_span(int color) {
+    Paint_FillRect(0, 0, Paint.xLimit - 1, Paint.yLimit - 1, color);
+}
+
+// 画布排满字，每行之间空2像素
+static int glyphs_per_page(void) {
+    return (Paint.xLimit / glyph_size) * (Paint.yLimit / (glyph_size + 2));
+}
+
+static void glyphs_per_bit(int color) {
+    for (int y = 0; y + glyph_size <= Paint.yLimit; y += glyph_size + 2) {
+        for (int x = 0; x + glyph_size <= Paint.xLimit; x += glyph_size) {
+            Base_DrawBitmapToBuffer(x, y, glyph, glyph_size, glyph_size, color);
+        }
+    }
+}
+
+static void glyphs_mono(int color) {
+    for (int y = 0; y + glyph_size <= Paint.yLimit; y += glyph_size + 2) {
+        for (int x = 0; x + glyph_size <= Paint.xLimit; x += glyph_size) {
+            DrawBitmapToBuffer(x, y, glyph, glyph_size, glyph_size, color);
+        }
+    }
+}
+
+// 改动前 EPD_Display 的做法：每个字节拆成4个像素分别转换
+static void convert_per_pixel(int unused) {
+    (void)unused;
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        uint8_t b = canvas_a[i];
+        out_a[i] = Color_Conversion(b >> 6 & 3) << 6 | Color_Conversion(b >> 4 & 3) << 4 |
+                   Color_Conversion(b >> 2 & 3) << 2 | Color_Conversion(b & 3);
+    }
+}
+
+static void convert_lut(int unused) {
+    (void)unused;
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        out_b[i] = color_lut[canvas_a[i]];
+    }
+}
+
+static void report(const char *name, double old_px, double new_px) {
+    printf("%s: 改动前 %9.1f Mpx/s   新路径 %9.1f Mpx/s   %6.1fx\n", name, old_px / 1e6, new_px / 1e6, new_px / old_px);
+}
+
+// 两块画布分别用两条路径画，结果必须相同
+static int same_result(void (*old_fn)(int), void (*new_fn)(int), int rotate, int color) {
+    Paint_NewImage(canvas_a, EPD_W, EPD_H, rotate, WHITE);
+    Paint_Clear(WHITE);
+    old_fn(color);
+    Paint_NewImage(canvas_b, EPD_W, EPD_H, rotate, WHITE);
+    Paint_Clear(WHITE);
+    new_fn(color);
+    return memcmp(canvas_a, canvas_b, FRAME_BYTES) == 0;
+}
+
+int main(void) {
+    // 填充：四个方向、每个颜色
+    for (int rotate = 0; rotate < 360; rotate += 90) {
+        for (int color = BLACK; color <= RED; color++) {
+            if (!same_result(fill_per_pixel, fill_span, rotate, color)) {
+                printf("FAIL: %d 度填充颜色 %d 时两条路径的画布不同\n", rotate, color);
+                return 1;
+            }
+        }
+    }
+    Paint_NewImage(canvas_a, EPD_W, EPD_H, 0, WHITE);
+    report("整帧填充", measure(fill_per_pixel, RED, FRAME_PIXELS), measure(fill_span, RED, FRAME_PIXELS));
+
+    // 字模：随机点阵，字号16、24、32，四个方向
+    srand(1);
+    for (size_t i = 0; i < sizeof(glyph); i++) {
+        glyph[i] = rand();
+    }
+    for (glyph_size = 16; glyph_size <= GLYPH_MAX; glyph_size += 8) {
+        for (int rotate = 0; rotate < 360; rotate += 90) {
+            if (!same_result(glyphs_per_bit, glyphs_mono, rotate, BLACK)) {
+                printf("FAIL: %d 度画 %dx%d 字模时两条路径的画布不同\n", rotate, glyph_size, glyph_size);
+                return 1;
+            }
+        }
+    }
+    glyph_size = 24;
+    Paint_NewImage(canvas_a, EPD_W, EPD_H, 0, WHITE);
+    double glyph_pixels = (double)glyphs_per_page() * glyph_size * glyph_size;
+    report("字模24x24", measure(glyphs_per_bit, BLACK, glyph_pixels), measure(glyphs_mono, BLACK, glyph_pixels));
+
+    // 颜色转换：随机画布，转换结果必须相同
+    for (int b = 0; b < 256; b++) {
+        color_lut[b] = Color_Conversion(b >> 6 & 3) << 6 | Color_Conversion(b >> 4 & 3) << 4 |
+                       Color_Conversion(b >> 2 & 3) << 2 | Color_Conversion(b & 3);
+    }
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        canvas_a[i] = rand();
+    }
+    convert_per_pixel(0);
+    convert_lut(0);
+    if (memcmp(out_a, out_b, FRAME_BYTES) != 0) {
+        printf("FAIL: 两条路径的颜色转换结果不同\n");
+        return 1;
+    }
+    report("颜色转换", measure(convert_per_pixel, 0, FRAME_PIXELS), measure(convert_lut, 0, FRAME_PIXELS));
+    if (EPD_COLOR_IDENTITY) {
+        printf("当前颜色定义与控制器一致（EPD_COLOR_IDENTITY），EPD_Display 不转换，画布直接发送\n");
+    }
+    return 0;
+}
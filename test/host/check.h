@@ -0,0 +1,25 @@
+// 主机测试共用的检查宏：CHECK 失败时打印位置和说明并计数，超过20项直接退出
+//   main 最后 return check_report();，全部通过打印 OK 返回0，否则打印失败项数返回1
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        if (++failures > 20) exit(1); \
+    } \
+} while (0)
+
+static inline int check_report(void) {
+    if (failures) {
+        printf("%d 项失败\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+生成 test_quote_stream 用的响应数据：在本进程里启动 tools/quote_server.py 的请求处理（--chunked），
+按设备的请求头取 JSON 和二进制两种响应，原样记下分块格式的响应体，再写出期望的解析结果。
+
+字形用按码点生成的随机 BDF 点阵，不需要 Pillow 和系统字体，每次生成的内容相同。
+
+    python3 gen_quote_fixture.py build/quote_fixture.h
+"""
+
+import argparse
+import os
+import random
+import socket
+import sys
+import tempfile
+import threading
+from http.server import HTTPServer
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import quote_server    # noqa: E402
+
+CHUNK_MAX = 61          # 服务器随机块大小的上限，块边界会落在文件头、表项、字符串和点阵中间
+
+# (名称, 屏幕型号, 字号, 语录)；型号为 None 时用超长的型号名
+CASES = [
+    ('zjy_24', 'zjy_3.52_4colors', 24, 'Stay hungry,\t"求知" \\ 😀 若饥 é'),
+    ('qy_16', 'qy_2.9_2colors', 16, 'Hello, 世界! ~'),
+    ('long_quote', 'zjy_3.52_4colors', 16, '长' * 200),
+    ('many_glyphs', 'zjy_3.52_4colors', 16, ''.join(chr(0x4E00 + i) for i in range(70))),
+    ('big_glyph', 'zjy_3.52_4colors', 96, 'AB'),
+    ('long_model', None, 16, 'model'),
+]
+
+LONG_MODEL = 'zjy_3.52_4colors_' + 'x' * 24
+
+
+def write_bdf(path, size, codepoints):
+    """每个码点一个满格的随机点阵"""
+    digits = (size + 7) // 8 * 2
+    with open(path, 'w', encoding='latin-1') as f:
+        f.write('STARTFONT 2.1\nFONT fixture\nSIZE %d 75 75\nFONTBOUNDINGBOX %d %d 0 0\n' % (size, size, size))
+        f.write('STARTPROPERTIES 2\nFONT_ASCENT %d\nFONT_DESCENT 0\nENDPROPERTIES\n' % size)
+        f.write('CHARS %d\n' % len(codepoints))
+        for cp in sorted(codepoints):
+            rnd = random.Random(cp * 131 + size)
+            f.write('STARTCHAR U+%04X\nENCODING %d\nBBX %d %d 0 0\nBITMAP\n' % (cp, cp, size, size))
+            for _ in range(size):
+                bits = rnd.getrandbits(size) << (digits * 4 - size)
+                f.write('%0*X\n' % (digits, bits))
+            f.write('ENDCHAR\n')
+        f.write('ENDFONT\n')
+
+
+def fetch(port, accept):
+    """原样取回响应，去掉响应头，返回分块格式的响应体"""
+    with socket.create_connection(('127.0.0.1', port)) as conn:
+        conn.sendall(('GET /quote HTTP/1.1\r\nHost: localhost\r\nAccept: %s\r\nConnection: close\r\n\r\n'
+                      % accept).encode())
+        data = b''
+        while True:
+            part = conn.recv(65536)
+            if not part:
+                break
+            data += part
+    head, body = data.split(b'\r\n\r\n', 1)
+    assert b'Transfer-Encoding: chunked' in head, head
+    return body
+
+
+def serve(builder, quote):
+    """按 quote_server 的请求处理取 JSON 和二进制两种响应"""
+    args = argparse.Namespace(chunked=CHUNK_MAX, batch_interval=3600)
+    handler = quote_server.make_handler(builder, [quote], args)
+    handler.log_message = lambda *a: None      # 不打印访问日志
+    server = HTTPServer(('127.0.0.1', 0), handler)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    try:
+        random.seed(len(quote))          # 块大小随机，固定种子使生成的内容不变
+        json_body = fetch(server.server_port, 'application/json')
+        random.seed(len(quote) + 1)
+        bin_body = fetch(server.server_port, quote_server.PAYLOAD_MIME + ', application/json')
+    finally:
+        server.shutdown()
+        server.server_close()
+    return json_body, bin_body
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ' '.join('0x%02X,' % b for b in data[i:i + 16]))
+    return '\n'.join(lines) if lines else '    0'
+
+
+def c_string(text):
+    return '"' + ''.join('\\%03o' % b for b in text.encode()) + '"'
+
+
+def main():
+    ap = argparse.ArgumentParser(description='generate chunked quote server responses for test_quote_stream')
+    ap.add_argument('out', help='generated C header')
+    args = ap.parse_args()
+
+    out = ['// 由 gen_quote_fixture.py 生成，不要手改',
+           '// 分块格式的响应体取自 tools/quote_server.py --chunked %d' % CHUNK_MAX,
+           '#pragma once',
+           '#include <stdbool.h>',
+           '#include <stddef.h>',
+           '#include <stdint.h>',
+           '',
+           'typedef struct {',
+           '    const char *character;',
+           '    uint8_t width;',
+           '    uint8_t height;',
+           '    const uint8_t *data;',
+           '    uint16_t len;',
+           '} fixture_glyph_t;',
+           '',
+           'typedef struct {',
+           '    uint16_t index;',
+           '    int16_t x;',
+           '    int16_t y;',
+           '} fixture_place_t;',
+           '',
+           'typedef struct {',
+           '    const char *name;',
+           '    bool binary;',
+           '    const uint8_t *chunked;         // 服务器发出的响应体，含分块格式',
+           '    size_t chunked_len;',
+           '    const char *model;              // 以下是服务器排版的内容，未按解析器的上限截断',
+           '    const char *quote;',
+           '    int font_size;',
+           '    const fixture_glyph_t *glyphs;',
+           '    int glyph_count;',
+           '    const fixture_place_t *places;',
+           '    int place_count;',
+           '} fixture_t;',
+           '']
+    table = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for name, model, size, quote in CASES:
+            font = os.path.join(tmp, '%s.bdf' % name)
+            write_bdf(font, size, {ord(ch) for ch in quote})
+            builder = quote_server.QuoteBuilder(argparse.Namespace(
+                size=size, model=model or 'zjy_3.52_4colors', font=font, threshold=128, font_bin=None))
+            if model is None:
+                builder.model = LONG_MODEL
+            chars, positions = builder.layout(quote)
+            for i, ch in enumerate(chars):
+                out.append('static const uint8_t %s_glyph%d[] = {\n%s\n};' % (name, i, c_bytes(builder.bitmap(ch))))
+            out.append('static const fixture_glyph_t %s_glyphs[] = {' % name)
+            for i, ch in enumerate(chars):
+                out.append('    { %s, %d, %d, %s_glyph%d, sizeof(%s_glyph%d) },'
+                           % (c_string(ch), size, size, name, i, name, i))
+            out.append('};')
+            out.append('static const fixture_place_t %s_places[] = {' % name)
+            out.extend('    { %d, %d, %d },' % p for p in positions)
+            out.append('};')
+
+            for kind, body in zip(('json', 'bin'), serve(builder, quote)):
+                out.append('static const uint8_t %s_%s[] = {\n%s\n};' % (name, kind, c_bytes(body)))
+                table.append('    { "%s %s", %s, %s_%s, sizeof(%s_%s), %s, %s, %d, %s_glyphs, %d, %s_places, %d },'
+                             % (name, kind, 'true' if kind == 'bin' else 'false', name, kind, name, kind,
+                                c_string(builder.model), c_string(quote), size,
+                                name, len(chars), name, len(positions)))
+            out.append('')
+    out.append('static const fixture_t fixtures[] = {')
+    out.extend(table)
+    out.append('};')
+    with open(args.out, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
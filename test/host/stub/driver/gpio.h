@@ -0,0 +1,5 @@
+// driver/gpio.h 的最小替身，Mock 总线不操作引脚，只需要类型
+#pragma once
+#include "esp_err.h"
+
+typedef int gpio_num_t;
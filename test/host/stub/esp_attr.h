@@ -0,0 +1,9 @@
+// esp_attr.h 的最小替身，主机上内存位置属性都不起作用
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define DMA_ATTR WORD_ALIGNED_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,5 @@
+// esp_timer.h 的最小替身，esp_timer_get_time 由测试提供（假时钟）
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,12 @@
+// FreeRTOS.h 的最小替身
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define portMAX_DELAY       0xffffffffu
+#define portTICK_PERIOD_MS  10
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms) / portTICK_PERIOD_MS)
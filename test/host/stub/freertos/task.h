@@ -0,0 +1,7 @@
+// task.h 的最小替身，主机测试里延时不需要真的等待
+#pragma once
+#include "FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks) {
+    (void)ticks;
+}
@@ -0,0 +1,6 @@
+// 主机测试用的 sdkconfig：Mock 总线，其他选项取 Kconfig 的默认值
+#pragma once
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_EPD_BUS_MOCK 1
+#define CONFIG_EPD_BUSY_TIMEOUT_MS 60000
+#define CONFIG_EPD_PANEL_AUTO 1
@@ -0,0 +1,137 @@
+// QY_SSD1680_Split_4GRAY 的主机测试：与改动前逐位判断的 In2bytes_Out1byte_RAM1/RAM2 逐位相同
+//   全部 65536 种输入字节对，BW、RED 两个平面都比较，也比较只输出一个平面的情况
+//   QY_SSD1680_Display_4GRAY 经 Mock 总线写入的数据与改动前逐字节写入的相同
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qy_ssd1680_epaper.h"
+#include "check.h"
+
+// 以下两个函数原样取自改动前的 qy_ssd1680_epaper.c，作为对照
+
+// 4灰阶 BW RAM数据处理
+static uint8_t In2bytes_Out1byte_RAM1(uint8_t data1,uint8_t data2)
+{
+    uint8_t i;
+    uint8_t TempData1,TempData2;
+    uint8_t outdata=0x00;
+    TempData1=data1;
+    TempData2=data2;
+
+    for(i=0;i<4;i++){
+        outdata=outdata<<1;
+        if( ((TempData1&0xC0)==0xC0) || ((TempData1&0xC0)==0x40))
+           outdata=outdata|0x01;
+        else
+          outdata=outdata|0x00;
+
+        TempData1=TempData1<<2;
+    }
+
+    for(i=0;i<4;i++){
+        outdata=outdata<<1;
+         if((TempData2&0xC0)==0xC0||(TempData2&0xC0)==0x40)
+           outdata=outdata|0x01;
+        else
+          outdata=outdata|0x00;
+
+        TempData2=TempData2<<2;
+    }
+    return outdata;
+}
+
+// 4灰阶 RED RAM数据处理
+static uint8_t In2bytes_Out1byte_RAM2(uint8_t data1,uint8_t data2)
+{
+    uint8_t i;
+    uint8_t TempData1,TempData2;
+    uint8_t outdata=0x00;
+    TempData1=data1;
+    TempData2=data2;
+
+    for(i=0;i<4;i++){
+        outdata=outdata<<1;
+        if( ((TempData1&0xC0)==0xC0) || ((TempData1&0xC0)==0x80))
+           outdata=outdata|0x01;
+        else
+          outdata=outdata|0x00;
+
+        TempData1=TempData1<<2;
+    }
+
+    for(i=0;i<4;i++){
+        outdata=outdata<<1;
+         if((TempData2&0xC0)==0xC0||(TempData2&0xC0)==0x80)
+           outdata=outdata|0x01;
+        else
+          outdata=outdata|0x00;
+
+        TempData2=TempData2<<2;
+    }
+    return outdata;
+}
+
+#define PAIRS 65536
+
+static uint8_t pairs[PAIRS * 2];
+static uint8_t bw[PAIRS];
+static uint8_t red[PAIRS];
+static uint8_t only[PAIRS];
+
+// 全部输入字节对一次拆分，再逐对与对照函数比较
+static void test_all_pairs(void) {
+    for (int i = 0; i < PAIRS; i++) {
+        pairs[2 * i] = i >> 8;
+        pairs[2 * i + 1] = i & 0xFF;
+    }
+    QY_SSD1680_Split_4GRAY(pairs, bw, red, PAIRS);
+    for (int i = 0; i < PAIRS; i++) {
+        uint8_t d1 = i >> 8, d2 = i & 0xFF;
+        uint8_t want_bw = ~In2bytes_Out1byte_RAM1(d1, d2);
+        uint8_t want_red = ~In2bytes_Out1byte_RAM2(d1, d2);
+        CHECK(bw[i] == want_bw, "BW %02X %02X: %02X，应为 %02X", d1, d2, bw[i], want_bw);
+        CHECK(red[i] == want_red, "RED %02X %02X: %02X，应为 %02X", d1, d2, red[i], want_red);
+    }
+
+    QY_SSD1680_Split_4GRAY(pairs, only, NULL, PAIRS);
+    CHECK(memcmp(only, bw, PAIRS) == 0, "只输出 BW 平面时结果不同");
+    QY_SSD1680_Split_4GRAY(pairs, NULL, only, PAIRS);
+    CHECK(memcmp(only, red, PAIRS) == 0, "只输出 RED 平面时结果不同");
+}
+
+// 整屏4灰阶图片经 Mock 总线写入：R24 后是 BW 平面，R26 后是 RED 平面
+static void test_display(void) {
+    static uint8_t image[ALLSCREEN_GRAGHBYTES * 2];
+    size_t count;
+    size_t k = 0;
+
+    srand(7);
+    for (size_t i = 0; i < sizeof(image); i++) {
+        image[i] = rand();
+    }
+    EPD_Bus_MockSetBusy(0);             // SSD1680 的 BUSY 低电平空闲
+    EPD_Bus_MockReset();
+    QY_SSD1680_Display_4GRAY(image);
+
+    const uint16_t *log = EPD_Bus_MockLog(&count);
+    CHECK(count > 2 + 2 * ALLSCREEN_GRAGHBYTES, "Mock 记录只有 %zu 字节", count);
+    if (count <= 2 + 2 * ALLSCREEN_GRAGHBYTES) {
+        return;
+    }
+    CHECK(log[k++] == 0x24, "第一个指令是 %03X", log[0]);
+    for (int i = 0; i < ALLSCREEN_GRAGHBYTES; i++, k++) {
+        uint16_t want = EPD_BUS_MOCK_DATA | (uint8_t)~In2bytes_Out1byte_RAM1(image[2 * i], image[2 * i + 1]);
+        CHECK(log[k] == want, "BW 第 %d 字节 %03X，应为 %03X", i, log[k], want);
+    }
+    CHECK(log[k++] == 0x26, "BW 平面之后的指令是 %03X", log[k - 1]);
+    for (int i = 0; i < ALLSCREEN_GRAGHBYTES; i++, k++) {
+        uint16_t want = EPD_BUS_MOCK_DATA | (uint8_t)~In2bytes_Out1byte_RAM2(image[2 * i], image[2 * i + 1]);
+        CHECK(log[k] == want, "RED 第 %d 字节 %03X，应为 %03X", i, log[k], want);
+    }
+}
+
+int main(void) {
+    test_all_pairs();
+    test_display();
+    return check_report();
+}
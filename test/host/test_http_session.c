@@ -0,0 +1,223 @@
+// http_session 的主机测试：esp_http_client 和 esp_timer_get_time 由测试提供（假的客户端和假时钟）
+//   假客户端记下连接的 host，host 和端口不变且服务器没有断开时复用连接，否则先发 HTTP_EVENT_ON_CONNECTED
+//   事件处理函数收到的是每个请求自己的 user_data，返回后客户端看到的仍是会话
+//   耗时按假时钟精确相等：连接、传输（发送请求和收数据）、解析（处理 HTTP_EVENT_ON_DATA 的时间），合计是每个请求之和
+//   请求头的设置和删除、状态码、关闭后不再清理第二次
+#include <stdio.h>
+#include <string.h>
+#include "http_session.h"
+#include "check.h"
+
+#define CONNECT_US  50000           // 建立连接
+#define SEND_US     5000            // 发送请求到收到响应头
+#define CHUNK_US    10000           // 收到一块响应数据
+#define PARSE_US    7000            // 调用者处理一块数据
+#define MAX_HEADERS 8
+
+static int64_t fake_now = 1000000;
+
+int64_t esp_timer_get_time(void) {
+    return fake_now;
+}
+
+// 假客户端：下一个响应由 reply 决定
+struct esp_http_client {
+    http_event_handle_cb handler;
+    void *user_data;
+    int buffer_size_tx;
+    char host[64];                  // 当前 URL 的 host 和端口
+    char connected[64];             // 已连接的 host 和端口，空表示没有连接
+    char keys[MAX_HEADERS][32];
+    char values[MAX_HEADERS][64];
+    int status;
+};
+
+static struct esp_http_client fake;
+static int inits;
+static int cleanups;
+static int user_data_lost;          // 事件处理函数返回后 evt->user_data 不是会话的次数
+
+static struct {
+    int status;
+    int chunks;                     // 响应数据分几块
+    bool close;                     // 响应后服务器断开连接
+} reply;
+
+static void url_host(const char *url, char *host) {
+    const char *p = strstr(url, "://");
+    p = p ? p + 3 : url;
+    size_t n = strcspn(p, "/");
+    memcpy(host, p, n);
+    host[n] = '\0';
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config) {
+    memset(&fake, 0, sizeof(fake));
+    fake.handler = config->event_handler;
+    fake.user_data = config->user_data;
+    fake.buffer_size_tx = config->buffer_size_tx;
+    url_host(config->url, fake.host);
+    inits++;
+    return &fake;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url) {
+    url_host(url, client->host);
+    return ESP_OK;
+}
+
+static int find_header(const char *key) {
+    for (int i = 0; i < MAX_HEADERS; i++) {
+        if (strcmp(fake.keys[i], key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const char *header(const char *key) {
+    int i = find_header(key);
+    return i >= 0 ? fake.values[i] : NULL;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value) {
+    int i = find_header(key);
+    if (i < 0) {
+        i = find_header("");
+    }
+    if (i < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    snprintf(client->keys[i], sizeof(client->keys[i]), "%s", key);
+    snprintf(client->values[i], sizeof(client->values[i]), "%s", value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key) {
+    int i = find_header(key);
+    if (i >= 0) {
+        client->keys[i][0] = '\0';
+    }
+    return ESP_OK;
+}
+
+static esp_err_t emit(esp_http_client_event_id_t id, void *data, int len) {
+    esp_http_client_event_t evt = { .event_id = id, .client = &fake, .data = data, .data_len = len,
+                                    .user_data = fake.user_data };
+    esp_err_t err = fake.handler(&evt);
+    if (evt.user_data != fake.user_data) {
+        user_data_lost++;
+    }
+    return err;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client) {
+    static char chunk[100];
+
+    if (strcmp(client->connected, client->host) != 0) {
+        fake_now += CONNECT_US;
+        strcpy(client->connected, client->host);
+        emit(HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    }
+    fake_now += SEND_US;
+    client->status = reply.status;
+    for (int i = 0; i < reply.chunks; i++) {
+        fake_now += CHUNK_US;
+        emit(HTTP_EVENT_ON_DATA, chunk, sizeof(chunk));
+    }
+    emit(HTTP_EVENT_ON_FINISH, NULL, 0);
+    if (reply.close) {
+        client->connected[0] = '\0';
+        emit(HTTP_EVENT_DISCONNECTED, NULL, 0);
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->status;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    cleanups++;
+    return ESP_OK;
+}
+
+// 调用者的事件处理函数：每块数据花 PARSE_US 解析
+static void *expect_user_data;
+static int wrong_user_data;
+static int data_bytes;
+
+static esp_err_t handler(esp_http_client_event_t *evt) {
+    if (evt->user_data != expect_user_data) {
+        wrong_user_data++;
+    }
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        data_bytes += evt->data_len;
+        fake_now += PARSE_US;
+    }
+    return ESP_OK;
+}
+
+// 发送一个请求，检查这个请求的耗时和连接数
+static void request(http_session_t *s, const char *url, void *user_data, int status, int chunks, bool close,
+                    bool connect, int connections, const char *name) {
+    reply.status = status;
+    reply.chunks = chunks;
+    reply.close = close;
+    expect_user_data = user_data;
+    wrong_user_data = 0;
+    data_bytes = 0;
+
+    CHECK(http_session_perform(s, url, user_data) == ESP_OK, "%s: 请求失败", name);
+    CHECK(wrong_user_data == 0, "%s: %d 个事件的 user_data 不是这个请求的", name, wrong_user_data);
+    CHECK(data_bytes == chunks * 100, "%s: 收到 %d 字节", name, data_bytes);
+    CHECK(http_session_status(s) == status, "%s: 状态码 %d", name, http_session_status(s));
+    CHECK(s->last.connect_us == (connect ? CONNECT_US : 0), "%s: 连接 %lld us", name, (long long)s->last.connect_us);
+    CHECK(s->last.transfer_us == SEND_US + chunks * CHUNK_US, "%s: 传输 %lld us", name,
+          (long long)s->last.transfer_us);
+    CHECK(s->last.parse_us == chunks * PARSE_US, "%s: 解析 %lld us", name, (long long)s->last.parse_us);
+    CHECK(s->connections == connections, "%s: %d 次连接，应为 %d", name, s->connections, connections);
+}
+
+static void add_timing(http_timing_t *sum, const http_timing_t *t) {
+    sum->connect_us += t->connect_us;
+    sum->transfer_us += t->transfer_us;
+    sum->parse_us += t->parse_us;
+}
+
+int main(void) {
+    http_session_t s;
+    int a, b;                       // 两个请求各自的 user_data
+    http_timing_t sum = { 0 };
+
+    CHECK(http_session_open(&s, "http://quote.local:8000/quote", handler, 1536) == ESP_OK, "打开会话失败");
+    CHECK(inits == 1 && fake.buffer_size_tx == 1536, "发送缓冲区 %d", fake.buffer_size_tx);
+    CHECK(s.requests == 0 && s.connections == 0, "打开会话时就连接了");
+
+    // 请求头：设置后每个请求都带，NULL 删除
+    http_session_set_header(&s, "Accept", "application/json");
+    http_session_set_header(&s, "If-None-Match", "\"abc\"");
+    http_session_set_header(&s, "If-None-Match", NULL);
+    CHECK(header("Accept") && strcmp(header("Accept"), "application/json") == 0, "Accept 没有设置");
+    CHECK(header("If-None-Match") == NULL, "If-None-Match 没有删除");
+
+    request(&s, "http://quote.local:8000/quote", &a, 200, 3, false, true, 1, "第1个请求");
+    add_timing(&sum, &s.last);
+    request(&s, "http://quote.local:8000/quote?retry=1", &b, 304, 0, false, false, 1, "同一 host 复用连接");
+    add_timing(&sum, &s.last);
+    request(&s, "http://asset.local:8080/font", &a, 200, 2, true, true, 2, "换 host 重新连接");
+    add_timing(&sum, &s.last);
+    request(&s, "http://asset.local:8080/font", &b, 200, 1, false, true, 3, "服务器断开后重新连接");
+    add_timing(&sum, &s.last);
+
+    CHECK(user_data_lost == 0, "%d 次事件处理后客户端的 user_data 不是会话", user_data_lost);
+    CHECK(s.requests == 4, "%d 个请求", s.requests);
+    CHECK(s.total.connect_us == sum.connect_us && s.total.transfer_us == sum.transfer_us &&
+          s.total.parse_us == sum.parse_us, "合计耗时不是每个请求之和");
+
+    http_session_close(&s);
+    CHECK(cleanups == 1 && s.client == NULL, "关闭时没有清理客户端");
+    http_session_close(&s);
+    CHECK(cleanups == 1, "关闭两次清理了两次");
+    return check_report();
+}
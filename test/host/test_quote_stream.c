@@ -0,0 +1,241 @@
+// quote_stream 的主机测试：输入是 tools/quote_server.py --chunked 发出的响应体（gen_quote_fixture.py 生成）
+//   分块：先按服务器的块边界去掉分块格式（与 esp_http_client 相同，每块一次 HTTP_EVENT_ON_DATA），
+//         再按每次1字节、随机长度切分，JSON 和二进制语录的解析结果都要与服务器排版的内容相同
+//   截断：响应体在字模点阵中间断开，以及每个更短的前缀，quote_stream_end 都不能返回 ESP_OK
+//   超长：语录文本、屏幕型号超过上限时拒绝；字模数和点阵超过上限时二进制拒绝，JSON 丢掉多出的部分
+#define _GNU_SOURCE                             // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quote_stream.h"
+#include "epaper_gui.h"
+#include "quote_fixture.h"
+#include "check.h"
+
+#define NFIXTURES   (sizeof(fixtures) / sizeof(fixtures[0]))
+#define MAX_CHUNKS  4096
+
+static quote_stream_t s;
+
+static uint8_t body[64 * 1024];                 // 去掉分块格式后的响应体
+static size_t body_len;
+static size_t chunks[MAX_CHUNKS];               // 服务器的块大小
+static int chunk_count;
+
+// 按 HTTP/1.1 分块格式拆开：每块是十六进制长度、CRLF、数据、CRLF，长度为0的块结束
+static void dechunk(const fixture_t *f) {
+    const uint8_t *p = f->chunked;
+    const uint8_t *end = f->chunked + f->chunked_len;
+
+    body_len = 0;
+    chunk_count = 0;
+    for (;;) {
+        char *next;
+        unsigned long n = strtoul((const char *)p, &next, 16);
+        p = (const uint8_t *)next;
+        CHECK(p + 2 <= end && p[0] == '\r' && p[1] == '\n', "%s: 块长度后面不是 CRLF", f->name);
+        p += 2;
+        if (n == 0) {
+            break;
+        }
+        CHECK(p + n + 2 <= end && p[n] == '\r' && p[n + 1] == '\n', "%s: 块数据后面不是 CRLF", f->name);
+        CHECK(body_len + n <= sizeof(body) && chunk_count < MAX_CHUNKS, "%s: 响应体太长", f->name);
+        if (failures) {
+            exit(1);
+        }
+        memcpy(body + body_len, p, n);
+        body_len += n;
+        chunks[chunk_count++] = n;
+        p += n + 2;
+    }
+    CHECK(p + 2 == end && p[0] == '\r' && p[1] == '\n', "%s: 结束块后面还有数据", f->name);
+}
+
+// 按解析器的上限，这个响应应有的结果
+static esp_err_t expected_err(const fixture_t *f) {
+    if (strlen(f->quote) + 1 > QUOTE_STREAM_QUOTE_LEN || strlen(f->model) + 1 > QUOTE_STREAM_MODEL_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (f->binary && (f->glyph_count > MAX_BITMAPS || f->glyphs[0].len > QUOTE_STREAM_GLYPH_BYTES)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+// sink 收到的字模，按字模下标记下
+static uint8_t sunk[MAX_BITMAPS][QUOTE_STREAM_GLYPH_BYTES];
+static uint16_t sunk_len[MAX_BITMAPS];
+static const fixture_t *sink_fixture;
+
+static bool sink(uint32_t codepoint, int font_size, const uint8_t *data, uint16_t len) {
+    const fixture_t *f = sink_fixture;
+
+    for (int i = 0; i < f->glyph_count && i < MAX_BITMAPS; i++) {
+        int n;
+        if (EPD_UTF8_Decode(f->glyphs[i].character, &n) == codepoint) {
+            CHECK(font_size == f->font_size, "%s: sink 字号 %d", f->name, font_size);
+            memcpy(sunk[i], data, len);
+            sunk_len[i] = len;
+            return true;
+        }
+    }
+    CHECK(0, "%s: sink 收到不存在的码点 %04X", f->name, (unsigned)codepoint);
+    return false;
+}
+
+// 解析结果与服务器排版的内容比较，字模数和位置数按 MAX_BITMAPS 截断
+static void check_result(const fixture_t *f, const char *how, bool with_sink) {
+    int glyphs = f->glyph_count < MAX_BITMAPS ? f->glyph_count : MAX_BITMAPS;
+    int places = f->place_count < MAX_BITMAPS ? f->place_count : MAX_BITMAPS;
+
+    CHECK(strcmp(s.screen_model, f->model) == 0, "%s %s: 型号 %s", f->name, how, s.screen_model);
+    CHECK(strcmp(s.quote, f->quote) == 0, "%s %s: 语录 %s", f->name, how, s.quote);
+    CHECK(s.font_size == f->font_size, "%s %s: 字号 %d", f->name, how, s.font_size);
+    CHECK(s.glyph_count == glyphs, "%s %s: %d 个字模，应为 %d", f->name, how, s.glyph_count, glyphs);
+    CHECK(s.placement_count == places, "%s %s: %d 个位置，应为 %d", f->name, how, s.placement_count, places);
+
+    for (int i = 0; i < s.glyph_count && i < glyphs; i++) {
+        const fixture_glyph_t *want = &f->glyphs[i];
+        const GlyphBitmap *g = &s.glyphs[i];
+
+        CHECK(strcmp(g->character, want->character) == 0, "%s %s: 第 %d 个字模是 %s", f->name, how, i, g->character);
+        if (want->len > QUOTE_STREAM_GLYPH_BYTES) {
+            // 只有 JSON 会走到这里：点阵超过上限的字模保留下标，没有点阵
+            CHECK(g->width == 0 && g->height == 0 && g->data == NULL, "%s %s: 第 %d 个字模超长却有点阵", f->name, how, i);
+            continue;
+        }
+        CHECK(g->width == want->width && g->height == want->height, "%s %s: 第 %d 个字模 %dx%d", f->name, how, i,
+              g->width, g->height);
+        if (with_sink) {
+            CHECK(g->data == NULL, "%s %s: 第 %d 个字模交给 sink 后还有点阵", f->name, how, i);
+            CHECK(sunk_len[i] == want->len && memcmp(sunk[i], want->data, want->len) == 0,
+                  "%s %s: sink 收到的第 %d 个字模不同", f->name, how, i);
+        } else {
+            CHECK(g->data != NULL && memcmp(g->data, want->data, want->len) == 0, "%s %s: 第 %d 个字模的点阵不同",
+                  f->name, how, i);
+        }
+    }
+    for (int i = 0; i < s.placement_count && i < places; i++) {
+        const GlyphPlacement *p = &s.placements[i];
+        const fixture_place_t *want = &f->places[i];
+        CHECK(p->glyph_index == want->index && p->x == want->x && p->y == want->y,
+              "%s %s: 第 %d 个位置 %u,%d,%d，应为 %u,%d,%d", f->name, how, i,
+              p->glyph_index, p->x, p->y, want->index, want->x, want->y);
+    }
+}
+
+// 把响应体的前 len 字节按 sizes 切分送进解析器，每段复制到刚好大小的缓冲区，越界读能被检查出来
+// 参数：   sizes,每段长度，NULL 时随机 1..max 字节，max 为 1 时每次1字节
+static esp_err_t feed_all(const fixture_t *f, size_t len, const size_t *sizes, int max, quote_glyph_sink_t sink_fn) {
+    esp_err_t want = expected_err(f);
+    size_t pos = 0;
+    int k = 0;
+
+    memset(sunk_len, 0, sizeof(sunk_len));
+    sink_fixture = f;
+    quote_stream_begin(&s, f->binary, sink_fn);
+    while (pos < len) {
+        size_t n = sizes ? sizes[k++] : (size_t)(rand() % max + 1);
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        uint8_t *piece = malloc(n);
+        memcpy(piece, body + pos, n);
+        esp_err_t err = quote_stream_feed(&s, piece, n);
+        free(piece);
+        CHECK(want != ESP_OK || err == ESP_OK, "%s: 第 %zu 字节处解析出错 %s", f->name, pos, esp_err_to_name(err));
+        pos += n;
+    }
+    return quote_stream_end(&s);
+}
+
+// 完整的响应体按各种块边界解析
+static void test_splits(const fixture_t *f) {
+    esp_err_t want = expected_err(f);
+    char how[32];
+    esp_err_t err;
+
+    err = feed_all(f, body_len, chunks, 0, NULL);
+    CHECK(err == want, "%s 服务器分块: %s，应为 %s", f->name, esp_err_to_name(err), esp_err_to_name(want));
+    if (err == ESP_OK) {
+        check_result(f, "服务器分块", false);
+    }
+    quote_stream_release(&s);
+
+    err = feed_all(f, body_len, chunks, 0, sink);
+    CHECK(err == want, "%s sink: %s", f->name, esp_err_to_name(err));
+    if (err == ESP_OK) {
+        check_result(f, "sink", true);
+    }
+    quote_stream_release(&s);
+
+    err = feed_all(f, body_len, NULL, 1, NULL);
+    CHECK(err == want, "%s 每次1字节: %s", f->name, esp_err_to_name(err));
+    if (err == ESP_OK) {
+        check_result(f, "每次1字节", false);
+    }
+    quote_stream_release(&s);
+
+    for (int round = 0; round < 20; round++) {
+        int max = 1 + rand() % (round < 10 ? 16 : 2048);
+        snprintf(how, sizeof(how), "随机分块 %d", round);
+        err = feed_all(f, body_len, NULL, max, NULL);
+        CHECK(err == want, "%s %s: %s", f->name, how, esp_err_to_name(err));
+        if (err == ESP_OK) {
+            check_result(f, how, false);
+        }
+        quote_stream_release(&s);
+    }
+}
+
+// 最后一个字模点阵中间的位置：二进制的点阵在最后；JSON 找最后一个字的数组
+static size_t mid_glyph_cut(const fixture_t *f) {
+    const fixture_glyph_t *last = &f->glyphs[f->glyph_count - 1];
+
+    if (f->binary) {
+        return body_len - last->len / 2;
+    }
+    char key[16];
+    int n = snprintf(key, sizeof(key), "\"%s\":[", last->character);
+    const uint8_t *p = memmem(body, body_len, key, n);
+    CHECK(p != NULL, "%s: JSON 里找不到最后一个字 %s", f->name, last->character);
+    if (p == NULL) {
+        return body_len / 2;
+    }
+    const uint8_t *close = memchr(p, ']', body + body_len - p);
+    return (p + n - body) + (close - p - n) / 2;
+}
+
+// 截断的响应体不能解析成功
+static void test_truncated(const fixture_t *f) {
+    esp_err_t err;
+    size_t cut = mid_glyph_cut(f);
+
+    err = feed_all(f, cut, chunks, 0, NULL);
+    CHECK(err != ESP_OK, "%s: 在第 %zu 字节（字模点阵中间）截断却解析成功", f->name, cut);
+    quote_stream_release(&s);
+    err = feed_all(f, cut, chunks, 0, sink);
+    CHECK(err != ESP_OK, "%s: 带 sink 在第 %zu 字节截断却解析成功", f->name, cut);
+    quote_stream_release(&s);
+
+    for (size_t len = 0; len < body_len; len++) {
+        quote_stream_begin(&s, f->binary, NULL);
+        quote_stream_feed(&s, body, len);
+        err = quote_stream_end(&s);
+        CHECK(err != ESP_OK, "%s: %zu 字节的前缀解析成功", f->name, len);
+        quote_stream_release(&s);
+    }
+}
+
+int main(void) {
+    srand(2024);
+    for (size_t k = 0; k < NFIXTURES; k++) {
+        const fixture_t *f = &fixtures[k];
+        dechunk(f);
+        test_splits(f);
+        if (expected_err(f) == ESP_OK) {
+            test_truncated(f);
+        }
+    }
+    return check_report();
+}
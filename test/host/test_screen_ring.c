@@ -0,0 +1,209 @@
+// screen_ring 的主机测试：flash 用 RAM 模拟（大小与 partitions.csv 的 screens 分区相同），按 NOR flash 的规则
+//   擦除按扇区、擦除后为 0xFF，写入只能把1改成0，写到没有擦除的字节算错
+//   大小混合：100000/250000/1000 字节的一批，第2屏放不下丢掉，第3屏不能擦掉第1屏
+//   随机：每批屏数、每屏大小和分段都随机，保存下来的屏按顺序都能读回原样；回到开头后按扇区擦除、再绕一圈都不能覆盖同一批前面的屏
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "esp_partition.h"
+#include "screen_ring.h"
+#include "quote_payload.h"
+#include "check.h"
+
+#define PART_SIZE       0x50000
+#define SECTOR          4096
+#define MAX_SCREENS     24
+#define MAX_SCREEN_LEN  200000
+
+static uint8_t flash[PART_SIZE];
+static int write_errors;
+
+static const esp_partition_t screens = {
+    .type = ESP_PARTITION_TYPE_DATA, .subtype = 0x42, .size = PART_SIZE, .erase_size = SECTOR, .label = "screens",
+};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    return strcmp(label, SCREEN_RING_PARTITION) == 0 ? &screens : NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    if (src_offset + size > PART_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, flash + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    const uint8_t *p = src;
+
+    if (dst_offset + size > PART_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (flash[dst_offset + i] != 0xFF) {
+            write_errors++;
+        }
+        flash[dst_offset + i] &= p[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (offset % SECTOR || size % SECTOR || offset + size > PART_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(flash + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+// 一批的响应和每屏的内容，每屏前4字节是它在这一批里的下标
+static uint8_t *payload[MAX_SCREENS];
+static uint32_t payload_len[MAX_SCREENS];
+static uint8_t *batch;
+static size_t batch_len;
+
+static void build_batch(int count, const uint32_t *lens) {
+    quote_batch_header_t h = { QUOTE_BATCH_MAGIC, QUOTE_BATCH_VERSION, count, 0 };
+    size_t total = sizeof(h);
+
+    for (int i = 0; i < count; i++) {
+        total += sizeof(quote_batch_entry_t) + lens[i];
+    }
+    batch = realloc(batch, total);
+    memcpy(batch, &h, sizeof(h));
+    batch_len = sizeof(h);
+    for (int i = 0; i < count; i++) {
+        quote_batch_entry_t e = { i * 600, lens[i] };
+        memcpy(batch + batch_len, &e, sizeof(e));
+        batch_len += sizeof(e);
+        payload[i] = batch + batch_len;
+        payload_len[i] = lens[i];
+        for (uint32_t k = 0; k < lens[i]; k++) {
+            payload[i][k] = rand();
+        }
+        memcpy(payload[i], &i, sizeof(i));
+        batch_len += lens[i];
+    }
+}
+
+// 按随机长度分段保存，max 为 0 时一次送完
+static esp_err_t store_batch(int64_t now, int max) {
+    esp_err_t err = ESP_OK;
+
+    screen_ring_store_begin(now);
+    for (size_t pos = 0; pos < batch_len && err == ESP_OK; ) {
+        size_t n = max ? (size_t)(rand() % max + 1) : batch_len;
+        if (n > batch_len - pos) {
+            n = batch_len - pos;
+        }
+        err = screen_ring_store_feed(batch + pos, n);
+        pos += n;
+    }
+    esp_err_t end = screen_ring_store_end();
+    return err != ESP_OK ? err : end;
+}
+
+static uint8_t readback[MAX_SCREEN_LEN];
+static size_t readback_len;
+
+static esp_err_t collect(void *ctx, const uint8_t *data, size_t len) {
+    if (readback_len + len > sizeof(readback)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(readback + readback_len, data, len);
+    readback_len += len;
+    return ESP_OK;
+}
+
+// 读回第 i 个保存的屏，返回它在这一批里的下标，出错返回 -1
+static int read_screen(int i, const char *name) {
+    readback_len = 0;
+    esp_err_t err = screen_ring_read(i, collect, NULL);
+    CHECK(err == ESP_OK, "%s: 第 %d 屏读取失败 %s", name, i, esp_err_to_name(err));
+    if (err != ESP_OK || readback_len < sizeof(int)) {
+        return -1;
+    }
+    int k;
+    memcpy(&k, readback, sizeof(k));
+    CHECK(k >= 0 && k < MAX_SCREENS && readback_len == payload_len[k] && memcmp(readback, payload[k], readback_len) == 0,
+          "%s: 第 %d 屏的内容不对", name, i);
+    return k;
+}
+
+// 保存了几屏：全部标记为未显示，足够晚的时候最后一屏也到时间了
+static int stored_count(void) {
+    screen_ring_mark_shown(-1);
+    return screen_ring_due(INT32_MAX) + 1;
+}
+
+// 大小混合的一批：第2屏回到开头也放不下，丢掉；第3屏接着第1屏写，不能擦掉第1屏
+static void test_mixed_sizes(void) {
+    const uint32_t lens[] = { 100000, 250000, 1000 };
+
+    build_batch(3, lens);
+    CHECK(store_batch(1000, 0) == ESP_OK, "大小混合: 保存失败");
+    CHECK(stored_count() == 2, "大小混合: 保存了 %d 屏", stored_count());
+    CHECK(read_screen(0, "大小混合") == 0, "大小混合: 第1屏不是这一批的第1屏");
+    CHECK(read_screen(1, "大小混合") == 2, "大小混合: 第2屏不是这一批的第3屏");
+
+    // 下一批从第3屏之后开始，回到开头后覆盖上一批，这一批自己的屏都完好
+    const uint32_t next[] = { 150000, 150000, 20000, 5000 };
+    build_batch(4, next);
+    CHECK(store_batch(2000, 4096) == ESP_OK, "大小混合第二批: 保存失败");
+    int n = stored_count();
+    CHECK(n == 3, "大小混合第二批: 保存了 %d 屏", n);
+    for (int i = 0; i < n; i++) {
+        read_screen(i, "大小混合第二批");
+    }
+}
+
+// 随机的批：保存的屏按顺序读回原样，丢掉的只能是放不下的
+static void test_random(void) {
+    uint32_t lens[MAX_SCREENS];
+
+    for (int round = 0; round < 200; round++) {
+        char name[32];
+        int count = 1 + rand() % MAX_SCREENS;
+        uint32_t total = 0;
+
+        snprintf(name, sizeof(name), "随机第 %d 批", round);
+        for (int i = 0; i < count; i++) {
+            int big = rand() % 4 == 0;
+            lens[i] = sizeof(quote_payload_header_t) + rand() % (big ? MAX_SCREEN_LEN - 16 : 30000);
+            total += lens[i];
+        }
+        build_batch(count, lens);
+        esp_err_t err = store_batch(round * 100000, 1 + rand() % 3000);
+        CHECK(err == ESP_OK, "%s: 保存失败 %s", name, esp_err_to_name(err));
+
+        int n = stored_count();
+        int last = -1;
+        uint32_t kept = 0;
+        for (int i = 0; i < n; i++) {
+            int k = read_screen(i, name);
+            CHECK(k > last, "%s: 第 %d 屏的顺序不对", name, i);
+            if (k >= 0) {
+                kept += payload_len[k];
+                last = k;
+            }
+        }
+        CHECK(n > 0 || lens[0] > PART_SIZE / 2, "%s: 一屏也没有保存", name);
+        CHECK(kept <= PART_SIZE && (n == count || n == SCREEN_RING_MAX || total > PART_SIZE / 2),
+              "%s: %d 屏只保存了 %d 屏", name, count, n);
+    }
+}
+
+int main(void) {
+    srand(99);
+    freopen("/dev/null", "w", stderr);          // 丢掉的屏每次都有警告，这里只看检查结果
+    memset(flash, 0xFF, sizeof(flash));
+    CHECK(screen_ring_open() == ESP_OK && screen_ring_available(), "打开分区失败");
+    test_mixed_sizes();
+    test_random();
+    CHECK(write_errors == 0, "%d 字节写到了没有擦除的 flash 上", write_errors);
+    free(batch);
+    return check_report();
+}
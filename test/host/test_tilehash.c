@@ -0,0 +1,211 @@
+// epaper_tilehash 的主机测试：用合成画面检查分块哈希和变化区域
+//   几何：2bpp（中景园3.52寸，每行45字节，最右一列块只有1字节）、1bpp（奇耘2.9寸，296行，最下一行块只有8行）
+//         和每行15字节的1bpp画布（最右一列块只有1字节）
+//   单像素：每个字节改一个像素，只有所在的块变化，区域就是这一块
+//   合并：随机改几处，与逐字节比较得到的变化块对照，区域要盖住所有变化的字节，外框与变化块的外框相同
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_tilehash.h"
+#include "check.h"
+
+#define MAX_BYTES   (45 * 384)
+#define MAX_TILES   512
+#define MAX_RECTS   4
+
+typedef struct {
+    const char *name;
+    uint16_t width_bytes;
+    uint16_t rows;
+    uint8_t bpp;
+    uint16_t tiles_x;       // 期望的块数
+    uint16_t tiles_y;
+} case_t;
+
+static const case_t cases[] = {
+    { "2bpp 45x384", 45, 384, 2, 12, 24 },
+    { "1bpp 16x296", 16, 296, 1, 8, 19 },
+    { "1bpp 15x40",  15, 40,  1, 8, 3 },
+};
+
+static uint8_t old_img[MAX_BYTES];
+static uint8_t new_img[MAX_BYTES];
+static uint32_t old_hash[MAX_TILES];
+static uint32_t new_hash[MAX_TILES];
+
+// 逐字节比较两帧，得到变化的块
+static int brute_force_tiles(const EPD_TILE_GEOM *g, uint8_t *changed) {
+    int n = 0;
+
+    memset(changed, 0, (size_t)g->tiles_x * g->tiles_y);
+    for (int r = 0; r < g->rows; r++) {
+        for (int b = 0; b < g->width_bytes; b++) {
+            size_t i = (size_t)r * g->width_bytes + b;
+            int t = (r / EPD_TILE_ROWS) * g->tiles_x + b / g->tile_bytes;
+            if (old_img[i] != new_img[i] && !changed[t]) {
+                changed[t] = 1;
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+// 字节 (r,b) 的像素是否在区域内
+static int rect_covers_byte(const EPD_TILE_GEOM *g, const EPD_TILE_RECT *rect, int r, int b) {
+    int x0 = b * g->px_per_byte;
+    int x1 = x0 + g->px_per_byte - 1;
+    return r >= rect->Y0 && r <= rect->Y1 && x0 >= rect->X0 && x1 <= rect->X1;
+}
+
+// 块 t 换算成像素坐标，按画布边界截断
+static EPD_TILE_RECT tile_rect(const EPD_TILE_GEOM *g, int tx0, int ty0, int tx1, int ty1) {
+    int tile_px = g->tile_bytes * g->px_per_byte;
+    int width_px = g->width_bytes * g->px_per_byte;
+    EPD_TILE_RECT rect = {
+        tx0 * tile_px, ty0 * EPD_TILE_ROWS,
+        (tx1 + 1) * tile_px - 1, (ty1 + 1) * EPD_TILE_ROWS - 1,
+    };
+    if (rect.X1 >= width_px) rect.X1 = width_px - 1;
+    if (rect.Y1 >= g->rows) rect.Y1 = g->rows - 1;
+    return rect;
+}
+
+static void test_geom(const case_t *c, EPD_TILE_GEOM *g) {
+    uint16_t tiles = EPD_TileHash_Geom(g, c->width_bytes, c->rows, c->bpp);
+
+    CHECK(g->tiles_x == c->tiles_x && g->tiles_y == c->tiles_y, "%s: 块数 %ux%u", c->name, g->tiles_x, g->tiles_y);
+    CHECK(tiles == c->tiles_x * c->tiles_y, "%s: 总块数 %u", c->name, tiles);
+    CHECK(g->tile_bytes * g->px_per_byte == 16, "%s: 块宽 %u 字节", c->name, g->tile_bytes);
+}
+
+// 相同画面没有变化；没有上次的哈希表时整个画布是一个区域
+static void test_same_and_first(const case_t *c, const EPD_TILE_GEOM *g) {
+    EPD_TILE_RECT rects[MAX_RECTS];
+    uint8_t count;
+    size_t bytes = (size_t)c->width_bytes * c->rows;
+
+    for (size_t i = 0; i < bytes; i++) {
+        old_img[i] = rand();
+    }
+    EPD_TileHash_Compute(g, old_img, old_hash);
+    memcpy(new_img, old_img, bytes);
+    EPD_TileHash_Compute(g, new_img, new_hash);
+    CHECK(EPD_TileHash_Diff(g, old_hash, new_hash, rects, MAX_RECTS, &count) == 0 && count == 0, "%s: 相同画面有变化", c->name);
+
+    uint16_t n = EPD_TileHash_Diff(g, NULL, new_hash, rects, MAX_RECTS, &count);
+    EPD_TILE_RECT all = tile_rect(g, 0, 0, g->tiles_x - 1, g->tiles_y - 1);
+    CHECK(n == g->tiles_x * g->tiles_y && count == 1, "%s: 第一帧 %u 块 %u 个区域", c->name, n, count);
+    CHECK(memcmp(&rects[0], &all, sizeof(all)) == 0, "%s: 第一帧区域 %u,%u-%u,%u", c->name,
+          rects[0].X0, rects[0].Y0, rects[0].X1, rects[0].Y1);
+}
+
+// 每个字节改一个像素：只有所在的块变化，区域就是这一块，包括最右一列和最下一行不满的块
+static void test_single_pixel(const case_t *c, const EPD_TILE_GEOM *g) {
+    EPD_TILE_RECT rects[MAX_RECTS];
+    uint8_t count;
+    int bpp = c->bpp;
+
+    for (int r = 0; r < c->rows; r++) {
+        for (int b = 0; b < c->width_bytes; b++) {
+            size_t i = (size_t)r * c->width_bytes + b;
+            int px = rand() % (8 / bpp);
+            uint8_t mask = ((1 << bpp) - 1) << (px * bpp);
+
+            memcpy(new_img, old_img, (size_t)c->width_bytes * c->rows);
+            new_img[i] ^= mask & (rand() | 1 << (px * bpp));   // 至少翻转一位
+            EPD_TileHash_Compute(g, new_img, new_hash);
+
+            int tx = b / g->tile_bytes;
+            int ty = r / EPD_TILE_ROWS;
+            EPD_TILE_RECT want = tile_rect(g, tx, ty, tx, ty);
+            uint16_t n = EPD_TileHash_Diff(g, old_hash, new_hash, rects, MAX_RECTS, &count);
+            CHECK(n == 1 && count == 1, "%s: 字节 %d,%d 变化 %u 块 %u 个区域", c->name, r, b, n, count);
+            if (count == 1) {
+                CHECK(memcmp(&rects[0], &want, sizeof(want)) == 0 && rect_covers_byte(g, &rects[0], r, b),
+                      "%s: 字节 %d,%d 的区域 %u,%u-%u,%u", c->name, r, b,
+                      rects[0].X0, rects[0].Y0, rects[0].X1, rects[0].Y1);
+            }
+        }
+    }
+}
+
+// 随机改几块矩形区域，与逐字节比较对照
+static void test_merge(const case_t *c, const EPD_TILE_GEOM *g) {
+    static uint8_t changed[MAX_TILES];
+    EPD_TILE_RECT rects[MAX_RECTS];
+    uint8_t count;
+    size_t bytes = (size_t)c->width_bytes * c->rows;
+
+    for (int round = 0; round < 2000; round++) {
+        int max_rects = 1 + round % MAX_RECTS;
+        memcpy(new_img, old_img, bytes);
+        for (int k = rand() % 6; k > 0; k--) {
+            int r0 = rand() % c->rows, b0 = rand() % c->width_bytes;
+            int r1 = r0 + rand() % 24, b1 = b0 + rand() % 6;
+            for (int r = r0; r <= r1 && r < c->rows; r++) {
+                for (int b = b0; b <= b1 && b < c->width_bytes; b++) {
+                    new_img[(size_t)r * c->width_bytes + b] ^= 1 + rand() % 255;
+                }
+            }
+        }
+        EPD_TileHash_Compute(g, new_img, new_hash);
+        uint16_t n = EPD_TileHash_Diff(g, old_hash, new_hash, rects, max_rects, &count);
+        int want = brute_force_tiles(g, changed);
+
+        CHECK(n == want, "%s 第 %d 轮: 变化 %u 块，逐字节比较 %d 块", c->name, round, n, want);
+        CHECK(count <= max_rects && (count == 0) == (want == 0), "%s 第 %d 轮: %u 个区域", c->name, round, count);
+
+        // 每个变化的字节都在某个区域内
+        for (int r = 0; r < c->rows; r++) {
+            for (int b = 0; b < c->width_bytes; b++) {
+                size_t i = (size_t)r * c->width_bytes + b;
+                if (old_img[i] == new_img[i]) {
+                    continue;
+                }
+                int k = 0;
+                while (k < count && !rect_covers_byte(g, &rects[k], r, b)) {
+                    k++;
+                }
+                CHECK(k < count, "%s 第 %d 轮: 字节 %d,%d 不在任何区域内", c->name, round, r, b);
+            }
+        }
+
+        // 区域的外框等于变化块的外框
+        if (want > 0 && count > 0) {
+            int tx0 = g->tiles_x, ty0 = g->tiles_y, tx1 = -1, ty1 = -1;
+            for (int t = 0; t < g->tiles_x * g->tiles_y; t++) {
+                if (changed[t]) {
+                    int tx = t % g->tiles_x, ty = t / g->tiles_x;
+                    if (tx < tx0) tx0 = tx;
+                    if (ty < ty0) ty0 = ty;
+                    if (tx > tx1) tx1 = tx;
+                    if (ty > ty1) ty1 = ty;
+                }
+            }
+            EPD_TILE_RECT bbox = rects[0];
+            for (int k = 1; k < count; k++) {
+                if (rects[k].X0 < bbox.X0) bbox.X0 = rects[k].X0;
+                if (rects[k].Y0 < bbox.Y0) bbox.Y0 = rects[k].Y0;
+                if (rects[k].X1 > bbox.X1) bbox.X1 = rects[k].X1;
+                if (rects[k].Y1 > bbox.Y1) bbox.Y1 = rects[k].Y1;
+            }
+            EPD_TILE_RECT want_bbox = tile_rect(g, tx0, ty0, tx1, ty1);
+            CHECK(memcmp(&bbox, &want_bbox, sizeof(bbox)) == 0, "%s 第 %d 轮: 外框 %u,%u-%u,%u，应为 %u,%u-%u,%u",
+                  c->name, round, bbox.X0, bbox.Y0, bbox.X1, bbox.Y1,
+                  want_bbox.X0, want_bbox.Y0, want_bbox.X1, want_bbox.Y1);
+        }
+    }
+}
+
+int main(void) {
+    srand(12345);
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        EPD_TILE_GEOM g;
+        test_geom(&cases[k], &g);
+        test_same_and_first(&cases[k], &g);
+        test_single_pixel(&cases[k], &g);
+        test_merge(&cases[k], &g);
+    }
+    return check_report();
+}
@@ -0,0 +1,129 @@
+// wake_policy 的主机测试：time() 和唤醒原因由测试提供（假时钟），RTC 内存里的状态在进程内保留
+//   上电、按键唤醒总是联网；定时唤醒没到联网时间（差 WAKE_FETCH_SLACK_S 以内算到期）时本地刷新
+//   没有注册本地刷新回调、回调返回 false、时钟被往回调过时改为联网
+//   睡眠时长取下次联网和本地刷新时间中较早的一个，至少 1 秒，最多 WAKE_FETCH_MAX_S
+#include <stdio.h>
+#include <time.h>
+#include "esp_sleep.h"
+#include "wake_policy.h"
+#include "check.h"
+
+#define T0  1800000000              // 假时钟的起点，time() 的秒数
+
+static int64_t fake_now = T0;
+static esp_sleep_wakeup_cause_t fake_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+time_t time(time_t *t) {
+    if (t) {
+        *t = fake_now;
+    }
+    return fake_now;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+    return fake_cause;
+}
+
+static bool render_result;
+static int render_calls;
+static int64_t deadline;
+
+static bool render(void) {
+    render_calls++;
+    return render_result;
+}
+
+static int64_t next_deadline(void) {
+    return deadline;
+}
+
+// 在 now 时刻以 cause 唤醒，返回决定
+static wake_action_t wake(esp_sleep_wakeup_cause_t cause, int64_t now) {
+    fake_cause = cause;
+    fake_now = now;
+    return wake_policy_decide();
+}
+
+// 断电后第一次唤醒：RTC 内存里没有状态
+static void test_first_boot(void) {
+    register_wake_local_render_callback(render);
+    CHECK(wake(ESP_SLEEP_WAKEUP_UNDEFINED, T0) == WAKE_ACTION_NETWORK, "上电不联网");
+    CHECK(wake_policy_reason() == REQUEST_REASON_UNKNOWN, "上电的请求原因 %d", wake_policy_reason());
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, T0) == WAKE_ACTION_NETWORK, "没有状态时定时唤醒不联网");
+    CHECK(wake_policy_sleep_us() == WAKE_FETCH_INTERVAL_S * 1000000ULL, "没有状态时睡眠 %llu us",
+          (unsigned long long)wake_policy_sleep_us());
+}
+
+// 联网后的定时唤醒
+static void test_timer_wakes(void) {
+    fake_now = T0;
+    wake_policy_fetch_done(0);          // 没有给下次联网时间，推迟一个周期
+    int64_t next = T0 + WAKE_FETCH_INTERVAL_S;
+
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, T0 + 600) == WAKE_ACTION_LOCAL, "没到联网时间却联网");
+    CHECK(wake_policy_reason() == REQUEST_REASON_TIMER, "定时唤醒的请求原因 %d", wake_policy_reason());
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, next - WAKE_FETCH_SLACK_S - 1) == WAKE_ACTION_LOCAL, "差一点到期就联网");
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, next - WAKE_FETCH_SLACK_S) == WAKE_ACTION_NETWORK, "提前唤醒的误差内没有联网");
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, next + 10) == WAKE_ACTION_NETWORK, "过了联网时间没有联网");
+
+    CHECK(wake(ESP_SLEEP_WAKEUP_EXT0, T0 + 600) == WAKE_ACTION_NETWORK, "按键唤醒不联网");
+    CHECK(wake_policy_reason() == REQUEST_REASON_BUTTON_TRIGGER, "按键的请求原因 %d", wake_policy_reason());
+    CHECK(wake(ESP_SLEEP_WAKEUP_EXT1, T0 + 600) == WAKE_ACTION_NETWORK, "EXT1 唤醒不联网");
+
+    // 时钟被往回调过：下次联网比最长推迟还远
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, next - WAKE_FETCH_MAX_S - 1) == WAKE_ACTION_NETWORK, "时钟往回调后没有联网");
+
+    register_wake_local_render_callback(NULL);
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, T0 + 600) == WAKE_ACTION_NETWORK, "没有本地刷新回调却不联网");
+    CHECK(!wake_policy_run_local(), "没有本地刷新回调却算本地处理了");
+    register_wake_local_render_callback(render);
+}
+
+// 本地刷新回调的结果
+static void test_run_local(void) {
+    render_calls = 0;
+    render_result = true;
+    CHECK(wake_policy_run_local() && render_calls == 1, "本地刷新成功却要联网");
+    render_result = false;
+    CHECK(!wake_policy_run_local() && render_calls == 2, "本地没有内容却不联网");
+}
+
+// 下次联网时间的限制和睡眠时长
+static void test_sleep(void) {
+    fake_now = T0;
+    wake_policy_fetch_done(T0 + 7200);
+    CHECK(wake_policy_sleep_us() == 7200 * 1000000ULL, "给定的联网时间没有用上");
+
+    wake_policy_fetch_done(T0 - 10);    // 已经过去，推迟一个周期
+    CHECK(wake_policy_sleep_us() == WAKE_FETCH_INTERVAL_S * 1000000ULL, "过去的联网时间没有推迟");
+
+    wake_policy_fetch_done(T0 + 2 * WAKE_FETCH_MAX_S);
+    CHECK(wake_policy_sleep_us() == WAKE_FETCH_MAX_S * 1000000ULL, "联网时间超过最长推迟");
+    CHECK(wake(ESP_SLEEP_WAKEUP_TIMER, T0 + 1) == WAKE_ACTION_LOCAL, "最长推迟时定时唤醒却联网");
+
+    // 本地刷新时间更早时按它睡眠，没有或更晚时不影响
+    fake_now = T0;
+    wake_policy_fetch_done(T0 + 7200);
+    register_wake_local_deadline_callback(next_deadline);
+    deadline = T0 + 900;
+    CHECK(wake_policy_sleep_us() == 900 * 1000000ULL, "本地刷新时间 900 秒后却睡眠 %llu us",
+          (unsigned long long)wake_policy_sleep_us());
+    deadline = T0 + 9000;
+    CHECK(wake_policy_sleep_us() == 7200 * 1000000ULL, "更晚的本地刷新时间推迟了联网");
+    deadline = 0;
+    CHECK(wake_policy_sleep_us() == 7200 * 1000000ULL, "没有本地刷新时间时睡眠时长不对");
+
+    // 本地刷新时间已经过去，至少睡 1 秒
+    deadline = T0 - 5;
+    CHECK(wake_policy_sleep_us() == 1000000ULL, "到期时间已过时睡眠 %llu us", (unsigned long long)wake_policy_sleep_us());
+    register_wake_local_deadline_callback(NULL);
+}
+
+int main(void) {
+    freopen("/dev/null", "w", stderr);          // 改为联网时有警告，这里只看检查结果
+    test_first_boot();
+    test_timer_wakes();
+    test_run_local();
+    test_sleep();
+    return check_report();
+}
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+把 TTF/OTF 或 BDF 字体编译成设备 flash 字库分区的二进制文件，格式见 main/display/font_store.h
+
+    文件头    64 字节
+    码点索引  glyph_count 个 uint32，按码点升序
+    点阵      glyph_count 个字模，每个 glyph_bytes 字节
+
+用法示例：
+    # 24 点阵 GB2312 字库，给中景园 3.52 寸屏
+    python tools/font_compiler.py font.ttf --size 24 --gb2312 --ascii \\
+        --layout rows --model zjy_3.52_4colors -o font.bin
+    # BDF 点阵字体，字符集来自文本文件
+    python tools/font_compiler.py wenquanyi_12pt.bdf --size 16 --charset chars.txt \\
+        --layout columns --model qy_2.9_2colors -o font.bin
+    # 写入 font 分区
+    parttool.py write_partition --partition-name font --input font.bin
+
+TTF/OTF 需要 Pillow（pip install pillow），BDF 不需要第三方库。
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31465045          # "EPF1"
+VERSION = 1
+HEADER_SIZE = 64
+HEADER_FMT = '<IHHIIIIIHBBB3x28s'
+LAYOUT_ROWS = 0             # 逐行，高位在左，1 为前景，行间不补齐
+LAYOUT_COLUMNS = 1          # 逐列，每列 height/8 字节，高位在上，0 为前景
+
+assert struct.calcsize(HEADER_FMT) == HEADER_SIZE
+
+
+# ---------------------------------------------------------------- 字符集
+
+def gb2312_chars():
+    """GB2312 一、二级汉字和全角符号"""
+    chars = []
+    for hi in range(0xA1, 0xF8):
+        for lo in range(0xA1, 0xFF):
+            try:
+                chars.append(bytes((hi, lo)).decode('gb2312'))
+            except UnicodeDecodeError:
+                pass
+    return chars
+
+
+def build_charset(args):
+    codepoints = set()
+    if args.ascii:
+        codepoints.update(range(0x21, 0x7F))
+    if args.gb2312:
+        codepoints.update(ord(c) for c in gb2312_chars())
+    for path in args.charset or []:
+        with open(path, encoding='utf-8') as f:
+            codepoints.update(ord(c) for c in f.read() if not c.isspace())
+    return sorted(codepoints)
+
+
+# ---------------------------------------------------------------- 字形来源，返回 size×size 的 0/1 像素行，没有该字返回 None
+
+class BdfSource:
+    """BDF 点阵字体，按 FONT_ASCENT 把基线放在单元格内，不缩放"""
+
+    def __init__(self, path, size):
+        self.size = size
+        self.glyphs = {}
+        ascent = None
+        with open(path, encoding='latin-1') as f:
+            lines = iter(f.read().splitlines())
+        for line in lines:
+            key = line.split(' ', 1)[0]
+            if key == 'FONT_ASCENT':
+                ascent = int(line.split()[1])
+            elif key == 'STARTCHAR':
+                self._read_char(lines)
+        self.ascent = ascent if ascent is not None else size
+
+    def _read_char(self, lines):
+        code, bbx, rows = -1, (0, 0, 0, 0), []
+        for line in lines:
+            key = line.split(' ', 1)[0]
+            if key == 'ENCODING':
+                code = int(line.split()[1])
+            elif key == 'BBX':
+                bbx = tuple(int(v) for v in line.split()[1:5])
+            elif key == 'BITMAP':
+                for row in lines:
+                    if row.startswith('ENDCHAR'):
+                        break
+                    rows.append(row.strip())
+                break
+        if code >= 0:
+            self.glyphs[code] = (bbx, rows)
+
+    def render(self, cp):
+        if cp not in self.glyphs:
+            return None
+        (w, h, xoff, yoff), rows = self.glyphs[cp]
+        cell = [[0] * self.size for _ in range(self.size)]
+        top = self.ascent - (h + yoff)
+        for r, hexrow in enumerate(rows[:h]):
+            bits = int(hexrow, 16) if hexrow else 0
+            nbits = len(hexrow) * 4
+            for c in range(w):
+                x, y = xoff + c, top + r
+                if 0 <= x < self.size and 0 <= y < self.size and bits >> (nbits - 1 - c) & 1:
+                    cell[y][x] = 1
+        return cell
+
+
+class TtfSource:
+    """TTF/OTF 矢量字体，用 Pillow 按字号渲染后二值化，基线按字体的上下伸比例放在单元格内"""
+
+    def __init__(self, path, size, threshold):
+        try:
+            from PIL import Image, ImageDraw, ImageFont
+        except ImportError:
+            sys.exit('font_compiler: TTF/OTF needs Pillow (pip install pillow)')
+        self.Image, self.ImageDraw = Image, ImageDraw
+        self.size = size
+        self.threshold = threshold
+        self.font = ImageFont.truetype(path, size)
+        ascent, descent = self.font.getmetrics()
+        self.baseline = round(size * ascent / (ascent + descent))   # 上下伸之和常大于字号，按比例缩到单元格内
+        self.notdef = self._mask(chr(0x10FFFF))      # 字体里没有的字会画成 .notdef，与它相同就当作没有
+
+    def _mask(self, ch):
+        img = self.Image.new('L', (self.size, self.size), 0)
+        self.ImageDraw.Draw(img).text((0, self.baseline), ch, font=self.font, fill=255, anchor='ls')
+        return img.tobytes()
+
+    def render(self, cp):
+        data = self._mask(chr(cp))
+        if data == self.notdef or not any(data):
+            return None
+        return [[1 if data[y * self.size + x] >= self.threshold else 0 for x in range(self.size)]
+                for y in range(self.size)]
+
+
+# ---------------------------------------------------------------- 点阵打包
+
+def pack_rows(cell, size):
+    out, acc, n = bytearray(), 0, 0
+    for row in cell:
+        for bit in row:
+            acc = (acc << 1) | bit
+            n += 1
+            if n == 8:
+                out.append(acc)
+                acc, n = 0, 0
+    if n:
+        out.append(acc << (8 - n))
+    return bytes(out)
+
+
+def pack_columns(cell, size):
+    out = bytearray()
+    for x in range(size):
+        for y0 in range(0, size, 8):
+            b = 0
+            for y in range(y0, y0 + 8):
+                b = (b << 1) | (0 if cell[y][x] else 1)    # 控制器RAM 0 为黑
+            out.append(b)
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='compile a TTF/OTF/BDF font into the flash font store format')
+    ap.add_argument('font', help='.ttf/.otf/.ttc or .bdf')
+    ap.add_argument('--size', type=int, required=True, help='glyph cell size in pixels (square)')
+    ap.add_argument('--layout', choices=('rows', 'columns'), required=True,
+                    help='rows: zjy_3.52_4colors, columns: qy_2.9_2colors')
+    ap.add_argument('--model', required=True, help='screen_model the bitmaps are for')
+    ap.add_argument('--charset', action='append', help='UTF-8 text file, every character in it is included')
+    ap.add_argument('--gb2312', action='store_true', help='include all GB2312 characters')
+    ap.add_argument('--ascii', action='store_true', help='include printable ASCII')
+    ap.add_argument('--threshold', type=int, default=128, help='TTF binarize threshold 1..255')
+    ap.add_argument('-o', '--output', required=True)
+    args = ap.parse_args()
+
+    if not 8 <= args.size <= 255:
+        sys.exit('font_compiler: --size must be 8..255')
+    if args.layout == 'columns' and args.size % 8:
+        sys.exit('font_compiler: columns layout needs --size multiple of 8')
+    if len(args.model.encode()) >= 28:
+        sys.exit('font_compiler: --model longer than 27 bytes')
+
+    if args.font.lower().endswith('.bdf'):
+        source = BdfSource(args.font, args.size)
+    else:
+        source = TtfSource(args.font, args.size, args.threshold)
+
+    if args.layout == 'rows':
+        layout, pack = LAYOUT_ROWS, pack_rows
+        glyph_bytes = (args.size * args.size + 7) // 8
+    else:
+        layout, pack = LAYOUT_COLUMNS, pack_columns
+        glyph_bytes = args.size * args.size // 8
+
+    index, bitmaps, missing = bytearray(), bytearray(), 0
+    for cp in build_charset(args):
+        cell = source.render(cp)
+        if cell is None:
+            missing += 1
+            continue
+        index += struct.pack('<I', cp)
+        bitmaps += pack(cell, args.size)
+    count = len(index) // 4
+    if count == 0:
+        sys.exit('font_compiler: no glyphs, check --charset/--gb2312/--ascii and the font')
+
+    index_offset = HEADER_SIZE
+    bitmap_offset = index_offset + len(index)
+    total = bitmap_offset + len(bitmaps)
+    font_id = zlib.crc32(bytes(index) + bytes(bitmaps)) & 0xFFFFFFFF
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, HEADER_SIZE, count, index_offset, bitmap_offset,
+                         total, font_id, glyph_bytes, args.size, args.size, layout, args.model.encode())
+    with open(args.output, 'wb') as f:
+        f.write(header + index + bitmaps)
+    print('%s: %d glyphs (%d missing), %dx%d, %d bytes, font_id %08X'
+          % (args.output, count, missing, args.size, args.size, total, font_id))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+语录服务器的本地替身，用于联调设备的请求和两种响应格式
+
+    请求 Accept 里有 application/x-epaper-quote 时返回二进制语录（格式见 main/quote_fetcher/quote_payload.h），
+    否则返回原来的 JSON（点阵是十进制数字数组）。
+    请求头 X-Glyph-Cache（格式见 main/display/glyph_cache.h）里已缓存的字、
+    以及 ?font= 与 --font-bin 的字库 ID 相同时字库里有的字，都不下发点阵：
+    二进制里标记 QUOTE_GLYPH_NO_BITMAP，JSON 里为 null。
+    响应带弱 ETag（屏幕型号、字号和语录文本的 CRC32，与响应格式和省略了哪些字无关），
+    请求的 If-None-Match 与它相同时返回 304，没有响应体。
+    --chunked 时按 Transfer-Encoding: chunked 分块发送，块大小随机，模拟默认分块的反向代理。
+    请求带 batch=N 且 Accept 里有 application/x-epaper-batch 时返回批量响应：N 屏二进制语录，
+    依次轮换 --quote（可以给多次），第 i 屏在 i*--batch-interval 秒后显示；批量响应不带 ETag，也不返回 304。
+
+用法示例：
+    python tools/quote_server.py /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf --size 24 \\
+        --quote "Stay hungry, stay foolish." --port 8080
+    # 只生成一次响应写到文件，不启动服务器；加 --dump-batch N 时写批量响应
+    python tools/quote_server.py font.ttf --size 24 --quote "..." --dump quote.bin
+
+TTF/OTF 需要 Pillow，字形渲染和点阵打包与 tools/font_compiler.py 相同。
+"""
+
+import argparse
+import base64
+import json
+import os
+import random
+import struct
+import sys
+import zlib
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from urllib.parse import parse_qs, urlparse
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import font_compiler    # noqa: E402
+
+PAYLOAD_MIME = 'application/x-epaper-quote'
+PAYLOAD_MAGIC = 0x31515045      # "EPQ1"
+PAYLOAD_VERSION = 1
+PAYLOAD_HEADER_FMT = '<IBBHHHB3x'
+BATCH_MIME = 'application/x-epaper-batch'
+BATCH_MAGIC = 0x31425045        # "EPB1"
+BATCH_VERSION = 1
+BATCH_HEADER_FMT = '<IBBH'
+BATCH_ENTRY_FMT = '<II'
+BATCH_MAX = 16                  # 设备的 SCREEN_RING_MAX
+GLYPH_NO_BITMAP = 0x0001
+
+# 屏幕型号 → (宽, 高, 点阵打包方式)
+PANELS = {
+    'zjy_3.52_4colors': (384, 180, 'rows'),
+    'qy_2.9_2colors': (296, 128, 'columns'),
+}
+
+assert struct.calcsize(PAYLOAD_HEADER_FMT) == 16
+assert struct.calcsize(BATCH_HEADER_FMT) == 8 and struct.calcsize(BATCH_ENTRY_FMT) == 8
+
+
+# ---------------------------------------------------------------- 设备上已有的字
+
+def fnv1a32(data):
+    h = 0x811C9DC5
+    for b in data:
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+class GlyphBloom:
+    """解析 X-Glyph-Cache 请求头，哈希方式与 glyph_cache_summary 相同"""
+
+    def __init__(self, value):
+        fields = value.split(';', 2)
+        if len(fields) != 3 or not fields[0].startswith('k=') or not fields[1].startswith('m='):
+            raise ValueError('bad X-Glyph-Cache')
+        self.k = int(fields[0][2:])
+        self.m = int(fields[1][2:])
+        self.bits = base64.b64decode(fields[2])
+        if self.m <= 0 or len(self.bits) * 8 < self.m:
+            raise ValueError('bad X-Glyph-Cache')
+
+    def __contains__(self, key):
+        h1 = fnv1a32(struct.pack('<I', key))
+        h2 = ((h1 >> 17) | (h1 << 15)) & 0xFFFFFFFF | 1
+        for j in range(self.k):
+            bit = ((h1 + j * h2) & 0xFFFFFFFF) % self.m
+            if not self.bits[bit // 8] >> (bit % 8) & 1:
+                return False
+        return True
+
+
+def load_font_bin(path):
+    """读 font_compiler 生成的字库，返回 (font_id, 字号, 屏幕型号, 码点集合)"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    fields = struct.unpack_from(font_compiler.HEADER_FMT, data)
+    count, index_offset, font_id, height = fields[3], fields[4], fields[7], fields[10]
+    model = fields[12].rstrip(b'\0').decode()
+    codepoints = set(struct.unpack_from('<%dI' % count, data, index_offset))
+    return font_id, height, model, codepoints
+
+
+# ---------------------------------------------------------------- 排版和编码
+
+class QuoteBuilder:
+    def __init__(self, args):
+        self.size = args.size
+        self.model = args.model
+        self.width, self.height, layout = PANELS[args.model]
+        self.pack = font_compiler.pack_rows if layout == 'rows' else font_compiler.pack_columns
+        if args.font.lower().endswith('.bdf'):
+            self.source = font_compiler.BdfSource(args.font, args.size)
+        else:
+            self.source = font_compiler.TtfSource(args.font, args.size, args.threshold)
+        self.font_bin = load_font_bin(args.font_bin) if args.font_bin else None
+
+    def bitmap(self, ch):
+        cell = self.source.render(ord(ch)) if not ch.isspace() else None
+        if cell is None:
+            cell = [[0] * self.size for _ in range(self.size)]
+        return self.pack(cell, self.size)
+
+    def layout(self, quote):
+        """每个字符一个方格，按屏宽折行，整体居中；返回 (字模字符列表, 位置列表)"""
+        per_line = max(1, self.width // self.size)
+        lines = (len(quote) + per_line - 1) // per_line
+        top = max(0, (self.height - lines * self.size) // 2)
+        chars, index, positions = [], {}, []
+        for i, ch in enumerate(quote):
+            if ch not in index:
+                index[ch] = len(chars)
+                chars.append(ch)
+            row, col = divmod(i, per_line)
+            n = min(per_line, len(quote) - row * per_line)
+            left = (self.width - n * self.size) // 2
+            positions.append((index[ch], left + col * self.size, top + row * self.size))
+        return chars, positions
+
+    def on_device(self, ch, bloom, font_id):
+        cp = ord(ch)
+        if bloom is not None and (cp | self.size << 24) in bloom:
+            return True
+        if self.font_bin and font_id == self.font_bin[0] and (self.size, self.model) == self.font_bin[1:3]:
+            return cp in self.font_bin[3]
+        return False
+
+    def build_binary(self, quote, bloom=None, font_id=None):
+        chars, positions = self.layout(quote)
+        model, text = self.model.encode() + b'\0', quote.encode() + b'\0'
+        table, bitmaps = bytearray(), bytearray()
+        for ch in chars:
+            flags = GLYPH_NO_BITMAP if self.on_device(ch, bloom, font_id) else 0
+            table += struct.pack('<IBBH', ord(ch), self.size, self.size, flags)
+            if not flags:
+                bitmaps += self.bitmap(ch)
+        places = b''.join(struct.pack('<Hhh', *p) for p in positions)
+        header = struct.pack(PAYLOAD_HEADER_FMT, PAYLOAD_MAGIC, PAYLOAD_VERSION, self.size,
+                             len(chars), len(positions), len(text), len(model))
+        return header + model + text + bytes(table) + places + bytes(bitmaps)
+
+    def build_batch(self, quotes, count, interval, bloom=None, font_id=None):
+        """count 屏，轮换 quotes，第 i 屏在 i*interval 秒后显示"""
+        body = bytearray(struct.pack(BATCH_HEADER_FMT, BATCH_MAGIC, BATCH_VERSION, count, 0))
+        for i in range(count):
+            screen = self.build_binary(quotes[i % len(quotes)], bloom, font_id)
+            body += struct.pack(BATCH_ENTRY_FMT, i * interval, len(screen)) + screen
+        return bytes(body)
+
+    def etag(self, quote):
+        """内容相同 ETag 就相同，二进制和 JSON、省略了哪些点阵都只是同一内容的不同表示，所以是弱 ETag"""
+        key = ('%s\0%d\0%s' % (self.model, self.size, quote)).encode()
+        return 'W/"%08x"' % (zlib.crc32(key) & 0xFFFFFFFF)
+
+    def build_json(self, quote, bloom=None, font_id=None):
+        chars, positions = self.layout(quote)
+        bitmaps = {ch: None if self.on_device(ch, bloom, font_id) else list(self.bitmap(ch)) for ch in chars}
+        doc = {
+            'quote': quote,
+            'screen_model': self.model,
+            'fontsize': self.size,
+            'bitmaps': bitmaps,
+            'positions': [{'index': i, 'x': x, 'y': y} for i, x, y in positions],
+        }
+        return json.dumps(doc, ensure_ascii=False, separators=(',', ':')).encode()
+
+
+# ---------------------------------------------------------------- HTTP
+
+def make_handler(builder, quotes, args):
+    quote, chunked = quotes[0], args.chunked
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = 'HTTP/1.1'
+
+        def do_GET(self):
+            query = parse_qs(urlparse(self.path).query)
+            batch = 0
+            if 'batch' in query and BATCH_MIME in self.headers.get('Accept', ''):
+                batch = max(1, min(int(query['batch'][0]), BATCH_MAX))
+            etag = builder.etag(quote)
+            # If-None-Match 按弱比较，去掉 W/ 前缀后比较；批量响应的内容随时间表变化，不返回 304
+            tags = [t.strip() for t in self.headers.get('If-None-Match', '').split(',')]
+            if not batch and ('*' in tags or etag[2:] in [t[2:] if t.startswith('W/') else t for t in tags]):
+                self.send_response(304)
+                self.send_header('ETag', etag)
+                self.end_headers()
+                return
+            font_id = int(query['font'][0], 16) if 'font' in query else None
+            bloom = None
+            if self.headers.get('X-Glyph-Cache'):
+                try:
+                    bloom = GlyphBloom(self.headers['X-Glyph-Cache'])
+                except ValueError:
+                    self.send_error(400, 'bad X-Glyph-Cache')
+                    return
+            if batch:
+                body, mime = builder.build_batch(quotes, batch, args.batch_interval, bloom, font_id), BATCH_MIME
+            elif PAYLOAD_MIME in self.headers.get('Accept', ''):
+                body, mime = builder.build_binary(quote, bloom, font_id), PAYLOAD_MIME
+            else:
+                body, mime = builder.build_json(quote, bloom, font_id), 'application/json; charset=utf-8'
+            self.send_response(200)
+            self.send_header('Content-Type', mime)
+            if not batch:
+                self.send_header('ETag', etag)
+            if not chunked:
+                self.send_header('Content-Length', str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+                return
+            # 块大小随机，块边界会落在文件头、表项和点阵中间
+            self.send_header('Transfer-Encoding', 'chunked')
+            self.end_headers()
+            pos = 0
+            while pos < len(body):
+                n = random.randint(1, chunked)
+                self.wfile.write(b'%X\r\n' % len(body[pos:pos + n]) + body[pos:pos + n] + b'\r\n')
+                pos += n
+            self.wfile.write(b'0\r\n\r\n')
+
+    return Handler
+
+
+def main():
+    ap = argparse.ArgumentParser(description='stand-in quote server speaking the JSON and binary payload formats')
+    ap.add_argument('font', help='.ttf/.otf/.ttc or .bdf used to render glyphs')
+    ap.add_argument('--size', type=int, default=24, help='glyph cell size in pixels')
+    ap.add_argument('--model', choices=sorted(PANELS), default='zjy_3.52_4colors')
+    ap.add_argument('--quote', required=True, action='append',
+                    help='quote text; give several times to rotate them in batch responses')
+    ap.add_argument('--batch-interval', type=int, default=3600, metavar='SECONDS',
+                    help='display interval between screens of a batch response')
+    ap.add_argument('--font-bin', help='font store image on the device; its glyphs are not sent when ?font= matches')
+    ap.add_argument('--threshold', type=int, default=128, help='TTF binarize threshold 1..255')
+    ap.add_argument('--port', type=int, default=8080)
+    ap.add_argument('--chunked', type=int, metavar='MAX', default=0,
+                    help='send Transfer-Encoding: chunked with random chunk sizes up to MAX bytes')
+    ap.add_argument('--dump', help='write one binary response to this file and exit')
+    ap.add_argument('--dump-batch', type=int, metavar='N', default=0, help='with --dump, write an N-screen batch response')
+    args = ap.parse_args()
+
+    if PANELS[args.model][2] == 'columns' and args.size % 8:
+        sys.exit('quote_server: %s needs --size multiple of 8' % args.model)
+    builder = QuoteBuilder(args)
+    if args.dump:
+        with open(args.dump, 'wb') as f:
+            if args.dump_batch:
+                f.write(builder.build_batch(args.quote, args.dump_batch, args.batch_interval))
+            else:
+                f.write(builder.build_binary(args.quote[0]))
+        return
+    print('serving on port %d' % args.port)
+    HTTPServer(('', args.port), make_handler(builder, args.quote, args)).serve_forever()
+
+
+if __name__ == '__main__':
+    main()